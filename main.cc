@@ -2,11 +2,135 @@
 #include <getopt.h>
 #include <cstdio>
 #include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <fstream>
+#include <set>
+#include <thread>
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
 #include "pm3/pm3.hh"
-
-void dump_gamea();
-
-void dump_gamea_manager(int player = 0);
+#include "pm3/schema.hh"
+#include "pm3/match.hh"
+#include "pm3/calendar.hh"
+#include "pm3/standings.hh"
+#include "pm3/journal.hh"
+#include "pm3/edit.hh"
+#include "pm3/transform.hh"
+#include "pm3/boost.hh"
+#include "pm3/lineup.hh"
+#include "pm3/shortlist.hh"
+#include "pm3/season.hh"
+#include "pm3/cup.hh"
+#include "pm3/finance.hh"
+#include "pm3/diff.hh"
+#include "pm3/delta.hh"
+#include "pm3/snapshot.hh"
+#include "pm3/save_hash.hh"
+#include "pm3/sidecar.hh"
+#include "pm3/fleet.hh"
+#include "pm3/watch.hh"
+#include "pm3/server.hh"
+#include "pm3/pack.hh"
+
+enum gamea_section {
+    GAMEA_CLUBS     = 1 << 0,
+    GAMEA_TABLES    = 1 << 1,
+    GAMEA_SCORERS   = 1 << 2,
+    GAMEA_REFEREES  = 1 << 3,
+    GAMEA_CUPS      = 1 << 4,
+    GAMEA_HISTORY   = 1 << 5,
+    GAMEA_FIXTURES  = 1 << 6,
+    GAMEA_TRANSFERS = 1 << 7,
+    GAMEA_NEWS      = 1 << 8,
+    GAMEA_DATE      = 1 << 9,
+    GAMEA_MANAGER   = 1 << 10,
+    GAMEA_MISC      = 1 << 11,
+    GAMEA_RAW       = 1 << 12, /* hex dumps of the unknown dataNNN blocks */
+    GAMEA_ALL       = (1 << 13) - 1
+};
+
+enum player_field {
+    PLAYER_NAME     = 1 << 0,
+    PLAYER_AGE      = 1 << 1,
+    PLAYER_WAGE     = 1 << 2,
+    PLAYER_INS      = 1 << 3,
+    PLAYER_HN       = 1 << 4,
+    PLAYER_TK       = 1 << 5,
+    PLAYER_PS       = 1 << 6,
+    PLAYER_SH       = 1 << 7,
+    PLAYER_HD       = 1 << 8,
+    PLAYER_CR       = 1 << 9,
+    PLAYER_FT       = 1 << 10,
+    PLAYER_AGGR     = 1 << 11,
+    PLAYER_MORL     = 1 << 12,
+    PLAYER_FOOT     = 1 << 13,
+    PLAYER_PLAYED   = 1 << 14,
+    PLAYER_SCORED   = 1 << 15,
+    PLAYER_DPTS     = 1 << 16,
+    PLAYER_TRAIN    = 1 << 17,
+    PLAYER_CONTRACT = 1 << 18,
+    PLAYER_UNKNOWN  = 1 << 19,
+    PLAYER_PERIOD   = 1 << 20,
+    PLAYER_ALL      = (1 << 21) - 1
+};
+
+struct selection_name {
+    const char *name;
+    unsigned bits;
+};
+
+static const struct selection_name gamea_sections[] = {
+        {"clubs",     GAMEA_CLUBS},
+        {"tables",    GAMEA_TABLES},
+        {"scorers",   GAMEA_SCORERS},
+        {"referees",  GAMEA_REFEREES},
+        {"cups",      GAMEA_CUPS},
+        {"history",   GAMEA_HISTORY},
+        {"fixtures",  GAMEA_FIXTURES},
+        {"transfers", GAMEA_TRANSFERS},
+        {"news",      GAMEA_NEWS},
+        {"date",      GAMEA_DATE},
+        {"manager",   GAMEA_MANAGER},
+        {"misc",      GAMEA_MISC},
+        {"raw",       GAMEA_RAW},
+        {"all",       GAMEA_ALL},
+        {nullptr,     0}
+};
+
+static const struct selection_name player_fields[] = {
+        {"name",     PLAYER_NAME},
+        {"age",      PLAYER_AGE},
+        {"wage",     PLAYER_WAGE},
+        {"ins",      PLAYER_INS},
+        {"hn",       PLAYER_HN},
+        {"tk",       PLAYER_TK},
+        {"ps",       PLAYER_PS},
+        {"sh",       PLAYER_SH},
+        {"hd",       PLAYER_HD},
+        {"cr",       PLAYER_CR},
+        {"ft",       PLAYER_FT},
+        {"aggr",     PLAYER_AGGR},
+        {"morl",     PLAYER_MORL},
+        {"foot",     PLAYER_FOOT},
+        {"played",   PLAYER_PLAYED},
+        {"scored",   PLAYER_SCORED},
+        {"dpts",     PLAYER_DPTS},
+        {"train",    PLAYER_TRAIN},
+        {"contract", PLAYER_CONTRACT},
+        {"unknown",  PLAYER_UNKNOWN},
+        {"period",   PLAYER_PERIOD},
+        {"all",      PLAYER_ALL},
+        {nullptr,    0}
+};
+
+bool parse_selection(const char *list, const struct selection_name *names, unsigned &selection);
+
+void dump_gamea(unsigned sections = GAMEA_ALL);
+
+void dump_gamea_manager(int player = 0, unsigned sections = GAMEA_ALL);
 
 void dump_gamea_match_summary();
 
@@ -18,26 +142,100 @@ void dump_club(struct gameb::club &club);
 
 void print_club_name(int16_t idx, bool newline = true);
 
-void dump_gamec();
+void dump_gamec(unsigned fields = PLAYER_ALL);
 
-void dump_player(struct gamec::player &player);
+void dump_player(struct gamec::player &player, unsigned fields = PLAYER_ALL);
 
 void print_player_name(int16_t idx, bool newline = true);
 
-void print_player_row(struct club_player &club_player);
+void print_player_row(struct club_player &club_player, FILE *out = stdout);
+
+void print_player_row(struct gamec::player &p, struct gameb::club &club, FILE *out = stdout);
+
+void print_player_row_header(FILE *out = stdout);
+
+void soup_up(int player = 0, const struct boost_profile &profile = boost_profiles[0],
+             position_source positions = POSITIONS_SLOT, edit_journal *journal = nullptr);
+
+void print_boost_summary(const struct boost_summary &summary);
+
+void dump_free_players(FILE *out = stdout);
+
+void dump_match_stats(const match_stats &stats);
 
-void print_player_row(struct gamec::player &p, struct gameb::club &club);
+void print_fixture(const struct fixture &f);
 
-void print_player_row_header();
+void dump_standings(const standings &tables, const std::vector<struct table_mismatch> &mismatches,
+                    FILE *out = stdout);
 
-void soup_up(int player = 0);
+void dump_lineup(const struct lineup &l, const struct formation &f);
 
-void dump_free_players();
+void dump_strength(const struct formation &f);
+
+void dump_shortlist(const struct shortlist &plan, const struct formation &f, int64_t budget);
+
+void dump_season_odds(const season_simulator &simulator, const struct season_odds &odds);
+void dump_cup(const struct cup_bracket &bracket);
+void dump_finance(const struct finance_projection &p, const struct attendance_model &model, int low, int high, int threads);
+void dump_attendance_fit(const struct attendance_fit &fit);
+void dump_cup_odds(const struct cup_bracket &bracket, const struct cup_odds &odds);
+void dump_save_hashes(const struct save_hashes &hashes);
+void dump_players(const std::vector<int16_t> &players, const save_index &index, const struct field_desc *field);
+void dump_validation(FILE *out = stdout);
+
+template <typename T>
+void export_records(const T *records, int count);
+
+int apply_main(char *command, int argc, char *argv[]);
+int diff_main(char *command, int argc, char *argv[]);
+int delta_main(char *command, int argc, char *argv[]);
+int patch_main(char *command, int argc, char *argv[]);
+int snapshot_main(char *command, int argc, char *argv[]);
+int fleet_main(char *command, int argc, char *argv[]);
+int watch_main(char *command, int argc, char *argv[]);
+int serve_main(char *command, int argc, char *argv[]);
+int shell_main(char *command, int argc, char *argv[]);
+int pack_main(char *command, int argc, char *argv[]);
 
 pm3_game_type game_type;
 
+static const char *timetable_match_type[] = {
+        "0",
+        "1",
+        "Division 2 match",
+        "Division 3 match",
+        "Conference match",
+        "5",
+        "6",
+        "Division 2 delay",
+        "Division 3 delay",
+        "Conference delay",
+        "F.A. cup match",
+        "League cup match",
+        "12",
+        "Cup winners cup",
+        "14",
+        "Charity shield",
+        "16",
+        "17",
+        "18",
+        "Friendly",
+        "20", "21", "22", "23", "24", "25",
+        "26", "27", "28", "29", "30", "31"
+};
+
 void print_help(char *command) {
-    fprintf(stderr, "Usage: %s -[abc] -g 1-8 [-f] [-t 0-113] [-l] [-s] [-h] /path/to/pm3/\n", command);
+    fprintf(stderr, "Usage: %s -[abc] -g 1-8 [-f] [-t 0-113] [-l] [-s] [-h] /path/to/pm3/ [/path/to/pm3/ ...]\n", command);
+    fprintf(stderr, "       %s apply -g 1-8 [-g 1-8 ...] [--threads=N] edits.txt|- /path/to/pm3/ [/path/to/pm3/ ...]\n", command);
+    fprintf(stderr, "       %s diff [--json] SAVE SAVE\n", command);
+    fprintf(stderr, "       %s delta [-o FILE] SAVE SAVE [SAVE ...]\n", command);
+    fprintf(stderr, "       %s patch [-n COUNT] -o SAVE SAVE DELTA|- [DELTA ...]\n", command);
+    fprintf(stderr, "       %s snapshot [--store=DIR] add SAVE [SAVE ...] | list | restore ID SAVE\n", command);
+    fprintf(stderr, "       %s fleet --report=NAME [--cache=DIR] /path/to/pm3/ [/path/to/pm3/ ...]\n", command);
+    fprintf(stderr, "       %s watch [--socket=PATH] ROOT [ROOT ...]\n", command);
+    fprintf(stderr, "       %s serve --socket=PATH [PATH:1-8 ...]\n", command);
+    fprintf(stderr, "       %s shell -g 1-8 /path/to/pm3/\n", command);
+    fprintf(stderr, "       %s pack -o FILE /path/to/pm3/ [/path/to/pm3/ ...] | --list FILE\n", command);
     fprintf(stderr, "\n");
     fprintf(stderr, "  -[abc]\n");
     fprintf(stderr, "    Dump game[abc]\n");
@@ -45,10 +243,89 @@ void print_help(char *command) {
     fprintf(stderr, "  -g 1-8, --game=1-8\n");
     fprintf(stderr, "    Which savegame to work on\n");
     fprintf(stderr, "\n");
+    fprintf(stderr, "  --sections=tables,cups,manager,...\n");
+    fprintf(stderr, "    Only dump these sections of game[a]: clubs, tables, scorers,\n");
+    fprintf(stderr, "      referees, cups, history, fixtures, transfers, news, date,\n");
+    fprintf(stderr, "      manager, misc, raw (hex dumps of unknown data)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --fields=name,hn,tk,ps,sh,age,wage,...\n");
+    fprintf(stderr, "    Only dump these fields of each player in game[c]: name, age,\n");
+    fprintf(stderr, "      wage, ins, hn, tk, ps, sh, hd, cr, ft, aggr, morl, foot,\n");
+    fprintf(stderr, "      played, scored, dpts, train, contract, unknown, period\n");
+    fprintf(stderr, "\n");
     fprintf(stderr, "  --club[=0..243]\n");
     fprintf(stderr, "    Dump information on a single club within a savegame\n");
     fprintf(stderr, "      (defaults to the club of player0, if index not provided)\n");
     fprintf(stderr, "\n");
+    fprintf(stderr, "  --fixtures[=0..243]\n");
+    fprintf(stderr, "    Print the remaining fixtures of a club\n");
+    fprintf(stderr, "      (defaults to the club of player0, if index not provided)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --week=1-41\n");
+    fprintf(stderr, "    Print all matches of a week\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --lineup[=0..243]\n");
+    fprintf(stderr, "    Pick the best available eleven and three substitutes of a club\n");
+    fprintf(stderr, "      (defaults to the club of player0, if index not provided)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --shortlist[=0..113]\n");
+    fprintf(stderr, "    Find the signings from the transfer market and out of contract\n");
+    fprintf(stderr, "      players that raise lineup strength most within the budget\n");
+    fprintf(stderr, "      (defaults to the club of player0, if index not provided)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --budget=AMOUNT\n");
+    fprintf(stderr, "    Budget for --shortlist, fees plus wages to the end of the season\n");
+    fprintf(stderr, "      (defaults to the bank account of the club)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --strength\n");
+    fprintf(stderr, "    Rank the league clubs by the strength of their best eleven\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --formation=4-4-2\n");
+    fprintf(stderr, "    Formation for --lineup and --strength (default 4-4-2)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --simulate[=simulations]\n");
+    fprintf(stderr, "    Play out the rest of the league season (default 10000 times) and\n");
+    fprintf(stderr, "      print the title, promotion and relegation odds of every club\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --cups\n");
+    fprintf(stderr, "    Print the cup draws round by round, with results and winners\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --cup-odds[=simulations]\n");
+    fprintf(stderr, "    Play out the cups still running (default 10000 times) and print\n");
+    fprintf(stderr, "      the odds of every club reaching each round and winning\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --seed=N, --threads=N\n");
+    fprintf(stderr, "    Random seed and number of threads for --simulate and --cup-odds\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --finance[=0-1]\n");
+    fprintf(stderr, "    Project the bank balance of a manager's club to the end of the\n");
+    fprintf(stderr, "      season, and the balance at every pair of league ticket prices\n");
+    fprintf(stderr, "      (defaults to player0, if manager not provided)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --prices=LOW-HIGH\n");
+    fprintf(stderr, "    Range of seating and terrace prices for --finance (default 1-60)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --fit-attendance\n");
+    fprintf(stderr, "    Fit the attendance model to the history of every savegame of\n");
+    fprintf(stderr, "      every given path, and use it for --finance\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --standings\n");
+    fprintf(stderr, "    Recompute the league tables from the timetables and check them\n");
+    fprintf(stderr, "      against the stored home/away table\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --hashes\n");
+    fprintf(stderr, "    Print the hash of every gamea block, manager, club and player\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --index\n");
+    fprintf(stderr, "    Write the indexes of the savegame to SAVES/GAMEn.IDX, which later\n");
+    fprintf(stderr, "      runs map instead of building them while the savegame is unchanged\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --find=NAME\n");
+    fprintf(stderr, "    Print the players whose name contains NAME, ignoring case\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --top=FIELD[:N]\n");
+    fprintf(stderr, "    Print the N players (default 20) with the highest FIELD, e.g. hn\n");
+    fprintf(stderr, "\n");
     fprintf(stderr, "  -f\n");
     fprintf(stderr, "    Print out free players\n");
     fprintf(stderr, "\n");
@@ -59,16 +336,135 @@ void print_help(char *command) {
     fprintf(stderr, "    Level aggression to 5 for all players in all teams\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "  -s\n");
-    fprintf(stderr, "    Maximize all values for team\n");
+    fprintf(stderr, "    Boost all players and staff of the team of player0\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --boost-club=0..243, --boost-division=0-4\n");
+    fprintf(stderr, "    Boost all players of a club, or of every club in a division\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --profile=max|strong|average|weak\n");
+    fprintf(stderr, "    Attribute targets of -s and --boost-* (default max)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --positions=slot|inferred\n");
+    fprintf(stderr, "    Take the role of each player from the squad slot (default) or\n");
+    fprintf(stderr, "      from the best of hn, tk, ps and sh\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --transform=hn+5,tk*1.1,aggr=5,ft:10-90,...\n");
+    fprintf(stderr, "    Add to, scale, set or clamp player fields\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --where=club=0..243,division=0-4,position=G|D|M|A,age=18-25,contract=0-1\n");
+    fprintf(stderr, "    Only transform the players matching all of these\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --journal=FILE\n");
+    fprintf(stderr, "    Record the changes made by -t, -l, -s, --boost-* and --transform to FILE\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --undo=FILE\n");
+    fprintf(stderr, "    Revert the changes recorded in FILE\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --replay=FILE\n");
+    fprintf(stderr, "    Apply the changes recorded in FILE to another savegame\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --export=players|clubs|managers\n");
+    fprintf(stderr, "    Print every field of the records as CSV\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  --match-stats\n");
+    fprintf(stderr, "    Sum up the lineup statistics of the last match of both managers\n");
+    fprintf(stderr, "      over the savegame of every given path\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "  -h\n");
     fprintf(stderr, "    Displays this help message\n");
     fprintf(stderr, "\n");
     fprintf(stderr, "  /path/to/pm3/\n");
     fprintf(stderr, "    Path to PM3\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  apply edits.txt|-\n");
+    fprintf(stderr, "    Apply an edit script (or stdin) to every given savegame of every\n");
+    fprintf(stderr, "      path, loading and saving each one once. One command per line:\n");
+    fprintf(stderr, "        player 0-3931 field value\n");
+    fprintf(stderr, "        club 0-243 field value\n");
+    fprintf(stderr, "        manager 0-1 field value\n");
+    fprintf(stderr, "        manager 0-1 club 0-113\n");
+    fprintf(stderr, "        bank 0-243 amount\n");
+    fprintf(stderr, "        move 0-3931 0-243 [0-23]\n");
+    fprintf(stderr, "        transform all|filter transforms (as --where and --transform)\n");
+    fprintf(stderr, "        boost club|division 0..243|0-4 [profile] [slot|inferred]\n");
+    fprintf(stderr, "      Nothing is saved if any command fails. Savegames are edited on N\n");
+    fprintf(stderr, "      threads at once (default one per core)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  diff [--json] SAVE SAVE\n");
+    fprintf(stderr, "    Print every field that differs between two savegames, each one\n");
+    fprintf(stderr, "      given as /path/to/pm3/:1-8 or as the prefix of its files, like\n");
+    fprintf(stderr, "      /path/to/pm3/SAVES/GAME1. Exits with 1 if they differ\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  delta [-o FILE] SAVE SAVE [SAVE ...]\n");
+    fprintf(stderr, "    Write the changes from each savegame to the next as a chain of\n");
+    fprintf(stderr, "      record by record deltas to FILE (or stdout)\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  patch [-n COUNT] -o SAVE SAVE DELTA|- [DELTA ...]\n");
+    fprintf(stderr, "    Apply the chains of deltas (or stdin) to a savegame in turn, or\n");
+    fprintf(stderr, "      only the first COUNT deltas, and save the result to SAVE\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  snapshot [--store=DIR] add SAVE [SAVE ...] | list | restore ID SAVE\n");
+    fprintf(stderr, "    Keep savegames in a store (default .pm3-snapshots) that holds each\n");
+    fprintf(stderr, "      distinct player, club, manager and table record once, list\n");
+    fprintf(stderr, "      them, or write one back to SAVE\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  fleet --report=free-players|standings|validation [--cache=DIR]\n");
+    fprintf(stderr, "    Run a report on every savegame of every path. Results are kept\n");
+    fprintf(stderr, "      in DIR (default .pm3-fleet) by the contents of each savegame,\n");
+    fprintf(stderr, "      and only savegames that changed since are read and run again.\n");
+    fprintf(stderr, "      Exits with 1 if any savegame could not be read\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  watch [--socket=PATH] ROOT [ROOT ...]\n");
+    fprintf(stderr, "    Watch the savegames of every install in or below ROOT and print\n");
+    fprintf(stderr, "      an event as a JSON line (or send it to every client of the\n");
+    fprintf(stderr, "      Unix socket PATH) for each save, transfer, free agent and\n");
+    fprintf(stderr, "      injury. Sidecar indexes of the savegames are kept up to date\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  serve --socket=PATH [PATH:1-8 ...]\n");
+    fprintf(stderr, "    Keep savegames in memory and answer the requests of clients of\n");
+    fprintf(stderr, "      the Unix socket PATH, one command per line: use PATH:1-8, saves,\n");
+    fprintf(stderr, "      info, player IDX [FIELD ...], club IDX [FIELD ...], find NAME,\n");
+    fprintf(stderr, "      top FIELD [N], players FILTER, diff PATH:1-8, edit COMMAND and\n");
+    fprintf(stderr, "      help. Each answer is a line OK LENGTH or ERR LENGTH and then\n");
+    fprintf(stderr, "      LENGTH bytes of output. Savegames are read again when the game\n");
+    fprintf(stderr, "      has written them\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  shell -g 1-8 /path/to/pm3/\n");
+    fprintf(stderr, "    Read a savegame once and run the commands of serve on it from\n");
+    fprintf(stderr, "      stdin, with game [FIELD ...], manager 0-1 [FIELD ...], player\n");
+    fprintf(stderr, "      NAME, free [--pos G|D|M|A], set COMMAND, diff-since-load and\n");
+    fprintf(stderr, "      commit besides. Edits stay in memory, and in the indexes, until\n");
+    fprintf(stderr, "      commit writes them to the savegame\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "  pack -o FILE /path/to/pm3/ [/path/to/pm3/ ...] | --list FILE\n");
+    fprintf(stderr, "    Write every savegame of every path into one corpus file, with the\n");
+    fprintf(stderr, "      gamea, gameb and gamec of all of them each in a page aligned\n");
+    fprintf(stderr, "      section of their own, so a scan of them is one sequential read;\n");
+    fprintf(stderr, "      or list the savegames of FILE with their SAVES.DIR entries\n");
 }
 
 int main(int argc, char *argv[]) {
+    if (argc > 1 && 0 == strcmp(argv[1], "apply"))
+        return apply_main(argv[0], argc - 1, argv + 1);
+    if (argc > 1 && 0 == strcmp(argv[1], "diff"))
+        return diff_main(argv[0], argc - 1, argv + 1);
+    if (argc > 1 && 0 == strcmp(argv[1], "delta"))
+        return delta_main(argv[0], argc - 1, argv + 1);
+    if (argc > 1 && 0 == strcmp(argv[1], "patch"))
+        return patch_main(argv[0], argc - 1, argv + 1);
+    if (argc > 1 && 0 == strcmp(argv[1], "snapshot"))
+        return snapshot_main(argv[0], argc - 1, argv + 1);
+    if (argc > 1 && 0 == strcmp(argv[1], "fleet"))
+        return fleet_main(argv[0], argc - 1, argv + 1);
+    if (argc > 1 && 0 == strcmp(argv[1], "watch"))
+        return watch_main(argv[0], argc - 1, argv + 1);
+    if (argc > 1 && 0 == strcmp(argv[1], "serve"))
+        return serve_main(argv[0], argc - 1, argv + 1);
+    if (argc > 1 && 0 == strcmp(argv[1], "shell"))
+        return shell_main(argv[0], argc - 1, argv + 1);
+    if (argc > 1 && 0 == strcmp(argv[1], "pack"))
+        return pack_main(argv[0], argc - 1, argv + 1);
+
     int c, optindex = 0;
     int help = 0;
     int opt_dump_gamea = 0,
@@ -76,27 +472,183 @@ int main(int argc, char *argv[]) {
         opt_dump_gamec = 0,
         opt_dump_free_players = 0,
         opt_level_aggression = 0,
+        opt_match_stats = 0,
+        opt_standings = 0,
+        opt_hashes = 0,
+        opt_index = 0,
         opt_verbose = 0;
 
     char *game_path = nullptr;
     int game_nr = -1, opt_soup_up = 0;
     int opt_new_club_idx = -1;
     int opt_club_idx = -2;
+    int opt_lineup_club_idx = -2;
+    int opt_shortlist_club_idx = -2;
+    int64_t opt_budget = -1;
+    int opt_simulations = 0, opt_threads = 0;
+    int opt_cups = 0, opt_cup_simulations = 0;
+    int opt_finance_manager = -2, opt_price_low = 1, opt_price_high = 60;
+    int opt_fit_attendance = 0;
+    uint64_t opt_seed = 0;
+    int opt_strength = 0;
+    struct formation opt_formation{};
+    int opt_fixtures_club_idx = -2;
+    int opt_week = -1;
+    int opt_boost_club_idx = -1, opt_boost_division = -1;
+    const struct boost_profile *opt_profile = &boost_profiles[0];
+    position_source opt_positions = POSITIONS_SLOT;
+    unsigned opt_sections = GAMEA_ALL;
+    unsigned opt_fields = PLAYER_ALL;
+    const char *opt_export = nullptr;
+    const char *opt_find = nullptr;
+    const struct field_desc *opt_top = nullptr;
+    int opt_top_count = 20;
+    const char *opt_journal = nullptr, *opt_undo = nullptr, *opt_replay = nullptr;
+    struct player_filter opt_where;
+    std::vector<struct player_transform> opt_transforms;
 
     static struct option long_options[] = {
             { "club",            optional_argument, &opt_club_idx, -1 },
+            { "lineup",          optional_argument, &opt_lineup_club_idx, -1 },
+            { "shortlist",       optional_argument, &opt_shortlist_club_idx, -1 },
+            {"budget",           required_argument, nullptr, 0 },
+            { "simulate",        optional_argument, &opt_simulations, 10000 },
+            {"cups",             no_argument,       &opt_cups, 1},
+            { "cup-odds",        optional_argument, &opt_cup_simulations, 10000 },
+            { "finance",         optional_argument, &opt_finance_manager, -1 },
+            {"prices",           required_argument, nullptr, 0 },
+            {"fit-attendance",   no_argument,       &opt_fit_attendance, 1},
+            {"seed",             required_argument, nullptr, 0 },
+            {"threads",          required_argument, nullptr, 0 },
+            {"formation",        required_argument, nullptr, 0 },
+            {"strength",         no_argument,       &opt_strength, 1},
+            { "fixtures",        optional_argument, &opt_fixtures_club_idx, -1 },
+            {"week",             required_argument, nullptr, 0 },
+            {"sections",         required_argument, nullptr, 0 },
+            {"fields",           required_argument, nullptr, 0 },
+            {"export",           required_argument, nullptr, 0 },
+            {"journal",          required_argument, nullptr, 0 },
+            {"boost-club",       required_argument, nullptr, 0 },
+            {"boost-division",   required_argument, nullptr, 0 },
+            {"profile",          required_argument, nullptr, 0 },
+            {"positions",        required_argument, nullptr, 0 },
+            {"where",            required_argument, nullptr, 0 },
+            {"transform",        required_argument, nullptr, 0 },
+            {"undo",             required_argument, nullptr, 0 },
+            {"replay",           required_argument, nullptr, 0 },
             {"game",             required_argument, nullptr, 'g'},
             {"help",             no_argument,       nullptr, 'h'},
             {"team",             no_argument,       nullptr, 't'},
             {"level-aggression", no_argument,       nullptr, 'l'},
+            {"match-stats",      no_argument,       &opt_match_stats, 1},
+            {"standings",        no_argument,       &opt_standings, 1},
+            {"hashes",           no_argument,       &opt_hashes, 1},
+            {"index",            no_argument,       &opt_index, 1},
+            {"find",             required_argument, nullptr, 0 },
+            {"top",              required_argument, nullptr, 0 },
             {"soup-up",          no_argument,       nullptr, 's'},
             {"verbose",          no_argument,       nullptr, 'v'},
             {nullptr, 0,                            nullptr, 0}
     };
 
+    parse_formation("4-4-2", opt_formation);
+
     while ((c = getopt_long(argc, argv, "abcfg:t:hsv", long_options, &optindex)) != -1) {
         switch (c) {
             case 0: // Long-options only
+                if (0 == strcmp(long_options[optindex].name, "lineup") && optarg) {
+                    opt_lineup_club_idx = atoi(optarg);
+                    if (opt_lineup_club_idx < 0 || opt_lineup_club_idx >= CLUB_IDX_MAX) {
+                        fprintf(stderr, "Invalid club index: %d\n", opt_lineup_club_idx);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "shortlist") && optarg) {
+                    opt_shortlist_club_idx = atoi(optarg);
+                    if (opt_shortlist_club_idx < 0 || opt_shortlist_club_idx >= 114) {
+                        fprintf(stderr, "Invalid club index: %d\n", opt_shortlist_club_idx);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "simulate") && optarg) {
+                    opt_simulations = atoi(optarg);
+                    if (opt_simulations < 1) {
+                        fprintf(stderr, "Invalid number of simulations: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "cup-odds") && optarg) {
+                    opt_cup_simulations = atoi(optarg);
+                    if (opt_cup_simulations < 1) {
+                        fprintf(stderr, "Invalid number of simulations: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "finance") && optarg) {
+                    opt_finance_manager = atoi(optarg);
+                    if (opt_finance_manager < 0 || opt_finance_manager > 1) {
+                        fprintf(stderr, "Invalid manager: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "prices")) {
+                    if (2 != sscanf(optarg, "%d-%d", &opt_price_low, &opt_price_high) ||
+                        opt_price_low < 1 || opt_price_high > 255 || opt_price_low > opt_price_high) {
+                        fprintf(stderr, "Invalid price range: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "seed")) {
+                    opt_seed = strtoull(optarg, nullptr, 0);
+                }
+                if (0 == strcmp(long_options[optindex].name, "threads")) {
+                    opt_threads = atoi(optarg);
+                    if (opt_threads < 1) {
+                        fprintf(stderr, "Invalid number of threads: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "budget")) {
+                    opt_budget = atoll(optarg);
+                    if (opt_budget < 0) {
+                        fprintf(stderr, "Invalid budget: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "find")) {
+                    opt_find = optarg;
+                }
+                if (0 == strcmp(long_options[optindex].name, "top")) {
+                    std::string spec(optarg);
+                    size_t colon = spec.find(':');
+                    if (colon != std::string::npos) {
+                        opt_top_count = atoi(spec.c_str() + colon + 1);
+                        spec.resize(colon);
+                    }
+                    opt_top = find_field<struct gamec::player>(spec);
+                    const std::vector<const struct field_desc *> &sortable = sortable_player_fields();
+                    if (!opt_top || std::find(sortable.begin(), sortable.end(), opt_top) == sortable.end() ||
+                        opt_top_count <= 0) {
+                        fprintf(stderr, "Invalid top: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "formation")) {
+                    if (!parse_formation(optarg, opt_formation)) {
+                        fprintf(stderr, "Invalid formation: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
                 if (0 == strcmp(long_options[optindex].name, "club") && optarg) {
                     opt_club_idx = atoi(optarg);
                     if (opt_club_idx < 0 || opt_club_idx >= CLUB_IDX_MAX) {
@@ -105,6 +657,99 @@ int main(int argc, char *argv[]) {
                         return EXIT_FAILURE;
                     }
                 }
+                if (0 == strcmp(long_options[optindex].name, "fixtures") && optarg) {
+                    opt_fixtures_club_idx = atoi(optarg);
+                    if (opt_fixtures_club_idx < 0 || opt_fixtures_club_idx >= CLUB_IDX_MAX) {
+                        fprintf(stderr, "Invalid club index: %d\n", opt_fixtures_club_idx);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "week")) {
+                    opt_week = atoi(optarg);
+                    if (opt_week < 1 || opt_week > TIMETABLE_WEEKS) {
+                        fprintf(stderr, "Invalid week: %d\n", opt_week);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "sections")) {
+                    if (!parse_selection(optarg, gamea_sections, opt_sections)) {
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "export")) {
+                    opt_export = optarg;
+                    if (strcmp(opt_export, "players") != 0 && strcmp(opt_export, "clubs") != 0 &&
+                        strcmp(opt_export, "managers") != 0) {
+                        fprintf(stderr, "Invalid export: %s\n", opt_export);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "where") ||
+                    0 == strcmp(long_options[optindex].name, "transform")) {
+                    std::string error;
+                    bool parsed = 0 == strcmp(long_options[optindex].name, "where")
+                                  ? parse_player_filter(optarg, opt_where, error)
+                                  : parse_player_transforms(optarg, opt_transforms, error);
+                    if (!parsed) {
+                        fprintf(stderr, "%s\n", error.c_str());
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "boost-club")) {
+                    opt_boost_club_idx = atoi(optarg);
+                    if (opt_boost_club_idx < 0 || opt_boost_club_idx >= CLUB_IDX_MAX) {
+                        fprintf(stderr, "Invalid club index: %d\n", opt_boost_club_idx);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "boost-division")) {
+                    opt_boost_division = atoi(optarg);
+                    if (opt_boost_division < 0 || opt_boost_division > 4) {
+                        fprintf(stderr, "Invalid division: %d\n", opt_boost_division);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "profile")) {
+                    opt_profile = find_boost_profile(optarg);
+                    if (!opt_profile) {
+                        fprintf(stderr, "Unknown profile: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "positions")) {
+                    if (0 == strcmp(optarg, "slot")) {
+                        opt_positions = POSITIONS_SLOT;
+                    } else if (0 == strcmp(optarg, "inferred")) {
+                        opt_positions = POSITIONS_INFERRED;
+                    } else {
+                        fprintf(stderr, "Invalid positions: %s\n", optarg);
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
+                if (0 == strcmp(long_options[optindex].name, "journal")) {
+                    opt_journal = optarg;
+                }
+                if (0 == strcmp(long_options[optindex].name, "undo")) {
+                    opt_undo = optarg;
+                }
+                if (0 == strcmp(long_options[optindex].name, "replay")) {
+                    opt_replay = optarg;
+                }
+                if (0 == strcmp(long_options[optindex].name, "fields")) {
+                    if (!parse_selection(optarg, player_fields, opt_fields)) {
+                        print_help(argv[0]);
+                        return EXIT_FAILURE;
+                    }
+                }
                 break;
             case 'a': opt_dump_gamea = 1; break;
             case 'b': opt_dump_gameb = 1; break;
@@ -161,16 +806,35 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "sizeof (gamec.player) = 0x%0zx\n", sizeof(struct gamec::player));
     }
 
-	assert(sizeof (struct gamea)         == 0x7372);
-	assert(sizeof (struct gameb::club)   == 0x023A);
-	assert(sizeof (struct gamec::player) == 0x0028);
-
     load_metadata(game_path);
     load_binaries(game_nr, game_path);
 
+    /*
+     * Once written, the sidecar is used by every run, and rewritten only by
+     * --index: a stale one is built again in memory, so that runs which only
+     * read the savegame never write to its folder.
+     */
+    save_index index;
+    bool indexed = false;
+    if (opt_index || opt_find || opt_top || std::filesystem::exists(sidecar_path(game_path, game_nr))) {
+        index_source source;
+        try {
+            source = open_save_index(index, game_path, game_nr, opt_index);
+        } catch (const std::exception &e) {
+            fprintf(stderr, "Warning: could not write %s: %s\n", sidecar_path(game_path, game_nr).c_str(), e.what());
+            source = open_save_index(index, game_path, game_nr, false);
+        }
+        indexed = true;
+
+        if (opt_verbose || opt_index) {
+            static const char *what[] = {"mapped", "built", "written"};
+            fprintf(stderr, "Index %s: %s\n", what[source], sidecar_path(game_path, game_nr).c_str());
+        }
+    }
+
     if (opt_dump_gamea) {
         printf("GAME%dA\n", game_nr);
-        dump_gamea();
+        dump_gamea(opt_sections);
     }
 
     if (opt_dump_gameb) {
@@ -186,239 +850,520 @@ int main(int argc, char *argv[]) {
         dump_club(club);
     }
 
-    if (opt_dump_gamec) {
-        printf("GAME%dC\n", game_nr);
-        dump_gamec();
-    }
+    if (opt_fixtures_club_idx != -2 || opt_week != -1) {
+        calendar cal;
+        if (indexed)
+            index.load_calendar(cal);
+        else
+            cal.build(gameb);
 
-    if (opt_dump_free_players) {
-        printf("FREE PLAYERS\n");
-        dump_free_players();
-    }
+        if (opt_fixtures_club_idx != -2) {
+            if (opt_fixtures_club_idx == -1)
+                opt_fixtures_club_idx = gamea.manager[0].club_idx;
 
-    if (opt_level_aggression) {
-        level_aggression();
-        save_binaries(game_nr, game_path);
+            printf("Fixtures for %16.16s\n", gameb.club[opt_fixtures_club_idx].name);
+            for (const struct fixture *f : cal.next_fixtures(opt_fixtures_club_idx, gamea.turn, TIMETABLE_SLOTS)) {
+                if (!f->played())
+                    print_fixture(*f);
+            }
+            printf("\n");
+        }
+
+        if (opt_week != -1) {
+            printf("Week %d\n", opt_week);
+            for (const struct fixture &f : cal.week(opt_week - 1))
+                print_fixture(f);
+            printf("\n");
+        }
     }
 
-    if (opt_soup_up) {
-        soup_up();
-        save_binaries(game_nr, game_path);
+    if (opt_lineup_club_idx != -2) {
+        if (opt_lineup_club_idx == -1)
+            opt_lineup_club_idx = gamea.manager[0].club_idx;
+
+        struct lineup l{};
+        pick_lineup(opt_lineup_club_idx, opt_formation, l);
+        dump_lineup(l, opt_formation);
     }
 
-    if (opt_new_club_idx != -1) {
-        change_club(opt_new_club_idx, game_path);
-        save_binaries(game_nr, game_path);
-        update_metadata(game_nr);
-        save_metadata(game_path);
+    if (opt_shortlist_club_idx != -2) {
+        if (opt_shortlist_club_idx == -1)
+            opt_shortlist_club_idx = gamea.manager[0].club_idx;
+
+        struct shortlist_options options{};
+        options.budget = opt_budget != -1 ? opt_budget : std::max(0, gameb.club[opt_shortlist_club_idx].bank_account);
+        options.wage_weeks = std::max(0, TIMETABLE_WEEKS - gamea.turn / TIMETABLE_DAYS);
+
+        dump_shortlist(plan_signings(opt_shortlist_club_idx, opt_formation, options), opt_formation, options.budget);
     }
 
-    return EXIT_SUCCESS;
-}
+    if (opt_simulations) {
+        season_simulator simulator(gamea, gameb, gamec, opt_formation);
+        std::unique_ptr<struct season_odds> odds = std::make_unique<struct season_odds>();
 
-void dump_gamea() {
+        simulator.run(opt_simulations, *odds, opt_threads, opt_seed);
+        printf("SEASON ODDS (%d simulations)\n", opt_simulations);
+        dump_season_odds(simulator, *odds);
+    }
 
-    int correction = 0;
-    for (int i = 0; i < 118; ++i) {
-        switch (i) {
-            case 0:
-                correction = 0;
-                printf("Premier league clubs\n");
-                break;
-            case 22:
-                correction = 22;
-                printf("\nDivision 1 clubs\n");
-                break;
-            case 46:
-                correction = 46;
-                printf("\nDivision 2 clubs\n");
-                break;
-            case 70:
-                correction = 70;
-                printf("\nDivision 3 clubs\n");
-                break;
-            case 92:
-                correction = 92;
-                printf("\nConference league clubs\n");
-                break;
-            case 114:
-                correction = 114;
-                printf("\nMisc clubs\n");
-                break;
-            default:
-                break;
+    struct attendance_model attendance;
+
+    if (opt_fit_attendance) {
+        struct attendance_sample sample;
+        std::unique_ptr<struct gamea> game_data(new struct gamea);
+        std::unique_ptr<struct gameb> club_data(new struct gameb);
+        std::unique_ptr<struct gamec> player_data(new struct gamec);
+
+        for (int i = optind; i < argc; ++i) {
+            for (int nr = 1; nr <= 8; ++nr) {
+                std::string error;
+                if (!load_save_spec(std::string(argv[i]) + ":" + std::to_string(nr), *game_data, *club_data,
+                                    *player_data, error)) {
+                    /* Empty slots are left out quietly, broken ones with a word */
+                    if (std::filesystem::exists(construct_save_file_path(argv[i], nr, 'A')))
+                        fprintf(stderr, "Skipping %s:%d: %s\n", argv[i], nr, error.c_str());
+                    continue;
+                }
+                sample.add(*game_data);
+            }
         }
 
-        printf("%2d (%04x) %16.16s\n", i + 1 - correction,
-               gamea.club_index.all[i],
-               gameb.club[gamea.club_index.all[i]].name);
+        struct attendance_fit fit = fit_attendance(sample, attendance, opt_threads);
+        attendance = fit.model;
+        printf("ATTENDANCE MODEL (%zu matches from %d savegames)\n", fit.samples, sample.saves);
+        dump_attendance_fit(fit);
     }
-    printf("\n");
 
-    for (int i = 0; i < 114; ++i) {
-        switch (i) {
-            case 0:
-                correction = 0;
-                printf("Premier league home/away table\n");
-                printf("Club              W  D  L  F  A   W  D  L  F  A\n");
-                break;
-            case 22:
-                correction = 22;
-                printf("\nDivision 1 home/away table\n");
-                printf("Club              W  D  L  F  A   W  D  L  F  A\n");
-                break;
-            case 46:
-                correction = 46;
-                printf("\nDivision 2 home/away table\n");
-                printf("Club              W  D  L  F  A   W  D  L  F  A\n");
-                break;
-            case 70:
-                correction = 70;
-                printf("\nDivision 3 home/away table\n");
-                printf("Club              W  D  L  F  A   W  D  L  F  A\n");
-                break;
-            case 92:
-                correction = 92;
-                printf("\nConference league home/away table\n");
-                printf("Club              W  D  L  F  A   W  D  L  F  A\n");
-                break;
-            default:
-                break;
+    if (opt_finance_manager != -2) {
+        if (opt_finance_manager == -1)
+            opt_finance_manager = 0;
+        int16_t club_idx = gamea.manager[opt_finance_manager].club_idx;
+        if (club_idx < 0 || club_idx >= CLUB_IDX_MAX) {
+            fprintf(stderr, "Manager %d has no club\n", opt_finance_manager);
+            exit(EXIT_FAILURE);
         }
 
-
-        printf("%16.16s", gameb.club[gamea.table.all[i].club_idx].name);
-        printf(" %2d %2d %2d %2d %2d  %2d %2d %2d %2d %2d, (%02x %02x %02x)\n",
-               gamea.table.all[i].hw,
-               gamea.table.all[i].hd,
-               gamea.table.all[i].hl,
-               gamea.table.all[i].hf,
-               gamea.table.all[i].ha,
-               gamea.table.all[i].aw,
-               gamea.table.all[i].ad,
-               gamea.table.all[i].al,
-               gamea.table.all[i].af,
-               gamea.table.all[i].aa,
-               gamea.table.all[i].hx, gamea.table.all[i].ax, gamea.table.all[i].xx);
+        dump_finance(project_finances(opt_finance_manager, attendance), attendance, opt_price_low, opt_price_high,
+                     opt_threads);
     }
 
-    printf("\n");
-    printf("data000: (0x%04x): %d\n", gamea.data000, gamea.data000);
-    printf("data001: (0x%04x): %d\n", gamea.data001, gamea.data001);
-    printf("data002: (0x%08x): %d\n", gamea.data002, gamea.data002);
-    assert(gamea.data002 < 65536); // just remind me that this could be two 16bits.
-    printf("\n");
+    if (opt_cups || opt_cup_simulations) {
+        std::unique_ptr<struct cup_odds> odds = std::make_unique<struct cup_odds>();
 
-    for (int i = 0; i < 75; ++i) {
-        switch (i) {
-            case 0:
-                correction = 0;
-                printf("Premier league top scorers\n");
-                printf("Player       Rating       Club             PL SC\n");
-                break;
-            case 15:
-                correction = 15;
-                printf("\nDivision 1 top scorers\n");
-                printf("Player       Rating       Club             PL SC\n");
-                break;
-            case 30:
-                correction = 30;
-                printf("\nDivision 2 top scorers\n");
-                printf("Player       Rating       Club             PL SC\n");
-                break;
-            case 45:
-                correction = 45;
-                printf("\nDivision 3 top scorers\n");
-                printf("Player       Rating       Club             PL SC\n");
-                break;
-            case 60:
-                correction = 60;
-                printf("\nConference league top scorers\n");
-                printf("Player       Rating       Club             PL SC\n");
-                break;
-            default:
-                break;
+        for (int i = 0; i < CUP_COMPETITION_COUNT; ++i) {
+            if (!cup_competitions[i].known)
+                continue;
+
+            struct cup_bracket bracket{};
+            bracket.build(cup_competitions[i]);
+            if (bracket.ties.empty())
+                continue;
+
+            if (opt_cups)
+                dump_cup(bracket);
+            if (opt_cup_simulations) {
+                simulate_cup(bracket, gameb, gamec, opt_formation, opt_cup_simulations, *odds, opt_threads, opt_seed);
+                dump_cup_odds(bracket, *odds);
+            }
         }
+    }
 
-        if (gamea.top_scorers.all[i].player_idx == -1)
-            printf("skip\n");
+    if (opt_strength) {
+        printf("STRENGTH %s\n", opt_formation.name);
+        dump_strength(opt_formation);
+    }
+
+    if (opt_standings) {
+        calendar cal;
+        if (indexed)
+            index.load_calendar(cal);
         else
-            printf("%12.12s %12.12s %16.16s %2d %2d\n",
-                   gamec.player[gamea.top_scorers.all[i].player_idx].name, "",
-                   gameb.club[gamea.top_scorers.all[i].club_idx].name,
-                   gamea.top_scorers.all[i].pl, gamea.top_scorers.all[i].sc
-            );
+            cal.build(gameb);
+        standings tables(gamea, cal);
+
+        printf("STANDINGS\n");
+        dump_standings(tables, tables.cross_check(gamea));
     }
-    printf("\n");
 
-    printf("Sorted numbers\n");
-    for (int i = 0; i < 64; ++i) {
-        printf("[%2d] %04x %16.16s\n", i, gamea.sorted_numbers[i], gameb.club[gamea.sorted_numbers[i]].name);
+    if (opt_hashes) {
+        struct save_hashes hashes;
+
+        hashes.compute();
+        printf("HASHES %016llx\n", (unsigned long long) hashes.save());
+        dump_save_hashes(hashes);
     }
-    printf("\n");
 
-    for (int i = 0; i < 64; ++i) {
-        struct gamea::referee &referee = gamea.referee[i];
-        printf("Referee: (%2d) %14.14s - %d : %d ",
-               i, referee.name, 40 + referee.age, referee.magic);
+    if (opt_find) {
+        std::vector<int16_t> players = index.find_players(opt_find);
+        printf("FIND %s (%zu player%s)\n", opt_find, players.size(), players.size() == 1 ? "" : "s");
+        dump_players(players, index, nullptr);
+    }
 
-        for (int j = 0; j < sizeof(referee.var); ++j)
-            printf(" %02x", referee.var[j]);
-        printf("\n");
+    if (opt_top) {
+        printf("TOP %d %s\n", opt_top_count, opt_top->name);
+        dump_players(index.top_players(*opt_top, opt_top_count), index, opt_top);
     }
-    printf("\n");
 
-    for (int i = 0; i < 149; ++i) {
-        switch (i) {
-            case 0:
-                printf("the f.a. cup\n");
-                break;
-            case 36:
-                printf("the league cup\n");
-                break;
-            case 64:
-                printf("data090\n");
-                break;
-            case 68:
-                printf("the champions cup\n");
-                break;
-            case 84:
-                printf("data091\n");
-                break;
-            case 100:
-                printf("the cup winners cup\n");
-                break;
-            case 116:
-                printf("the u.e.f.a. cup\n");
-                break;
-            case 148:
-                printf("the charity sheld\n");
-                break;
-        }
+    if (opt_dump_gamec) {
+        printf("GAME%dC\n", game_nr);
+        dump_gamec(opt_fields);
+    }
+
+    if (opt_export) {
+        if (0 == strcmp(opt_export, "players"))
+            export_records(gamec.player, 3932);
+        else if (0 == strcmp(opt_export, "clubs"))
+            export_records(gameb.club, CLUB_IDX_MAX);
+        else
+            export_records(gamea.manager, 2);
+    }
 
-        struct gamea::cuppy::cup_entry &cup_entry = gamea.cuppy.all[i];
+    if (opt_match_stats) {
+        match_stats stats;
+        stats.add(gamea);
 
-        if (cup_entry.club[0].idx == -1 || cup_entry.club[1].idx == -1 ||
-            cup_entry.club[0].idx >= 245 || cup_entry.club[1].idx >= 245) {
-            printf("XXX: idx: %d, goals: %d, audience: %d - idx: %d, goals: %d, audience: %d\n",
-                   cup_entry.club[0].idx, cup_entry.club[0].goals, cup_entry.club[0].audience,
-                   cup_entry.club[1].idx, cup_entry.club[1].goals, cup_entry.club[1].audience);
-            continue;
+        for (int i = optind + 1; i < argc; ++i) {
+            std::unique_ptr<struct gamea> game_data(new struct gamea);
+            std::unique_ptr<struct gameb> club_data(new struct gameb);
+            std::unique_ptr<struct gamec> player_data(new struct gamec);
+
+            load_binaries(game_nr, argv[i], *game_data, *club_data, *player_data);
+            stats.add(*game_data);
         }
 
-        struct gameb::club &home_club = get_club(cup_entry.club[0].idx);
-        struct gameb::club &away_club = get_club(cup_entry.club[1].idx);
+        printf("MATCH STATS\n");
+        dump_match_stats(stats);
+    }
 
-        printf("%3.3s:%16.16s - %3.3s:%16.16s\nat %24.24s\n",
-               "XXX", home_club.name,
-               "XXX", away_club.name,
-               home_club.stadium);
+    if (opt_dump_free_players) {
+        printf("FREE PLAYERS\n");
+        dump_free_players();
     }
 
-/*
-	printf(" idx, club, goals, home_supporters, total_supporters, away_supporters, goals, idx club, \n");
-	for (int i = 0; i < 149; ++i) {
-		if ( gamea.cuppy.all[i].club[0].idx == -1 || gamea.cuppy.all[i].club[1].idx == -1 ||
+    if (opt_undo || opt_replay) {
+        const char *journal_path = opt_undo ? opt_undo : opt_replay;
+        edit_journal recorded;
+
+        try {
+            recorded.load(journal_path);
+        } catch (const std::runtime_error &e) {
+            fprintf(stderr, "%s\n", e.what());
+            return EXIT_FAILURE;
+        }
+
+        bool applied = opt_undo ? recorded.undo(gamea, gameb, gamec) : recorded.replay(gamea, gameb, gamec);
+        if (!applied) {
+            fprintf(stderr, "Savegame does not match journal %s\n", journal_path);
+            return EXIT_FAILURE;
+        }
+
+        save_binaries(game_nr, game_path);
+        update_metadata(game_nr);
+        save_metadata(game_path);
+    }
+
+    /* Edits are made in memory and the journal written first, so no save is changed without its journal */
+    edit_journal journal;
+    bool edited = false;
+
+    if (opt_level_aggression) {
+        level_aggression(&journal);
+        edited = true;
+    }
+
+    if (opt_soup_up) {
+        soup_up(0, *opt_profile, opt_positions, &journal);
+        edited = true;
+    }
+
+    if (opt_boost_club_idx != -1 || opt_boost_division != -1) {
+        struct boost_summary summary{};
+        if (opt_boost_club_idx != -1)
+            boost_club(opt_boost_club_idx, *opt_profile, opt_positions, summary, &journal);
+        if (opt_boost_division != -1)
+            boost_division(opt_boost_division, *opt_profile, opt_positions, summary, &journal);
+        edited = true;
+        print_boost_summary(summary);
+    }
+
+    if (!opt_transforms.empty()) {
+        std::vector<int16_t> players = select_players(opt_where);
+        transform_players(players, opt_transforms, &journal);
+        edited = true;
+        printf("Transformed %zu players\n", players.size());
+    }
+
+    if (opt_new_club_idx != -1) {
+        change_club(opt_new_club_idx, game_path, 0, &journal);
+        edited = true;
+    }
+
+    if (opt_journal) {
+        journal.commit();
+        try {
+            journal.save(opt_journal);
+        } catch (const std::runtime_error &e) {
+            fprintf(stderr, "%s\n", e.what());
+            if (edited)
+                fprintf(stderr, "Savegame left unchanged\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (edited)
+        save_binaries(game_nr, game_path);
+    if (opt_new_club_idx != -1) {
+        update_metadata(game_nr);
+        save_metadata(game_path);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+bool parse_selection(const char *list, const struct selection_name *names, unsigned &selection) {
+    std::string names_list(list);
+    size_t start = 0;
+
+    selection = 0;
+    while (start <= names_list.size()) {
+        size_t end = names_list.find(',', start);
+        if (end == std::string::npos)
+            end = names_list.size();
+
+        std::string name = names_list.substr(start, end - start);
+        const struct selection_name *n = names;
+        while (n->name && name != n->name)
+            ++n;
+
+        if (!n->name) {
+            fprintf(stderr, "Unknown selection: %s\n", name.c_str());
+            return false;
+        }
+
+        selection |= n->bits;
+        start = end + 1;
+    }
+
+    return true;
+}
+
+void dump_gamea(unsigned sections) {
+
+    int correction = 0;
+    if (sections & GAMEA_CLUBS) {
+        for (int i = 0; i < 118; ++i) {
+            switch (i) {
+                case 0:
+                    correction = 0;
+                    printf("Premier league clubs\n");
+                    break;
+                case 22:
+                    correction = 22;
+                    printf("\nDivision 1 clubs\n");
+                    break;
+                case 46:
+                    correction = 46;
+                    printf("\nDivision 2 clubs\n");
+                    break;
+                case 70:
+                    correction = 70;
+                    printf("\nDivision 3 clubs\n");
+                    break;
+                case 92:
+                    correction = 92;
+                    printf("\nConference league clubs\n");
+                    break;
+                case 114:
+                    correction = 114;
+                    printf("\nMisc clubs\n");
+                    break;
+                default:
+                    break;
+            }
+
+            printf("%2d (%04x) %16.16s\n", i + 1 - correction,
+                   gamea.club_index.all[i],
+                   gameb.club[gamea.club_index.all[i]].name);
+        }
+        printf("\n");
+    }
+
+    if (sections & GAMEA_TABLES) {
+        for (int i = 0; i < 114; ++i) {
+            switch (i) {
+                case 0:
+                    correction = 0;
+                    printf("Premier league home/away table\n");
+                    printf("Club              W  D  L  F  A   W  D  L  F  A\n");
+                    break;
+                case 22:
+                    correction = 22;
+                    printf("\nDivision 1 home/away table\n");
+                    printf("Club              W  D  L  F  A   W  D  L  F  A\n");
+                    break;
+                case 46:
+                    correction = 46;
+                    printf("\nDivision 2 home/away table\n");
+                    printf("Club              W  D  L  F  A   W  D  L  F  A\n");
+                    break;
+                case 70:
+                    correction = 70;
+                    printf("\nDivision 3 home/away table\n");
+                    printf("Club              W  D  L  F  A   W  D  L  F  A\n");
+                    break;
+                case 92:
+                    correction = 92;
+                    printf("\nConference league home/away table\n");
+                    printf("Club              W  D  L  F  A   W  D  L  F  A\n");
+                    break;
+                default:
+                    break;
+            }
+
+
+            printf("%16.16s", gameb.club[gamea.table.all[i].club_idx].name);
+            printf(" %2d %2d %2d %2d %2d  %2d %2d %2d %2d %2d, (%02x %02x %02x)\n",
+                   gamea.table.all[i].hw,
+                   gamea.table.all[i].hd,
+                   gamea.table.all[i].hl,
+                   gamea.table.all[i].hf,
+                   gamea.table.all[i].ha,
+                   gamea.table.all[i].aw,
+                   gamea.table.all[i].ad,
+                   gamea.table.all[i].al,
+                   gamea.table.all[i].af,
+                   gamea.table.all[i].aa,
+                   gamea.table.all[i].hx, gamea.table.all[i].ax, gamea.table.all[i].xx);
+        }
+    }
+
+    if (sections & GAMEA_MISC) {
+        printf("\n");
+        printf("data000: (0x%04x): %d\n", gamea.data000, gamea.data000);
+        printf("data001: (0x%04x): %d\n", gamea.data001, gamea.data001);
+        printf("data002: (0x%08x): %d\n", gamea.data002, gamea.data002);
+        assert(gamea.data002 < 65536); // just remind me that this could be two 16bits.
+        printf("\n");
+    }
+
+    if (sections & GAMEA_SCORERS) {
+        for (int i = 0; i < 75; ++i) {
+            switch (i) {
+                case 0:
+                    correction = 0;
+                    printf("Premier league top scorers\n");
+                    printf("Player       Rating       Club             PL SC\n");
+                    break;
+                case 15:
+                    correction = 15;
+                    printf("\nDivision 1 top scorers\n");
+                    printf("Player       Rating       Club             PL SC\n");
+                    break;
+                case 30:
+                    correction = 30;
+                    printf("\nDivision 2 top scorers\n");
+                    printf("Player       Rating       Club             PL SC\n");
+                    break;
+                case 45:
+                    correction = 45;
+                    printf("\nDivision 3 top scorers\n");
+                    printf("Player       Rating       Club             PL SC\n");
+                    break;
+                case 60:
+                    correction = 60;
+                    printf("\nConference league top scorers\n");
+                    printf("Player       Rating       Club             PL SC\n");
+                    break;
+                default:
+                    break;
+            }
+
+            if (gamea.top_scorers.all[i].player_idx == -1)
+                printf("skip\n");
+            else
+                printf("%12.12s %12.12s %16.16s %2d %2d\n",
+                       gamec.player[gamea.top_scorers.all[i].player_idx].name, "",
+                       gameb.club[gamea.top_scorers.all[i].club_idx].name,
+                       gamea.top_scorers.all[i].pl, gamea.top_scorers.all[i].sc
+                );
+        }
+        printf("\n");
+    }
+
+    if (sections & GAMEA_MISC) {
+        printf("Sorted numbers\n");
+        for (int i = 0; i < 64; ++i) {
+            printf("[%2d] %04x %16.16s\n", i, gamea.sorted_numbers[i], gameb.club[gamea.sorted_numbers[i]].name);
+        }
+        printf("\n");
+    }
+
+    if (sections & GAMEA_REFEREES) {
+        for (int i = 0; i < 64; ++i) {
+            struct gamea::referee &referee = gamea.referee[i];
+            printf("Referee: (%2d) %14.14s - %d : %d ",
+                   i, referee.name, 40 + referee.age, referee.magic);
+
+            for (int j = 0; j < sizeof(referee.var); ++j)
+                printf(" %02x", referee.var[j]);
+            printf("\n");
+        }
+        printf("\n");
+    }
+
+    if (sections & GAMEA_CUPS) {
+        for (int i = 0; i < 149; ++i) {
+            switch (i) {
+                case 0:
+                    printf("the f.a. cup\n");
+                    break;
+                case 36:
+                    printf("the league cup\n");
+                    break;
+                case 64:
+                    printf("data090\n");
+                    break;
+                case 68:
+                    printf("the champions cup\n");
+                    break;
+                case 84:
+                    printf("data091\n");
+                    break;
+                case 100:
+                    printf("the cup winners cup\n");
+                    break;
+                case 116:
+                    printf("the u.e.f.a. cup\n");
+                    break;
+                case 148:
+                    printf("the charity sheld\n");
+                    break;
+            }
+
+            struct gamea::cuppy::cup_entry &cup_entry = gamea.cuppy.all[i];
+
+            if (cup_entry.club[0].idx == -1 || cup_entry.club[1].idx == -1 ||
+                cup_entry.club[0].idx >= 245 || cup_entry.club[1].idx >= 245) {
+                printf("XXX: idx: %d, goals: %d, audience: %d - idx: %d, goals: %d, audience: %d\n",
+                       cup_entry.club[0].idx, cup_entry.club[0].goals, cup_entry.club[0].audience,
+                       cup_entry.club[1].idx, cup_entry.club[1].goals, cup_entry.club[1].audience);
+                continue;
+            }
+
+            struct gameb::club &home_club = get_club(cup_entry.club[0].idx);
+            struct gameb::club &away_club = get_club(cup_entry.club[1].idx);
+
+            printf("%3.3s:%16.16s - %3.3s:%16.16s\nat %24.24s\n",
+                   "XXX", home_club.name,
+                   "XXX", away_club.name,
+                   home_club.stadium);
+        }
+    }
+
+/*
+	printf(" idx, club, goals, home_supporters, total_supporters, away_supporters, goals, idx club, \n");
+	for (int i = 0; i < 149; ++i) {
+		if ( gamea.cuppy.all[i].club[0].idx == -1 || gamea.cuppy.all[i].club[1].idx == -1 ||
 		     gamea.cuppy.all[i].club[0].idx > CLUB_IDX_MAX || gamea.cuppy.all[i].club[1].idx > CLUB_IDX_MAX ){
 			printf("cuppy.all[%3d]: %04x %d %5d (%5d) %5d %d %04x\n", i,
 				gamea.cuppy.all[i].club[0].idx, gamea.cuppy.all[i].club[0].goals, gamea.cuppy.all[i].club[0].audience,
@@ -438,253 +1383,281 @@ void dump_gamea() {
 
 	}
 */
-    printf("\n--data095-- (i'm guessing cup turns are in here, mon week 7 = ~14-17)");
-    for (int i = 0; i < sizeof(gamea.data095); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%04d]", i);
-        printf(" %02x", gamea.data095[i]);
+    if (sections & GAMEA_RAW) {
+        printf("\n--data095-- (i'm guessing cup turns are in here, mon week 7 = ~14-17)");
+        for (int i = 0; i < sizeof(gamea.data095); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%04d]", i);
+            printf(" %02x", gamea.data095[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
-    printf("The charity shield history: (%04x) %16.16s : (%04x) %16.16s\n",
-           gamea.the_charity_shield_history.club[0].idx, gameb.club[gamea.the_charity_shield_history.club[0].idx].name,
-           gamea.the_charity_shield_history.club[1].idx, gameb.club[gamea.the_charity_shield_history.club[1].idx].name
-    );
-    printf("                             %5d %5d : %5d %5d\n",
-           gamea.the_charity_shield_history.club[0].goals, gamea.the_charity_shield_history.club[0].audience,
-           gamea.the_charity_shield_history.club[1].goals, gamea.the_charity_shield_history.club[1].audience
-    );
-
-    printf("\n--- some table ---\n");
-    for (int i = 0; i < 11; ++i) {
-        printf("(%04x) %16.16s %d %5d" " (%5d) "
-               "%5d %d (%04x) %16.16s\n",
-               gamea.some_table[i].club1_idx,
-               gameb.club[gamea.some_table[i].club1_idx].name,
-               gamea.some_table[i].club1_goals,
-               gamea.some_table[i].club1_audience,
-               gamea.some_table[i].club1_audience + gamea.some_table[i].club2_audience,
-               gamea.some_table[i].club2_audience,
-               gamea.some_table[i].club2_goals,
-               gamea.some_table[i].club2_idx,
-               gameb.club[gamea.some_table[i].club2_idx].name);
-    }
-    printf("\n");
+    if (sections & GAMEA_HISTORY) {
+        printf("The charity shield history: (%04x) %16.16s : (%04x) %16.16s\n",
+               gamea.the_charity_shield_history.club[0].idx, gameb.club[gamea.the_charity_shield_history.club[0].idx].name,
+               gamea.the_charity_shield_history.club[1].idx, gameb.club[gamea.the_charity_shield_history.club[1].idx].name
+        );
+        printf("                             %5d %5d : %5d %5d\n",
+               gamea.the_charity_shield_history.club[0].goals, gamea.the_charity_shield_history.club[0].audience,
+               gamea.the_charity_shield_history.club[1].goals, gamea.the_charity_shield_history.club[1].audience
+        );
 
-    printf("Last results\n");
-    for (int i = 0; i < 47; ++i) {
-        if (gamea.last_results.all[i].club[0].idx == 0 && gamea.last_results.all[i].club[1].idx == 0) {
-            printf("empty\n");
-            continue;
+        printf("\n--- some table ---\n");
+        for (int i = 0; i < 11; ++i) {
+            printf("(%04x) %16.16s %d %5d" " (%5d) "
+                   "%5d %d (%04x) %16.16s\n",
+                   gamea.some_table[i].club1_idx,
+                   gameb.club[gamea.some_table[i].club1_idx].name,
+                   gamea.some_table[i].club1_goals,
+                   gamea.some_table[i].club1_audience,
+                   gamea.some_table[i].club1_audience + gamea.some_table[i].club2_audience,
+                   gamea.some_table[i].club2_audience,
+                   gamea.some_table[i].club2_goals,
+                   gamea.some_table[i].club2_idx,
+                   gameb.club[gamea.some_table[i].club2_idx].name);
         }
-        printf("(%04x) %16.16s %d %5d (%5d) %5d %d (%04x) %16.16s\n",
-               gamea.last_results.all[i].club[0].idx, gameb.club[gamea.last_results.all[i].club[0].idx].name,
-               gamea.last_results.all[i].club[0].goals, gamea.last_results.all[i].club[0].audience,
-               gamea.last_results.all[i].club[0].audience + gamea.last_results.all[i].club[1].audience,
-               gamea.last_results.all[i].club[1].audience, gamea.last_results.all[i].club[1].goals,
-               gamea.last_results.all[i].club[1].idx, gameb.club[gamea.last_results.all[i].club[1].idx].name
-        );
-    }
-    printf("\n");
+        printf("\n");
 
-    for (int lg = 0; lg < 5; ++lg) {
-        printf("Previous %s champions\n", division[lg]);
-        for (int h = 0; h < 20; ++h) {
-            if (gamea.league[lg].history[h].year == 0)
+        printf("Last results\n");
+        for (int i = 0; i < 47; ++i) {
+            if (gamea.last_results.all[i].club[0].idx == 0 && gamea.last_results.all[i].club[1].idx == 0) {
+                printf("empty\n");
                 continue;
-            printf("%4d: (%04x) %16.16s",
-                   gamea.league[lg].history[h].year,
-                   gamea.league[lg].history[h].club_idx, gameb.club[gamea.league[lg].history[h].club_idx].name
+            }
+            printf("(%04x) %16.16s %d %5d (%5d) %5d %d (%04x) %16.16s\n",
+                   gamea.last_results.all[i].club[0].idx, gameb.club[gamea.last_results.all[i].club[0].idx].name,
+                   gamea.last_results.all[i].club[0].goals, gamea.last_results.all[i].club[0].audience,
+                   gamea.last_results.all[i].club[0].audience + gamea.last_results.all[i].club[1].audience,
+                   gamea.last_results.all[i].club[1].audience, gamea.last_results.all[i].club[1].goals,
+                   gamea.last_results.all[i].club[1].idx, gameb.club[gamea.last_results.all[i].club[1].idx].name
             );
+        }
+        printf("\n");
+
+        for (int lg = 0; lg < 5; ++lg) {
+            printf("Previous %s champions\n", division[lg]);
+            for (int h = 0; h < 20; ++h) {
+                if (gamea.league[lg].history[h].year == 0)
+                    continue;
+                printf("%4d: (%04x) %16.16s",
+                       gamea.league[lg].history[h].year,
+                       gamea.league[lg].history[h].club_idx, gameb.club[gamea.league[lg].history[h].club_idx].name
+                );
 
-            for (int i = 0; i < sizeof(gamea.league[lg].history[h].data); ++i) {
-                printf(" %02x", gamea.league[lg].history[h].data[i]);
+                for (int i = 0; i < sizeof(gamea.league[lg].history[h].data); ++i) {
+                    printf(" %02x", gamea.league[lg].history[h].data[i]);
+                }
+                printf("\n");
             }
             printf("\n");
         }
-        printf("\n");
-    }
 
-    static const char *cup[] = {
-            "F.A. cup",
-            "League cup",
-            "Champions cup",
-            "Cup winners cup",
-            "U.E.F.A. cup",
-            "Charity shield",
-    };
+        static const char *cup[] = {
+                "F.A. cup",
+                "League cup",
+                "Champions cup",
+                "Cup winners cup",
+                "U.E.F.A. cup",
+                "Charity shield",
+        };
 
-    static const char *club_type_short[] = {
-            "000",
-            "ITA", //1
-            "GER", //2
-            "SPA", //3
-            "HOL", //4
-            "005",
-            "RUS", //6
-            "SCO", //7
-            "BEL", //8
-            "009",
-            "010",
-            "011",
-            "012",
-            "013",
-            "014",
-            "015",
-            "016",
-            "017",
-            "018",
-            "019",
-            "PRM", //20
-            "DV1", //21
-            "DV2", //22
-            "DV3", //23
-            "CNF", //24
-            "25",
-            "26",
-            "27",
-            "28",
-            "29",
-            "30",
-            "31",
-            "PRM", //32
-            "DV1", //33
-            "DV2", //34
-            "DV3", //35
-            "CNF", //36
-    };
+        static const char *club_type_short[] = {
+                "000",
+                "ITA", //1
+                "GER", //2
+                "SPA", //3
+                "HOL", //4
+                "005",
+                "RUS", //6
+                "SCO", //7
+                "BEL", //8
+                "009",
+                "010",
+                "011",
+                "012",
+                "013",
+                "014",
+                "015",
+                "016",
+                "017",
+                "018",
+                "019",
+                "PRM", //20
+                "DV1", //21
+                "DV2", //22
+                "DV3", //23
+                "CNF", //24
+                "25",
+                "26",
+                "27",
+                "28",
+                "29",
+                "30",
+                "31",
+                "PRM", //32
+                "DV1", //33
+                "DV2", //34
+                "DV3", //35
+                "CNF", //36
+        };
 
-    for (int cp = 0; cp < 6; ++cp) {
-        printf("Previous %s finals\n", cup[cp]);
-        for (int h = 0; h < 20; ++h) {
-            if (gamea.cup[cp].history[h].year == 0)
-                continue;
+        for (int cp = 0; cp < 6; ++cp) {
+            printf("Previous %s finals\n", cup[cp]);
+            for (int h = 0; h < 20; ++h) {
+                if (gamea.cup[cp].history[h].year == 0)
+                    continue;
+
+                printf("%4d: (%04x) %3.3s:%16.16s",
+                       gamea.cup[cp].history[h].year,
+                       gamea.cup[cp].history[h].club_idx_winner,
+                       club_type_short[gamea.cup[cp].history[h].type_winner],
+                       gameb.club[gamea.cup[cp].history[h].club_idx_winner].name
+                );
 
-            printf("%4d: (%04x) %3.3s:%16.16s",
-                   gamea.cup[cp].history[h].year,
-                   gamea.cup[cp].history[h].club_idx_winner,
-                   club_type_short[gamea.cup[cp].history[h].type_winner],
-                   gameb.club[gamea.cup[cp].history[h].club_idx_winner].name
-            );
+                printf(" (%04x) %3.3s:%16.16s",
+                       gamea.cup[cp].history[h].club_idx_runner_up,
+                       club_type_short[gamea.cup[cp].history[h].type_runner_up],
+                       gameb.club[gamea.cup[cp].history[h].club_idx_runner_up].name
+                );
+                printf(" %d %d", gamea.cup[cp].history[h].type_winner, gamea.cup[cp].history[h].type_runner_up);
+                printf("\n");
+            }
+            printf("\n");
+        }
+    }
 
-            printf(" (%04x) %3.3s:%16.16s",
-                   gamea.cup[cp].history[h].club_idx_runner_up,
-                   club_type_short[gamea.cup[cp].history[h].type_runner_up],
-                   gameb.club[gamea.cup[cp].history[h].club_idx_runner_up].name
+    if (sections & GAMEA_FIXTURES) {
+        printf("Fixtures\n");
+        for (int i = 0; i < 20; ++i) {
+            printf("%2d: (%04x) %16.16s - (%04x) %16.16s\n", i,
+                   gamea.fixture[i].club_idx1, gameb.club[gamea.fixture[i].club_idx1].name,
+                   gamea.fixture[i].club_idx2, gameb.club[gamea.fixture[i].club_idx2].name
             );
-            printf(" %d %d", gamea.cup[cp].history[h].type_winner, gamea.cup[cp].history[h].type_runner_up);
-            printf("\n");
         }
         printf("\n");
     }
 
-    printf("Fixtures\n");
-    for (int i = 0; i < 20; ++i) {
-        printf("%2d: (%04x) %16.16s - (%04x) %16.16s\n", i,
-               gamea.fixture[i].club_idx1, gameb.club[gamea.fixture[i].club_idx1].name,
-               gamea.fixture[i].club_idx2, gameb.club[gamea.fixture[i].club_idx2].name
-        );
+    if (sections & GAMEA_RAW) {
+        printf("data100");
+        for (int i = 0; i < sizeof(gamea.data100); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%4d] ", i);
+            printf("%02x ", gamea.data100[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
-    printf("data100");
-    for (int i = 0; i < sizeof(gamea.data100); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%4d] ", i);
-        printf("%02x ", gamea.data100[i]);
+    if (sections & GAMEA_TRANSFERS) {
+        printf("--- transfer market ---\n");
+        print_player_row_header();
+        for (int i = 0; i < 45; ++i) {
+            if (gamea.transfer_market[i].player_idx != -1) {
+                struct gameb::club &club = get_club(gamea.transfer_market[i].club_idx);
+                struct gamec::player &p = gamec.player[gamea.transfer_market[i].player_idx];
+                print_player_row(p, club);
+            }
+            printf("\n");
+        }
     }
-    printf("\n");
 
-    printf("--- transfer market ---\n");
-    print_player_row_header();
-    for (int i = 0; i < 45; ++i) {
-        if (gamea.transfer_market[i].player_idx != -1) {
-            struct gameb::club &club = get_club(gamea.transfer_market[i].club_idx);
-            struct gamec::player &p = gamec.player[gamea.transfer_market[i].player_idx];
-            print_player_row(p, club);
+    if (sections & GAMEA_RAW) {
+        printf("data10z");
+        for (int i = 0; i < sizeof(gamea.data10z); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%4d] ", i);
+            printf("%02x ", gamea.data10z[i]);
         }
         printf("\n");
     }
 
-    printf("data10z");
-    for (int i = 0; i < sizeof(gamea.data10z); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%4d] ", i);
-        printf("%02x ", gamea.data10z[i]);
-    }
-    printf("\n");
-
-    printf("--- Transfer list ---\n");
-    for (int i = 0; i < 6; ++i) {
-        if (gamea.transfer[i].player_idx == -1)
-            continue;
+    if (sections & GAMEA_TRANSFERS) {
+        printf("--- Transfer list ---\n");
+        for (int i = 0; i < 6; ++i) {
+            if (gamea.transfer[i].player_idx == -1)
+                continue;
 
-        printf("%12.12s was transferred from %16.16s\n"
-               "to %16.16s for a fee of £%d\n",
-               gamec.player[gamea.transfer[i].player_idx].name,
-               gameb.club[gamea.transfer[i].from_club_idx].name,
-               gameb.club[gamea.transfer[i].to_club_idx].name,
-               gamea.transfer[i].fee);
+            printf("%12.12s was transferred from %16.16s\n"
+                   "to %16.16s for a fee of £%d\n",
+                   gamec.player[gamea.transfer[i].player_idx].name,
+                   gameb.club[gamea.transfer[i].from_club_idx].name,
+                   gameb.club[gamea.transfer[i].to_club_idx].name,
+                   gamea.transfer[i].fee);
+        }
     }
 
-    for (int i = 0; i < sizeof(gamea.data101); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%4d] ", i);
-        printf("%02x ", gamea.data101[i]);
+    if (sections & GAMEA_RAW) {
+        for (int i = 0; i < sizeof(gamea.data101); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%4d] ", i);
+            printf("%02x ", gamea.data101[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
-    if (gamea.retired_manager_club_idx != -1) {
-        printf("%16.16s has retired from (%04x) %16.16s\n",
-               gamea.manager_name,
-               gamea.retired_manager_club_idx,
-               gameb.club[gamea.retired_manager_club_idx].name);
-    }
+    if (sections & GAMEA_NEWS) {
+        if (gamea.retired_manager_club_idx != -1) {
+            printf("%16.16s has retired from (%04x) %16.16s\n",
+                   gamea.manager_name,
+                   gamea.retired_manager_club_idx,
+                   gameb.club[gamea.retired_manager_club_idx].name);
+        }
 
-    if (gamea.new_manager_club_idx != -1) {
-        printf("%16.16s has become the new manager of\n(%04x) %16.16s\n",
-               gameb.club[gamea.new_manager_club_idx].manager,
-               gamea.new_manager_club_idx,
-               gameb.club[gamea.new_manager_club_idx].name);
+        if (gamea.new_manager_club_idx != -1) {
+            printf("%16.16s has become the new manager of\n(%04x) %16.16s\n",
+                   gameb.club[gamea.new_manager_club_idx].manager,
+                   gamea.new_manager_club_idx,
+                   gameb.club[gamea.new_manager_club_idx].name);
+        }
     }
 
-    for (int i = 0; i < sizeof(gamea.data10w); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%4d] ", i);
-        printf("%02x ", gamea.data10w[i]);
+    if (sections & GAMEA_RAW) {
+        for (int i = 0; i < sizeof(gamea.data10w); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%4d] ", i);
+            printf("%02x ", gamea.data10w[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
-    printf("Year: %4d, Week: %2d, Day: %3.3s (turn: %3d)\n",
-           gamea.year, (gamea.turn / 3) + 1, day[gamea.turn % 3], gamea.turn);
+    if (sections & GAMEA_DATE) {
+        printf("Year: %4d, Week: %2d, Day: %3.3s (turn: %3d)\n",
+               gamea.year, (gamea.turn / 3) + 1, day[gamea.turn % 3], gamea.turn);
 
-    for (int i = 0; i < sizeof(gamea.data10x); ++i) {
-        printf("(%04x) %d", gamea.data10x[i], gamea.data10x[i]);
+        for (int i = 0; i < sizeof(gamea.data10x); ++i) {
+            printf("(%04x) %d", gamea.data10x[i], gamea.data10x[i]);
 
-        switch (i) {
-            case 10:
-                printf(" cup matches");
-        }
+            switch (i) {
+                case 10:
+                    printf(" cup matches");
+            }
 
-        printf("\n");
+            printf("\n");
+        }
     }
 
-    dump_gamea_manager(); // XXX don't care about second player
+    if (sections & GAMEA_MANAGER) {
+        dump_gamea_manager(0, sections); // XXX don't care about second player
+    }
 
-    for (int i = 0; i < sizeof(gamea.data200); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%03d] ", i);
-        printf("%02x ", gamea.data200[i]);
+    if (sections & GAMEA_RAW) {
+        for (int i = 0; i < sizeof(gamea.data200); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%03d] ", i);
+            printf("%02x ", gamea.data200[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
-    printf("inc_number1: %d\n", gamea.inc_number1);
-    printf("inc_number2: %d\n", gamea.inc_number2);
-    printf("inc_number3: %d\n", gamea.inc_number3);
+    if (sections & GAMEA_MISC) {
+        printf("inc_number1: %d\n", gamea.inc_number1);
+        printf("inc_number2: %d\n", gamea.inc_number2);
+        printf("inc_number3: %d\n", gamea.inc_number3);
+    }
 
 }
 
-void dump_gamea_manager(int player) {
+void dump_gamea_manager(int player, unsigned sections) {
     struct gamea::manager &manager = gamea.manager[player];
     printf("Manager: %16.16s\n", manager.name);
 
@@ -825,12 +1798,14 @@ void dump_gamea_manager(int player) {
         printf("Youth team player: %12.12s\n",
                gamec.player[manager.youth_player].name);
 
-    for (int i = 0; i < sizeof(manager.data147); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%3d] ", i);
-        printf("%02x ", manager.data147[i]);
+    if (sections & GAMEA_RAW) {
+        for (int i = 0; i < sizeof(manager.data147); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%3d] ", i);
+            printf("%02x ", manager.data147[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
     printf("Scouts\n");
     for (int i = 0; i < 4; ++i) {
@@ -867,12 +1842,14 @@ void dump_gamea_manager(int player) {
     printf("Number 3            :%d\n", manager.number3);
     printf("Money from directors:%d\n", manager.money_from_directors);
 
-    for (int i = 0; i < sizeof(manager.data149); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%3d] ", i);
-        printf("%02x ", manager.data149[i]);
+    if (sections & GAMEA_RAW) {
+        for (int i = 0; i < sizeof(manager.data149); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%3d] ", i);
+            printf("%02x ", manager.data149[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
     printf("--News--\n");
     for (int i = 0; i < 8; ++i) {
@@ -1015,13 +1992,15 @@ void dump_gamea_manager(int player) {
     /* same 16bit numbers can show up multiple times in this data-pile.
      * suspect it's player (gamec) data somehow
      * */
-    printf("\n--- data150 --- 0x01d6 = 365. repeats alot.\n");
-    for (int i = 0; i < sizeof(manager.data150); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%4d]", i);
-        printf(" %02x", manager.data150[i]);
+    if (sections & GAMEA_RAW) {
+        printf("\n--- data150 --- 0x01d6 = 365. repeats alot.\n");
+        for (int i = 0; i < sizeof(manager.data150); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%4d]", i);
+            printf(" %02x", manager.data150[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
     struct gamea::manager::stadium &stadium = manager.stadium;
 
@@ -1340,12 +2319,14 @@ void dump_gamea_manager(int player) {
                manager.manager_history[i].agn);
     printf("\n");
 
-    for (int i = 0; i < sizeof(manager.data159); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%03d] ", i);
-        printf("%02x ", manager.data159[i]);
+    if (sections & GAMEA_RAW) {
+        for (int i = 0; i < sizeof(manager.data159); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%03d] ", i);
+            printf("%02x ", manager.data159[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
     printf("       Previous clubs   From To   Mngr Drct Sprt\n");
     for (int i = 0; i < 4; ++i) {
@@ -1385,12 +2366,14 @@ void dump_gamea_manager(int player) {
     printf("\n");
 
 
-    for (int i = 0; i < sizeof(manager.data160); ++i) {
-        if (i % 16 == 0)
-            printf("\n[%03d] ", i);
-        printf("%02x ", manager.data160[i]);
+    if (sections & GAMEA_RAW) {
+        for (int i = 0; i < sizeof(manager.data160); ++i) {
+            if (i % 16 == 0)
+                printf("\n[%03d] ", i);
+            printf("%02x ", manager.data160[i]);
+        }
+        printf("\n");
     }
-    printf("\n");
 
     for (int i = 0; i < 8; ++i)
         printf("tactic[%d].name: %20.20s\n", i, manager.tactic[i].name);
@@ -1455,30 +2438,6 @@ void dump_club(struct gameb::club &club) {
     printf("\n");
 
 
-    static const char *match_type[] = {
-            "0",
-            "1",
-            "Division 2 match",
-            "Division 3 match",
-            "Conference match",
-            "5",
-            "6",
-            "Division 2 delay",
-            "Division 3 delay",
-            "Conference delay",
-            "F.A. cup match",
-            "League cup match",
-            "12",
-            "Cup winners cup",
-            "14",
-            "Charity shield",
-            "16",
-            "17",
-            "18",
-            "Friendly",
-            "20", "21", "22", "23", "24", "25",
-            "26", "27", "28", "29", "30", "31"
-    };
     static const char game[] = {
             'H', // home          0
             'H', // home_friendly 1
@@ -1502,12 +2461,12 @@ void dump_club(struct gameb::club &club) {
                 struct gameb::club &opponent = get_club(rnd.opponent_idx);
 
                 printf("%3s:%-2d %-16.16s %c %3.3s %16.16s",
-                       day[d], w + 1, match_type[rnd.type], game[rnd.game], "...", opponent.name);
+                       day[d], w + 1, timetable_match_type[rnd.type], game[rnd.game], "...", opponent.name);
             } else {
                 struct gameb::club &opponent = get_club(rnd.opponent_idx);
 
                 printf("%3s:%-2d %-16.16s %c %d:%d %16.16s",
-                       day[d], w + 1, match_type[rnd.type], game[rnd.game], rnd.home, rnd.away, opponent.name);
+                       day[d], w + 1, timetable_match_type[rnd.type], game[rnd.game], rnd.home, rnd.away, opponent.name);
             }
 
             printf(" club: %02x, result: %02x b3: %02x\n",
@@ -1516,80 +2475,309 @@ void dump_club(struct gameb::club &club) {
     }
 }
 
-void print_club_name(int16_t idx, bool newline) {
-    assert(idx >= -1 && idx < CLUB_IDX_MAX);
-
-    if (idx == -1)
-        printf("Club: %d%s", idx, newline ? "\n" : "");
+void print_fixture(const struct fixture &f) {
+    if (f.played())
+        printf("%3s:%-2d %-16.16s %16.16s %2d:%-2d %-16.16s\n",
+               day[f.day], f.week + 1, timetable_match_type[f.type],
+               gameb.club[f.home_idx].name, f.home_goals, f.away_goals, gameb.club[f.away_idx].name);
     else
-        printf("Club: %16.16s%s", gameb.club[idx].name, newline ? "\n" : "");
+        printf("%3s:%-2d %-16.16s %16.16s  ...  %-16.16s\n",
+               day[f.day], f.week + 1, timetable_match_type[f.type],
+               gameb.club[f.home_idx].name, gameb.club[f.away_idx].name);
 }
 
-void dump_gamec() {
-    for (int i = 0; i < 3932; ++i) {
-        struct gamec::player &player = get_player(i);
-        dump_player(player);
+void dump_standings(const standings &tables, const std::vector<struct table_mismatch> &mismatches,
+                    FILE *out) {
+    for (int div = 0; div < 5; ++div) {
+        fprintf(out, "%s\n", division[div]);
+        fprintf(out, "Pos Club              P  W  D  L   F   A  GD PTS\n");
+        for (const struct standing &s : tables.division(div)) {
+            fprintf(out, "%3d %16.16s %2d %2d %2d %2d %3d %3d %+3d %3d\n",
+                    s.position, gameb.club[s.club_idx].name,
+                    s.played(), s.won(), s.drawn(), s.lost(),
+                    s.goals_for(), s.goals_against(), s.goal_difference(), s.points());
+        }
+        fprintf(out, "\n");
+    }
+
+    fprintf(out, "%zu mismatch%s with the stored table\n", mismatches.size(), mismatches.size() == 1 ? "" : "es");
+    for (const struct table_mismatch &m : mismatches) {
+        fprintf(out, "(%04x) %16.16s %s: stored %d, computed %d\n",
+                m.club_idx, gameb.club[m.club_idx].name, m.column, m.stored, m.computed);
+    }
+}
+
+void dump_lineup(const struct lineup &l, const struct formation &f) {
+    printf("Lineup for %16.16s (%s)\n", gameb.club[l.club_idx].name, f.name);
+    for (int i = 0; i < LINEUP_STARTERS; ++i) {
+        if (l.starter[i] == -1) {
+            printf("  %c  %-12s\n", l.role[i], "-");
+            continue;
+        }
+        const struct gamec::player &p = gamec.player[l.starter[i]];
+        printf("  %c  %-12.12s %2d  HN %2d TK %2d PS %2d SH %2d FT %2d\n",
+               l.role[i], p.name, role_rating(p, l.role[i]), p.hn, p.tk, p.ps, p.sh, p.ft);
+    }
+    printf("Substitutes\n");
+    for (int16_t idx : l.substitute) {
+        if (idx == -1)
+            continue;
+        const struct gamec::player &p = gamec.player[idx];
+        printf("     %-12.12s     HN %2d TK %2d PS %2d SH %2d FT %2d\n",
+               p.name, p.hn, p.tk, p.ps, p.sh, p.ft);
     }
+    printf("Strength: %d\n\n", l.strength);
 }
 
-void dump_player(struct gamec::player &p) {
+void dump_strength(const struct formation &f) {
+    std::vector<std::pair<struct lineup, int>> lineups;
 
-    static const char *train[] = {
-            "None",
-            "Handle",
-            "Tackles",
-            "Passes",
-            "Shots",
-            "Headers",
-            "Control",
-            "Fitness",
-            "General"
-    };
-    static const char *intense[] = {"Low", "Medium", "Hard", "V.Hard"};
+    for (int div = 0; div < 5; ++div) {
+        for (int i = division_offset[div]; i < division_offset[div + 1]; ++i) {
+            struct lineup l{};
+            pick_lineup(gamea.club_index.all[i], f, l);
+            lineups.emplace_back(l, div);
+        }
+    }
+
+    std::stable_sort(lineups.begin(), lineups.end(), [](const auto &a, const auto &b) {
+        return a.first.strength > b.first.strength;
+    });
 
-    printf("Player: %12.12s\n", p.name);
-    printf("Age: %2d\n", p.age);
-    printf("Wage: %5d\n", p.wage);
-    printf("Insure: %d %5d\n", p.ins, p.ins_cost);
-    printf("Handling : %2d\n", p.hn);
-    printf("Tackling : %2d\n", p.tk);
-    printf("Passing  : %2d\n", p.ps);
-    printf("Shooting : %2d\n", p.sh);
-    printf("Heading  : %2d\n", p.hd);
-    printf("Control  : %2d\n", p.cr);
-    printf("Fitness  : %2d\n", p.ft);
-    printf("Aggr'sion: %2d\n", p.aggr);
-    printf("Morale   : %2d\n", p.morl);
-    printf("Foot     : %5.5s\n", foot_long[p.foot]);
+    printf("Rank Club             Division          Strength\n");
+    for (size_t i = 0; i < lineups.size(); ++i) {
+        printf("%4zu %16.16s %-17.17s %8d\n",
+               i + 1, gameb.club[lineups[i].first.club_idx].name, division[lineups[i].second],
+               lineups[i].first.strength);
+    }
     printf("\n");
-    printf("Played  : %3d\n", p.played);
-    printf("Scored  : %3d\n", p.scored);
-    printf("Conceded: \n");
-    printf("DPTS    :  %d\n", p.dpts);
-    printf("Training : %7s, %6s\n", train[p.train], intense[p.intense]);
-
-    printf("%d year contract\n", p.contract);
-    printf("%02x %02x %02x %02x %02x %02x %02x\n",
-           p.u13, p.u15, p.u17, p.u19, p.u21, p.u23, p.u25);
-    printf("%02x %02x\n", p.unk2, p.unk5);
-
-    char period_label[8];
-    if (p.period_type == 0 || p.period_type == 1) {
-        sprintf(period_label, "matches");
-    } else {
-        sprintf(period_label, "weeks");
+}
+
+void dump_shortlist(const struct shortlist &plan, const struct formation &f, int64_t budget) {
+    printf("Shortlist for %16.16s (%s), budget %lld\n", gameb.club[plan.club_idx].name, f.name, (long long) budget);
+    for (const struct transfer_candidate &c : plan.signings) {
+        struct gamec::player &p = gamec.player[c.player_idx];
+        printf("  (%04x) %12.12s %c %16.16s %-6s fee %8lld cost %8lld  +%d\n",
+               c.player_idx, p.name, determine_player_type(p), gameb.club[c.club_idx].name,
+               c.listed ? "listed" : "free", (long long) c.fee, (long long) c.cost, c.gain);
     }
-    printf("%s %d %s\n\n", period_types[p.period_type], (p.period + 3 - 1) / 3, period_label);
+    printf("Strength %d -> %d, cost %lld (%s, %llu nodes)\n\n",
+           plan.strength_before, plan.strength_after, (long long) plan.cost,
+           plan.optimal ? "optimal" : "node limit reached", (unsigned long long) plan.nodes);
 }
 
-void print_player_row(struct club_player &club_player) {
-    print_player_row(club_player.player, club_player.club);
+void dump_season_odds(const season_simulator &simulator, const struct season_odds &odds) {
+    for (int div = 0; div < 5; ++div) {
+        std::vector<int> clubs;
+        for (int c = 0; c < CLUB_IDX_MAX; ++c) {
+            if (odds.division[c] == div)
+                clubs.push_back(c);
+        }
+        std::stable_sort(clubs.begin(), clubs.end(), [&](int a, int b) { return odds.points[a] > odds.points[b]; });
+
+        printf("%s\n", division[div]);
+        printf("Club             Str   xPts  Title  Promo  Releg\n");
+        for (int c : clubs) {
+            printf("%16.16s %4d %6.1f %5.1f%% %5.1f%% %5.1f%%\n",
+                   gameb.club[c].name, simulator.strength(c), odds.points[c],
+                   100 * odds.title[c], 100 * odds.promotion[c], 100 * odds.relegation[c]);
+        }
+        printf("\n");
+    }
 }
 
-void print_player_row(struct gamec::player &p, struct gameb::club &club) {
-    printf("%16.16s %1c %12.12s %2d %2d %2d %2d %2d %2d %2d %1.1s %1d %1d %2d %5d\n", club.name,
-           determine_player_type(p), p.name, p.hn, p.tk, p.ps, p.sh, p.hd, p.cr, p.ft, foot_short[p.foot], p.aggr,
-           p.morl, p.age, p.wage);
+void dump_cup(const struct cup_bracket &bracket) {
+    printf("%s\n", bracket.competition->name);
+    for (int r = 0; r < bracket.rounds; ++r) {
+        printf("Round %d\n", r + 1);
+        for (const struct cup_tie *t : bracket.round(r)) {
+            for (int l = 0; l < t->legs; ++l) {
+                const struct cup_leg &leg = t->leg[l];
+                if (leg.home_goals < 0 || leg.away_goals < 0)
+                    printf("  %16.16s   v   %-16.16s\n", gameb.club[leg.home_idx].name, gameb.club[leg.away_idx].name);
+                else
+                    printf("  %16.16s %2d-%-2d %-16.16s (%d)\n", gameb.club[leg.home_idx].name, leg.home_goals,
+                           leg.away_goals, gameb.club[leg.away_idx].name, leg.audience);
+            }
+            if (t->legs == 2 && t->played())
+                printf("    Aggregate %d-%d\n", t->goals(0), t->goals(1));
+            if (t->winner != -1)
+                printf("    Through: %s\n", gameb.club[t->winner].name);
+        }
+    }
+    printf("\n");
+}
+
+void dump_cup_odds(const struct cup_bracket &bracket, const struct cup_odds &odds) {
+    printf("%s ODDS (%d simulations)\n", bracket.competition->name, odds.simulations);
+
+    std::vector<int> clubs;
+    for (int c = 0; c < CLUB_IDX_MAX; ++c) {
+        if (odds.entered[c])
+            clubs.push_back(c);
+    }
+    std::stable_sort(clubs.begin(), clubs.end(), [&](int a, int b) { return odds.win[a] > odds.win[b]; });
+
+    printf("Club            ");
+    for (int r = 0; r < odds.rounds; ++r)
+        printf("    R%-2d", r + 1);
+    printf("    Win\n");
+    for (int c : clubs) {
+        printf("%16.16s", gameb.club[c].name);
+        for (int r = 0; r < odds.rounds; ++r)
+            printf(" %5.1f%%", 100 * odds.reach[c][r]);
+        printf(" %5.1f%%\n", 100 * odds.win[c]);
+    }
+    printf("\n");
+}
+
+void dump_attendance_fit(const struct attendance_fit &fit) {
+    static const char *name[ATTENDANCE_FEATURES] = {
+            "intercept", "log(price)", "log(capacity)", "safety", "facilities", "division", "terrace"
+    };
+    double beta[ATTENDANCE_FEATURES];
+
+    fit.model.coefficients(beta);
+    for (int i = 0; i < ATTENDANCE_FEATURES; ++i)
+        printf("%-14s %9.4f\n", name[i], beta[i]);
+    printf("RMSE %.4f (log attendance), R2 %.3f\n", fit.rmse, fit.r2);
+    printf("\n");
+}
+
+static void print_price_scenario(const char *label, const struct price_scenario &s) {
+    printf("%-8s %5d %5d %9lld %10lld %10lld ", label, s.seating, s.terrace, (long long) s.receipts,
+           (long long) s.final_balance, (long long) s.lowest_balance);
+    if (s.overdraft_turn == -1)
+        printf("-\n");
+    else
+        printf("week %d %s\n", s.overdraft_turn / TIMETABLE_DAYS + 1, day[s.overdraft_turn % TIMETABLE_DAYS]);
+}
+
+void dump_finance(const struct finance_projection &p, const struct attendance_model &model, int low, int high, int threads) {
+    printf("FINANCE %s\n", gameb.club[p.club_idx].name);
+    printf("Balance:       %10lld\n", (long long) p.balance);
+    printf("Running:       %+10.0f per turn\n", p.running);
+    printf("Home matches:  %4d league, %d cup\n", p.league_homes.empty() ? 0 : p.league_homes.back(),
+           p.cup_homes.empty() ? 0 : p.cup_homes.back());
+    printf("Projected gate %5.0f seating, %5.0f terrace\n",
+           model.predict(p.stand[0][STAND_SEATING], p.offset[STAND_SEATING]),
+           model.predict(p.stand[0][STAND_TERRACE], p.offset[STAND_TERRACE]));
+    printf("\n");
+
+    std::vector<struct price_scenario> scenarios = sweep_prices(p, model, low, high, threads);
+    size_t overdrawn = std::count_if(scenarios.begin(), scenarios.end(),
+                                     [](const struct price_scenario &s) { return s.overdraft_turn != -1; });
+    std::stable_sort(scenarios.begin(), scenarios.end(), [](const struct price_scenario &a, const struct price_scenario &b) {
+        return a.final_balance > b.final_balance;
+    });
+
+    printf("Prices   Seats Terr.  Receipts      Final     Lowest Overdrawn\n");
+    print_price_scenario("Current", current_prices(p, model));
+    for (size_t i = 0; i < scenarios.size() && i < 10; ++i)
+        print_price_scenario(i ? "" : "Best", scenarios[i]);
+    printf("%zu of %zu price pairs go overdrawn\n", overdrawn, scenarios.size());
+}
+
+void print_club_name(int16_t idx, bool newline) {
+    assert(idx >= -1 && idx < CLUB_IDX_MAX);
+
+    if (idx == -1)
+        printf("Club: %d%s", idx, newline ? "\n" : "");
+    else
+        printf("Club: %16.16s%s", gameb.club[idx].name, newline ? "\n" : "");
+}
+
+void dump_gamec(unsigned fields) {
+    for (int i = 0; i < 3932; ++i) {
+        struct gamec::player &player = get_player(i);
+        dump_player(player, fields);
+    }
+}
+
+void dump_player(struct gamec::player &p, unsigned fields) {
+
+    static const char *train[] = {
+            "None",
+            "Handle",
+            "Tackles",
+            "Passes",
+            "Shots",
+            "Headers",
+            "Control",
+            "Fitness",
+            "General"
+    };
+    static const char *intense[] = {"Low", "Medium", "Hard", "V.Hard"};
+
+    if (fields & PLAYER_NAME)
+        printf("Player: %12.12s\n", p.name);
+    if (fields & PLAYER_AGE)
+        printf("Age: %2d\n", p.age);
+    if (fields & PLAYER_WAGE)
+        printf("Wage: %5d\n", p.wage);
+    if (fields & PLAYER_INS)
+        printf("Insure: %d %5d\n", p.ins, p.ins_cost);
+    if (fields & PLAYER_HN)
+        printf("Handling : %2d\n", p.hn);
+    if (fields & PLAYER_TK)
+        printf("Tackling : %2d\n", p.tk);
+    if (fields & PLAYER_PS)
+        printf("Passing  : %2d\n", p.ps);
+    if (fields & PLAYER_SH)
+        printf("Shooting : %2d\n", p.sh);
+    if (fields & PLAYER_HD)
+        printf("Heading  : %2d\n", p.hd);
+    if (fields & PLAYER_CR)
+        printf("Control  : %2d\n", p.cr);
+    if (fields & PLAYER_FT)
+        printf("Fitness  : %2d\n", p.ft);
+    if (fields & PLAYER_AGGR)
+        printf("Aggr'sion: %2d\n", p.aggr);
+    if (fields & PLAYER_MORL)
+        printf("Morale   : %2d\n", p.morl);
+    if (fields & PLAYER_FOOT)
+        printf("Foot     : %5.5s\n", foot_long[p.foot]);
+    if (fields == PLAYER_ALL)
+        printf("\n");
+    if (fields & PLAYER_PLAYED)
+        printf("Played  : %3d\n", p.played);
+    if (fields & PLAYER_SCORED) {
+        printf("Scored  : %3d\n", p.scored);
+        printf("Conceded: \n");
+    }
+    if (fields & PLAYER_DPTS)
+        printf("DPTS    :  %d\n", p.dpts);
+    if (fields & PLAYER_TRAIN)
+        printf("Training : %7s, %6s\n", train[p.train], intense[p.intense]);
+
+    if (fields & PLAYER_CONTRACT)
+        printf("%d year contract\n", p.contract);
+    if (fields & PLAYER_UNKNOWN) {
+        printf("%02x %02x %02x %02x %02x %02x %02x\n",
+               p.u13, p.u15, p.u17, p.u19, p.u21, p.u23, p.u25);
+        printf("%02x %02x\n", p.unk2, p.unk5);
+    }
+
+    if (fields & PLAYER_PERIOD) {
+        char period_label[8];
+        if (p.period_type == 0 || p.period_type == 1) {
+            sprintf(period_label, "matches");
+        } else {
+            sprintf(period_label, "weeks");
+        }
+        printf("%s %d %s\n", period_types[p.period_type], (p.period + 3 - 1) / 3, period_label);
+    }
+    printf("\n");
+}
+
+void print_player_row(struct club_player &club_player, FILE *out) {
+    print_player_row(club_player.player, club_player.club, out);
+}
+
+void print_player_row(struct gamec::player &p, struct gameb::club &club, FILE *out) {
+    fprintf(out, "%16.16s %1c %12.12s %2d %2d %2d %2d %2d %2d %2d %1.1s %1d %1d %2d %5d\n", club.name,
+            determine_player_type(p), p.name, p.hn, p.tk, p.ps, p.sh, p.hd, p.cr, p.ft, foot_short[p.foot], p.aggr,
+            p.morl, p.age, p.wage);
 }
 
 void print_player_name(int16_t idx, bool newline) {
@@ -1956,93 +3144,1112 @@ void dump_gamea_match_summary() {
     printf("\n\n");
 }
 
-void print_player_row_header() {
-    printf("CLUB NAME        T PLAYER NAME  HN TK PS SH HD CR FT F M A AG  WAGES\n");
+void print_player_row_header(FILE *out) {
+    fprintf(out, "CLUB NAME        T PLAYER NAME  HN TK PS SH HD CR FT F M A AG  WAGES\n");
 }
 
-void soup_up(int player) {
-    printf("Souping up!");
+void soup_up(int player, const struct boost_profile &profile, position_source positions, edit_journal *journal) {
+    struct boost_summary summary{};
 
-    struct gamea::manager &manager = gamea.manager[player];
+    boost_club(gamea.manager[player].club_idx, profile, positions, summary, journal);
+    print_boost_summary(summary);
+}
 
-    print_club_name(manager.club_idx);
+void print_boost_summary(const struct boost_summary &summary) {
+    printf("Boosted %d clubs: %d players (%d G, %d D, %d M, %d A), %d staff\n",
+           summary.clubs, summary.players, summary.role[0], summary.role[1], summary.role[2], summary.role[3],
+           summary.staff);
+}
 
-    for (int i = 0; i < 20; ++i) {
-        struct gamea::manager::employee &employee = manager.employee[i];
-        printf("Employee: %14.14s\n", employee.name);
-        employee.skill = 99;
-        //employee.age = i % 16;
+void dump_free_players(FILE *out) {
+    print_player_row_header(out);
+    std::vector<club_player> free_players = find_free_players();
+
+    for (club_player &free_player: free_players) {
+        print_player_row(free_player, out);
     }
+}
 
-    struct gameb::club &club = gameb.club[manager.club_idx];
+/* Quoted, with embedded quotes doubled, so commas and quotes in names survive */
+std::string csv_quote(const std::string &text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+template <typename T>
+void export_records(const T *records, int count) {
+    printf("idx");
+    for (const struct field_desc &f : schema<T>::fields) {
+        if (f.type == FIELD_BLOCK)
+            continue;
+
+        if (f.count == 1) {
+            printf(",%s", f.name);
+        } else {
+            for (int e = 0; e < f.count; ++e)
+                printf(",%s[%d]", f.name, e);
+        }
+    }
+    printf("\n");
+
+    for (int i = 0; i < count; ++i) {
+        printf("%d", i);
+        visit_fields(records[i], [](const struct field_desc &f, const uint8_t *bytes) {
+            if (f.type == FIELD_BLOCK)
+                return;
+
+            for (int e = 0; e < f.count; ++e) {
+                if (is_numeric(f))
+                    printf(",%lld", (long long) get_field(bytes, f, e));
+                else if (f.type == FIELD_TEXT)
+                    printf(",%s", csv_quote(field_to_string(bytes, f, e)).c_str());
+                else
+                    printf(",%s", field_to_string(bytes, f, e).c_str());
+            }
+        });
+        printf("\n");
+    }
+}
+
+void dump_match_stats(const match_stats &stats) {
+    const match_stats::player_columns &p = stats.player;
+    const match_stats::club_columns &c = stats.club;
+    std::vector<int16_t> player_club(3932, -1);
+    std::vector<int16_t> order;
+
+    for (int i = 0; i < CLUB_IDX_MAX; ++i) {
+        for (int j = 0; j < 24; ++j) {
+            if (gameb.club[i].player_index[j] >= 0 && gameb.club[i].player_index[j] < 3932)
+                player_club[gameb.club[i].player_index[j]] = i;
+        }
+    }
+
+    printf("%zu matches\n\n", stats.matches());
+
+    for (int16_t i = 0; i < 3932; ++i) {
+        if (p.appearances[i])
+            order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&p](int16_t a, int16_t b) {
+        return p.appearances[a] > p.appearances[b];
+    });
+
+    printf("PLAYER NAME  CLUB NAME        AP GL CD  SA  SM  SS   TA   TW  TW%%    PA   PB  PS%%\n");
+    for (int16_t i : order) {
+        printf("%12.12s %16.16s %2d %2d %2d %3d %3d %3d %4d %4d %3d%% %5d %4d %3d%%\n",
+               gamec.player[i].name,
+               player_club[i] == -1 ? "" : gameb.club[player_club[i]].name,
+               p.appearances[i], p.goals[i], p.cards[i],
+               p.shots_attempted[i], p.shots_missed[i], p.shots_saved[i],
+               p.tackles_attempted[i], p.tackles_won[i],
+               p.tackles_attempted[i] ? (int) (100 * p.tackles_won[i] / p.tackles_attempted[i]) : 0,
+               p.passes_attempted[i], p.passes_bad[i],
+               p.passes_attempted[i] ? (int) (100 * (p.passes_attempted[i] - p.passes_bad[i]) / p.passes_attempted[i]) : 0);
+    }
+    printf("\n");
 
-    for (int p = 0; p < 24; ++p) {
-        if (club.player_index[p] == -1)
+    printf("CLUB NAME         P  W  D  L   F   A   SA   TA   TW  TW%%    PA   PB  PS%%  AVG AUD\n");
+    for (int i = 0; i < CLUB_IDX_MAX; ++i) {
+        if (!c.played[i])
             continue;
 
-        print_player_name(club.player_index[p]);
-        struct gamec::player &player = gamec.player[club.player_index[p]];
+        printf("%16.16s %2d %2d %2d %2d %3d %3d %4d %4d %4d %3d%% %5d %4d %3d%% %8d\n",
+               gameb.club[i].name,
+               c.played[i], c.won[i], c.drawn[i], c.lost[i], c.goals_for[i], c.goals_against[i],
+               c.shots_attempted[i], c.tackles_attempted[i], c.tackles_won[i],
+               c.tackles_attempted[i] ? (int) (100 * c.tackles_won[i] / c.tackles_attempted[i]) : 0,
+               c.passes_attempted[i], c.passes_bad[i],
+               c.passes_attempted[i] ? (int) (100 * (c.passes_attempted[i] - c.passes_bad[i]) / c.passes_attempted[i]) : 0,
+               (int) (c.audience[i] / c.played[i]));
+    }
+}
+
+struct apply_target {
+    std::string game_path;
+    int game_nr = 0;
+    std::unique_ptr<struct gamea> game_data;
+    std::unique_ptr<struct gameb> club_data;
+    std::unique_ptr<struct gamec> player_data;
+    bool applied = false;
+    std::string error;
+};
+
+static void apply_to_savegame(const std::vector<struct edit_command> &commands, struct apply_target &target) {
+    target.game_data = std::make_unique<struct gamea>();
+    target.club_data = std::make_unique<struct gameb>();
+    target.player_data = std::make_unique<struct gamec>();
+
+    try {
+        load_binaries(target.game_nr, target.game_path, *target.game_data, *target.club_data, *target.player_data);
+
+        edit_journal journal(*target.game_data, *target.club_data, *target.player_data);
+        if (!apply_edits(commands, target.game_path, journal, target.error,
+                         *target.game_data, *target.club_data, *target.player_data))
+            return;
+
+        save_binaries(target.game_nr, target.game_path, *target.game_data, *target.club_data, *target.player_data);
+        target.applied = true;
+
+        /* Only gamea is needed afterwards, for SAVES.DIR */
+        target.club_data.reset();
+        target.player_data.reset();
+    } catch (const std::exception &e) {
+        target.error = e.what();
+    }
+}
+
+int apply_main(char *command, int argc, char *argv[]) {
+    int c, optindex = 0, threads = 0;
+    std::vector<int> game_nrs;
 
-        player.hn = 97;
-        player.tk = 97;
-        player.ps = 97;
-        player.sh = 97;
+    static struct option long_options[] = {
+            {"game",    required_argument, nullptr, 'g'},
+            {"threads", required_argument, nullptr, 0 },
+            {"help",    no_argument,       nullptr, 'h'},
+            {nullptr,   0,                 nullptr, 0}
+    };
 
-        switch (p) {
+    while ((c = getopt_long(argc, argv, "g:h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 'g': {
+                int game_nr = atoi(optarg);
+                if (game_nr < 1 || game_nr > 8) {
+                    fprintf(stderr, "Invalid savegame number: %d\n", game_nr);
+                    print_help(command);
+                    return EXIT_FAILURE;
+                }
+                game_nrs.push_back(game_nr);
+                break;
+            }
             case 0:
-            case 11:
-            case 15:
-                player.hn = 99;
+                if (0 == strcmp(long_options[optindex].name, "threads")) {
+                    threads = atoi(optarg);
+                    if (threads < 1) {
+                        fprintf(stderr, "Invalid number of threads: %s\n", optarg);
+                        return EXIT_FAILURE;
+                    }
+                }
                 break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
+            default:
+                print_help(command);
+                return EXIT_FAILURE;
+        }
+    }
 
-            case 1:
-            case 2:
-            case 4:
-            case 5:
-            case 12:
-            case 16:
-            case 19:
-            case 22:
-                player.tk = 99;
+    if (game_nrs.empty() || argc - optind < 2) {
+        fprintf(stderr, "apply needs a savegame number, an edit script and a game path\n");
+        print_help(command);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<struct edit_command> commands;
+    std::string error;
+    bool parsed;
+
+    if (0 == strcmp(argv[optind], "-")) {
+        parsed = parse_edit_script(std::cin, commands, error);
+    } else {
+        std::ifstream script(argv[optind]);
+        if (!script) {
+            fprintf(stderr, "Could not open edit script %s\n", argv[optind]);
+            return EXIT_FAILURE;
+        }
+        parsed = parse_edit_script(script, commands, error);
+    }
+
+    if (!parsed) {
+        fprintf(stderr, "%s: %s\n", argv[optind], error.c_str());
+        return EXIT_FAILURE;
+    }
+
+    /* A savegame named twice would be written by two threads at once */
+    std::vector<struct apply_target> targets;
+    std::set<std::pair<std::filesystem::path, int>> seen;
+    for (int i = optind + 1; i < argc; ++i) {
+        if (get_pm3_game_type(argv[i]) == PM3_UNKNOWN) {
+            fprintf(stderr, "Did not find %s or %s in %s\n", EXE_STANDARD_FILENAME, EXE_DELUXE_FILENAME, argv[i]);
+            return EXIT_FAILURE;
+        }
+        for (int game_nr : game_nrs) {
+            if (!seen.emplace(std::filesystem::weakly_canonical(argv[i]), game_nr).second)
+                continue;
+            struct apply_target &target = targets.emplace_back();
+            target.game_path = argv[i];
+            target.game_nr = game_nr;
+        }
+    }
+
+    /* Each thread takes the next savegame to load, edit and save until none are left */
+    if (!threads)
+        threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, (int) targets.size()));
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < targets.size(); i = next++)
+            apply_to_savegame(commands, targets[i]);
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread &thread : pool)
+        thread.join();
+
+    /* SAVES.DIR is shared by the savegames of an install, so it is updated afterwards. */
+    int failed = 0;
+    for (struct apply_target &target : targets) {
+        if (!target.applied) {
+            fprintf(stderr, "%s GAME%d: %s\n", target.game_path.c_str(), target.game_nr, target.error.c_str());
+            ++failed;
+            continue;
+        }
+
+        struct saves saves_dir_data{};
+        struct prefs prefs_data{};
+        load_metadata(target.game_path, saves_dir_data, prefs_data);
+        update_metadata(target.game_nr, *target.game_data, saves_dir_data);
+        save_metadata(target.game_path, saves_dir_data, prefs_data);
+
+        printf("%s GAME%d: %zu edits applied\n", target.game_path.c_str(), target.game_nr, commands.size());
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static std::string json_string(const std::string &s) {
+    std::string result = "\"";
+    for (unsigned char ch : s) {
+        if (ch == '"' || ch == '\\') {
+            result += '\\';
+            result += (char) ch;
+        } else if (ch < 0x20 || ch >= 0x7f) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", ch);
+            result += escape;
+        } else {
+            result += (char) ch;
+        }
+    }
+    return result + '"';
+}
+
+static void print_json_string(const std::string &s) {
+    fputs(json_string(s).c_str(), stdout);
+}
+
+void dump_save_diff(const struct save_diff &diff, bool json) {
+    if (!json) {
+        for (const struct record_change &c : diff.changes) {
+            if (c.record == -1)
+                printf("%s.%s", c.record_type, c.field->name);
+            else
+                printf("%s[%d].%s", c.record_type, c.record, c.field->name);
+            if (c.field->count > 1)
+                printf("[%d]", c.element);
+            printf(": %s -> %s\n", c.before.c_str(), c.after.c_str());
+        }
+        printf("%zu changes in %zu of %zu records\n", diff.changes.size(), diff.changed, diff.records);
+        return;
+    }
+
+    printf("{\"records\":%zu,\"changed\":%zu,\"changes\":[", diff.records, diff.changed);
+    for (size_t i = 0; i < diff.changes.size(); ++i) {
+        const struct record_change &c = diff.changes[i];
+        printf("%s\n{\"file\":\"%c\",\"type\":\"%s\",\"record\":%d,\"field\":\"%s\",\"element\":%d,",
+               i ? "," : "", 'A' + c.file, c.record_type, c.record, c.field->name, c.element);
+        if (is_numeric(*c.field)) {
+            printf("\"before\":%s,\"after\":%s}", c.before.c_str(), c.after.c_str());
+        } else {
+            printf("\"before\":");
+            print_json_string(c.before);
+            printf(",\"after\":");
+            print_json_string(c.after);
+            printf("}");
+        }
+    }
+    printf("]}\n");
+}
+
+int diff_main(char *command, int argc, char *argv[]) {
+    int c, optindex = 0;
+    int opt_json = 0;
+
+    static struct option long_options[] = {
+            {"json", no_argument, &opt_json, 1},
+            {"help", no_argument, nullptr,   'h'},
+            {nullptr, 0,          nullptr,   0}
+    };
+
+    while ((c = getopt_long(argc, argv, "h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 0:
                 break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
+            default:
+                print_help(command);
+                return 2;
+        }
+    }
 
-            case 3:
-            case 10:
-            case 13:
-            case 17:
-            case 20:
-                player.ps = 99;
+    if (argc - optind != 2) {
+        fprintf(stderr, "diff needs two savegames\n");
+        print_help(command);
+        return 2;
+    }
+
+    std::unique_ptr<struct gamea> game_data[2] = {std::make_unique<struct gamea>(), std::make_unique<struct gamea>()};
+    std::unique_ptr<struct gameb> club_data[2] = {std::make_unique<struct gameb>(), std::make_unique<struct gameb>()};
+    std::unique_ptr<struct gamec> player_data[2] = {std::make_unique<struct gamec>(), std::make_unique<struct gamec>()};
+
+    for (int i = 0; i < 2; ++i) {
+        std::string error;
+        if (!load_save_spec(argv[optind + i], *game_data[i], *club_data[i], *player_data[i], error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+    }
+
+    struct save_diff diff;
+    diff_saves(*game_data[0], *club_data[0], *player_data[0], *game_data[1], *club_data[1], *player_data[1], diff);
+    dump_save_diff(diff, opt_json);
+
+    return diff.changes.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int delta_main(char *command, int argc, char *argv[]) {
+    int c, optindex = 0;
+    const char *output = nullptr;
+
+    static struct option long_options[] = {
+            {"output", required_argument, nullptr, 'o'},
+            {"help",   no_argument,       nullptr, 'h'},
+            {nullptr, 0,                  nullptr, 0}
+    };
+
+    while ((c = getopt_long(argc, argv, "o:h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 'o':
+                output = optarg;
                 break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
+            default:
+                print_help(command);
+                return EXIT_FAILURE;
+        }
+    }
 
-            case 6:
-            case 7:
-            case 8:
-            case 9:
-            case 14:
-            case 18:
-            case 21:
-            case 23:
-                player.sh = 99;
+    if (argc - optind < 2) {
+        fprintf(stderr, "delta needs at least two savegames\n");
+        print_help(command);
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream file;
+    if (output) {
+        file.open(output, std::ios::binary);
+        if (!file) {
+            fprintf(stderr, "Could not open file for writing: %s\n", output);
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream &out = output ? file : std::cout;
+
+    /* Only the previous savegame is kept while walking the chain */
+    std::unique_ptr<struct gamea> game_data[2] = {std::make_unique<struct gamea>(), std::make_unique<struct gamea>()};
+    std::unique_ptr<struct gameb> club_data[2] = {std::make_unique<struct gameb>(), std::make_unique<struct gameb>()};
+    std::unique_ptr<struct gamec> player_data[2] = {std::make_unique<struct gamec>(), std::make_unique<struct gamec>()};
+
+    for (int i = optind; i < argc; ++i) {
+        int cur = (i - optind) & 1, prev = cur ^ 1;
+        std::string error;
+
+        if (!load_save_spec(argv[i], *game_data[cur], *club_data[cur], *player_data[cur], error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return EXIT_FAILURE;
+        }
+        if (i == optind)
+            continue;
+
+        struct delta_stats stats;
+        try {
+            write_delta(out, *game_data[prev], *club_data[prev], *player_data[prev],
+                        *game_data[cur], *club_data[cur], *player_data[cur], &stats);
+        } catch (const std::runtime_error &e) {
+            fprintf(stderr, "%s\n", e.what());
+            return EXIT_FAILURE;
+        }
+        fprintf(stderr, "%s: %zu records, %zu runs, %zu bytes\n", argv[i], stats.records, stats.runs, stats.bytes);
+    }
+
+    out.flush();
+    return out ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int patch_main(char *command, int argc, char *argv[]) {
+    int c, optindex = 0;
+    const char *output = nullptr;
+    long count = -1;
+
+    static struct option long_options[] = {
+            {"output", required_argument, nullptr, 'o'},
+            {"count",  required_argument, nullptr, 'n'},
+            {"help",   no_argument,       nullptr, 'h'},
+            {nullptr, 0,                  nullptr, 0}
+    };
+
+    while ((c = getopt_long(argc, argv, "o:n:h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 'o':
+                output = optarg;
                 break;
+            case 'n':
+                count = atol(optarg);
+                if (count < 0) {
+                    fprintf(stderr, "Invalid number of deltas: %s\n", optarg);
+                    print_help(command);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
+            default:
+                print_help(command);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (!output || argc - optind < 2) {
+        fprintf(stderr, "patch needs an output savegame, a base savegame and a delta\n");
+        print_help(command);
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<struct gamea> game_data = std::make_unique<struct gamea>();
+    std::unique_ptr<struct gameb> club_data = std::make_unique<struct gameb>();
+    std::unique_ptr<struct gamec> player_data = std::make_unique<struct gamec>();
+    std::string error;
+
+    if (!load_save_spec(argv[optind], *game_data, *club_data, *player_data, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return EXIT_FAILURE;
+    }
+
+    long applied = 0;
+    for (int i = optind + 1; i < argc && applied != count; ++i) {
+        std::ifstream file;
+        if (0 != strcmp(argv[i], "-")) {
+            file.open(argv[i], std::ios::binary);
+            if (!file) {
+                fprintf(stderr, "Could not open file for reading: %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        }
+        std::istream &in = 0 == strcmp(argv[i], "-") ? std::cin : file;
+
+        try {
+            while (applied != count && apply_delta(in, *game_data, *club_data, *player_data))
+                ++applied;
+        } catch (const std::runtime_error &e) {
+            fprintf(stderr, "%s: delta %ld: %s\n", argv[i], applied + 1, e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!save_save_spec(output, *game_data, *club_data, *player_data, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "%s: %ld deltas applied\n", output, applied);
+    return EXIT_SUCCESS;
+}
+
+int snapshot_main(char *command, int argc, char *argv[]) {
+    int c, optindex = 0;
+    const char *store_path = ".pm3-snapshots";
+
+    static struct option long_options[] = {
+            {"store", required_argument, nullptr, 0 },
+            {"help",  no_argument,       nullptr, 'h'},
+            {nullptr, 0,                 nullptr, 0}
+    };
 
+    while ((c = getopt_long(argc, argv, "h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 0:
+                if (0 == strcmp(long_options[optindex].name, "store"))
+                    store_path = optarg;
+                break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
             default:
+                print_help(command);
+                return EXIT_FAILURE;
+        }
+    }
+
+    const char *action = optind < argc ? argv[optind] : "";
+    int args = argc - optind - 1;
+    if (!((0 == strcmp(action, "add") && args >= 1) || (0 == strcmp(action, "list") && args == 0) ||
+          (0 == strcmp(action, "restore") && args == 2))) {
+        fprintf(stderr, "snapshot needs add SAVE [SAVE ...], list or restore ID SAVE\n");
+        print_help(command);
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<struct gamea> game_data = std::make_unique<struct gamea>();
+    std::unique_ptr<struct gameb> club_data = std::make_unique<struct gameb>();
+    std::unique_ptr<struct gamec> player_data = std::make_unique<struct gamec>();
+    std::string error;
+
+    try {
+        snapshot_store store(store_path);
+
+        if (0 == strcmp(action, "add")) {
+            for (int i = optind + 1; i < argc; ++i) {
+                if (!load_save_spec(argv[i], *game_data, *club_data, *player_data, error)) {
+                    fprintf(stderr, "%s\n", error.c_str());
+                    return EXIT_FAILURE;
+                }
+                struct snapshot_info info = store.add(argv[i], *game_data, *club_data, *player_data);
+                printf("%u %s: %zu new records, %zu bytes\n", info.id, argv[i], info.new_records, info.new_bytes);
+            }
+            printf("%zu records, %llu bytes\n", store.records(), (unsigned long long) store.pack_size());
+        } else if (0 == strcmp(action, "list")) {
+            for (const struct snapshot_info &info : store.list()) {
+                char when[32];
+                time_t t = info.time;
+                strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&t));
+                printf("%5u %s %d week %2d %s %s\n", info.id, when, info.year,
+                       info.turn / TIMETABLE_DAYS + 1, day[info.turn % TIMETABLE_DAYS], info.name.c_str());
+            }
+        } else {
+            uint32_t id = (uint32_t) strtoul(argv[optind + 1], nullptr, 10);
+            store.restore(id, *game_data, *club_data, *player_data);
+            if (!save_save_spec(argv[optind + 2], *game_data, *club_data, *player_data, error)) {
+                fprintf(stderr, "%s\n", error.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void dump_save_hashes(const struct save_hashes &hashes) {
+    const std::vector<struct snapshot_record> &layout = snapshot_layout();
+    size_t first = 0;
+
+    // Members split per element (the managers) share a name and get an index
+    for (size_t i = 0; i < hashes.gamea_records; ++i) {
+        if (0 != strcmp(layout[i].name, layout[first].name))
+            first = i;
+        bool split = i > first || (i + 1 < hashes.gamea_records && 0 == strcmp(layout[i + 1].name, layout[i].name));
+        if (split)
+            printf("%016llx  %s[%zu]\n", (unsigned long long) hashes.record[i], layout[i].name, i - first);
+        else
+            printf("%016llx  %s\n", (unsigned long long) hashes.record[i], layout[i].name);
+    }
+    for (int c = 0; c < CLUB_IDX_MAX; ++c)
+        printf("%016llx  club (%04x) %16.16s\n", (unsigned long long) hashes.club()[c], c, gameb.club[c].name);
+    for (int p = 0; p < 3932; ++p)
+        printf("%016llx  player (%04x) %.12s\n", (unsigned long long) hashes.player()[p], p, gamec.player[p].name);
+    printf("\n");
+}
+
+void dump_players(const std::vector<int16_t> &players, const save_index &index, const struct field_desc *field) {
+    for (int16_t idx : players) {
+        struct gamec::player &p = gamec.player[idx];
+        int16_t club_idx = index.owner(idx);
+
+        printf("  (%04x) %12.12s %c %16.16s", idx, p.name, determine_player_type(p),
+               club_idx >= 0 ? gameb.club[club_idx].name : "-");
+        if (field)
+            printf(" %s", field_to_string(&p, *field).c_str());
+        printf("\n");
+    }
+    printf("\n");
+}
+
+void dump_validation(FILE *out) {
+    int16_t squad[3932];
+    int problems = 0;
+
+    std::fill(squad, squad + 3932, -1);
+    for (int c = 0; c < CLUB_IDX_MAX; ++c) {
+        for (int slot = 0; slot < 24; ++slot) {
+            int16_t idx = gameb.club[c].player_index[slot];
+            if (idx == -1)
+                continue;
+            if (idx < 0 || idx >= 3932) {
+                fprintf(out, "%16.16s has player index %d\n", gameb.club[c].name, idx);
+                ++problems;
+            } else if (squad[idx] != -1) {
+                fprintf(out, "(%04x) %12.12s plays for %16.16s and %16.16s\n",
+                        idx, gamec.player[idx].name, gameb.club[squad[idx]].name, gameb.club[c].name);
+                ++problems;
+            } else {
+                squad[idx] = (int16_t) c;
+            }
+        }
+    }
+
+    for (int m = 0; m < 2; ++m) {
+        int16_t club_idx = gamea.manager[m].club_idx;
+        if (club_idx < 0 || club_idx >= CLUB_IDX_MAX) {
+            fprintf(out, "Manager %d has club index %d\n", m, club_idx);
+            ++problems;
+        }
+    }
+
+    calendar cal(gameb);
+    standings tables(gamea, cal);
+    for (const struct table_mismatch &m : tables.cross_check(gamea)) {
+        fprintf(out, "(%04x) %16.16s %s: stored %d, computed %d\n",
+                m.club_idx, gameb.club[m.club_idx].name, m.column, m.stored, m.computed);
+        ++problems;
+    }
+
+    fprintf(out, "%d problem%s\n", problems, problems == 1 ? "" : "s");
+}
+
+int fleet_main(char *command, int argc, char *argv[]) {
+    static const struct {
+        const char *name;
+        void (*run)(FILE *out);
+    } reports[] = {
+            {"free-players", [](FILE *out) { dump_free_players(out); }},
+            {"standings",    [](FILE *out) {
+                calendar cal(gameb);
+                standings tables(gamea, cal);
+                dump_standings(tables, tables.cross_check(gamea), out);
+            }},
+            {"validation",   [](FILE *out) { dump_validation(out); }},
+    };
+
+    int c, optindex = 0;
+    const char *cache_path = ".pm3-fleet";
+    const char *report_name = "";
+
+    static struct option long_options[] = {
+            {"report", required_argument, nullptr, 0 },
+            {"cache",  required_argument, nullptr, 0 },
+            {"help",   no_argument,       nullptr, 'h'},
+            {nullptr,  0,                 nullptr, 0}
+    };
+
+    while ((c = getopt_long(argc, argv, "h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 0:
+                if (0 == strcmp(long_options[optindex].name, "report"))
+                    report_name = optarg;
+                if (0 == strcmp(long_options[optindex].name, "cache"))
+                    cache_path = optarg;
                 break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
+            default:
+                print_help(command);
+                return EXIT_FAILURE;
+        }
+    }
+
+    auto report = std::find_if(std::begin(reports), std::end(reports),
+                               [report_name](const auto &r) { return 0 == strcmp(r.name, report_name); });
+    if (report == std::end(reports) || optind == argc) {
+        fprintf(stderr, "fleet needs --report=free-players|standings|validation and a path\n");
+        print_help(command);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> game_paths(argv + optind, argv + argc);
+    for (const std::string &game_path : game_paths) {
+        if (get_pm3_game_type(game_path.c_str()) == PM3_UNKNOWN) {
+            fprintf(stderr, "Did not find %s or %s in %s\n", EXE_STANDARD_FILENAME, EXE_DELUXE_FILENAME,
+                    game_path.c_str());
+            return EXIT_FAILURE;
         }
+    }
+
+    size_t cached = 0, run = 0, failed = 0;
+    std::vector<struct fleet_save> saves = find_fleet_saves(game_paths);
+
+    try {
+        fleet_cache cache(cache_path);
+
+        for (struct fleet_save &save : saves) {
+            std::string error, result;
+            bool loaded = false;
+
+            if (!cache.known(save)) {
+                if (!load_save_spec(save.spec, gamea, gameb, gamec, error)) {
+                    fprintf(stderr, "%s\n", error.c_str());
+                    ++failed;
+                    continue;
+                }
+                hash_save_files(save.key);
+                cache.remember(save);
+                loaded = true;
+            }
+
+            uint64_t hash = save_content_hash(save.key);
+            if (cache.get(report->name, hash, result)) {
+                ++cached;
+            } else {
+                if (!loaded && !load_save_spec(save.spec, gamea, gameb, gamec, error)) {
+                    fprintf(stderr, "%s\n", error.c_str());
+                    ++failed;
+                    continue;
+                }
+
+                char *buffer = nullptr;
+                size_t length = 0;
+                FILE *out = open_memstream(&buffer, &length);
+                report->run(out);
+                fclose(out);
+                result.assign(buffer, length);
+                free(buffer);
 
-        player.hd = 99;
-        player.cr = 99;
-        player.ft = 99;
+                cache.put(report->name, hash, result);
+                ++run;
+            }
+
+            printf("SAVE %s\n", save.spec.c_str());
+            fwrite(result.data(), 1, result.size(), stdout);
+            printf("\n");
+        }
 
-        player.morl = 8;
+        cache.save_manifest();
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
     }
+
+    fprintf(stderr, "%zu savegames, %zu from the cache, %zu run", saves.size(), cached, run);
+    if (failed)
+        fprintf(stderr, ", %zu could not be read", failed);
+    fprintf(stderr, "\n");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
+std::string format_watch_event(const struct watch_event &e) {
+    static const char *type[] = {"save", "transfer", "free_agent", "injury"};
+    char buffer[128];
+    std::string line = std::string("{\"event\":\"") + type[e.type] + "\",\"save\":" + json_string(e.spec);
 
-void dump_free_players() {
-    print_player_row_header();
-    std::vector<club_player> free_players = find_free_players();
+    snprintf(buffer, sizeof(buffer), ",\"year\":%d,\"turn\":%d", e.year, e.turn);
+    line += buffer;
+    if (e.type == WATCH_SAVE) {
+        snprintf(buffer, sizeof(buffer), ",\"changed\":%zu}", e.changed);
+        return line + buffer;
+    }
 
-    for (club_player &free_player: free_players) {
-        print_player_row(free_player);
+    snprintf(buffer, sizeof(buffer), ",\"player\":%d,\"name\":", e.player_idx);
+    line += buffer + json_string(e.player);
+    if (e.type == WATCH_TRANSFER) {
+        snprintf(buffer, sizeof(buffer), ",\"from\":%d,\"from_name\":", e.from_club_idx);
+        line += buffer + json_string(e.from_club);
+    }
+    snprintf(buffer, sizeof(buffer), ",\"club\":%d,\"club_name\":", e.club_idx);
+    line += buffer + json_string(e.club);
+    if (e.type == WATCH_INJURY) {
+        snprintf(buffer, sizeof(buffer), ",\"weeks\":%d,\"injury\":", e.weeks);
+        line += buffer + json_string(e.injury);
     }
+    return line + "}";
+}
+
+static volatile sig_atomic_t stop_watching = 0;
+
+int watch_main(char *command, int argc, char *argv[]) {
+    int c, optindex = 0;
+    const char *socket_path = nullptr;
+
+    static struct option long_options[] = {
+            {"socket", required_argument, nullptr, 0 },
+            {"help",   no_argument,       nullptr, 'h'},
+            {nullptr,  0,                 nullptr, 0}
+    };
+
+    while ((c = getopt_long(argc, argv, "h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 0:
+                if (0 == strcmp(long_options[optindex].name, "socket"))
+                    socket_path = optarg;
+                break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
+            default:
+                print_help(command);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind == argc) {
+        fprintf(stderr, "watch needs a path\n");
+        print_help(command);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        save_watcher watcher;
+        std::unique_ptr<event_socket> events;
+        size_t installs = 0;
+
+        for (int i = optind; i < argc; ++i)
+            installs += watcher.add_root(argv[i]);
+        if (installs == 0) {
+            fprintf(stderr, "No PM3 installs found\n");
+            return EXIT_FAILURE;
+        }
+        if (socket_path)
+            events = std::make_unique<event_socket>(socket_path);
+        fprintf(stderr, "Watching %zu install%s\n", installs, installs == 1 ? "" : "s");
+
+        /* Leave the loop on a signal, so the socket is removed */
+        signal(SIGINT, [](int) { stop_watching = 1; });
+        signal(SIGTERM, [](int) { stop_watching = 1; });
+
+        while (!stop_watching) {
+            struct pollfd fds[2] = {{watcher.fd(), POLLIN, 0}, {events ? events->fd() : -1, POLLIN, 0}};
+            if (poll(fds, events ? 2 : 1, watcher.timeout()) < 0 && errno != EINTR)
+                throw std::runtime_error(std::string("poll: ") + strerror(errno));
+
+            if (events)
+                events->accept_clients();
+
+            for (const struct watch_event &e : watcher.read()) {
+                std::string line = format_watch_event(e) + "\n";
+                if (events) {
+                    events->send(line);
+                } else {
+                    fputs(line.c_str(), stdout);
+                    fflush(stdout);
+                }
+            }
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+static volatile sig_atomic_t stop_serving = 0;
+
+int serve_main(char *command, int argc, char *argv[]) {
+    int c, optindex = 0;
+    const char *socket_path = nullptr;
+
+    static struct option long_options[] = {
+            {"socket", required_argument, nullptr, 0 },
+            {"help",   no_argument,       nullptr, 'h'},
+            {nullptr,  0,                 nullptr, 0}
+    };
+
+    while ((c = getopt_long(argc, argv, "h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 0:
+                if (0 == strcmp(long_options[optindex].name, "socket"))
+                    socket_path = optarg;
+                break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
+            default:
+                print_help(command);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (!socket_path) {
+        fprintf(stderr, "serve needs --socket\n");
+        print_help(command);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        save_cache cache;
+        std::string error;
+
+        for (int i = optind; i < argc; ++i) {
+            if (!cache.get(argv[i], error)) {
+                fprintf(stderr, "%s\n", error.c_str());
+                return EXIT_FAILURE;
+            }
+        }
+
+        query_server server(socket_path, cache);
+        fprintf(stderr, "Serving %d savegame%s on %s\n", argc - optind, argc - optind == 1 ? "" : "s", socket_path);
+
+        /* Leave the loop on a signal, so the clients are hung up on and the socket is removed */
+        signal(SIGINT, [](int) { stop_serving = 1; });
+        signal(SIGTERM, [](int) { stop_serving = 1; });
+        server.run(stop_serving);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int shell_main(char *command, int argc, char *argv[]) {
+    int c, optindex = 0;
+    int game_nr = 0;
+
+    static struct option long_options[] = {
+            {"game", required_argument, nullptr, 'g'},
+            {"help", no_argument,       nullptr, 'h'},
+            {nullptr, 0,                nullptr, 0}
+    };
+
+    while ((c = getopt_long(argc, argv, "g:h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 'g':
+                game_nr = atoi(optarg);
+                if (game_nr < 1 || game_nr > 8) {
+                    fprintf(stderr, "Invalid savegame number: %d\n", game_nr);
+                    print_help(command);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
+            default:
+                print_help(command);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (game_nr == 0 || argc - optind != 1) {
+        fprintf(stderr, "shell needs a savegame number and a game path\n");
+        print_help(command);
+        return EXIT_FAILURE;
+    }
+
+    save_cache cache;
+    session shell(cache, true);
+    std::string spec = std::string(argv[optind]) + ":" + std::to_string(game_nr);
+    struct command_result result = shell.execute("use " + spec);
+    if (!result.ok) {
+        fputs(result.output.c_str(), stderr);
+        return EXIT_FAILURE;
+    }
+
+    bool interactive = isatty(STDIN_FILENO);
+    std::string line;
+    for (;;) {
+        if (interactive) {
+            fprintf(stderr, "pm3> ");
+            fflush(stderr);
+        }
+        if (!std::getline(std::cin, line) || line == "quit" || line == "exit")
+            break;
+
+        try {
+            result = shell.execute(line);
+        } catch (const std::exception &e) {
+            result = {false, std::string(e.what()) + "\n"};
+        }
+        fputs(result.output.c_str(), result.ok ? stdout : stderr);
+        fflush(stdout);
+    }
+
+    if (shell.uncommitted()) {
+        fprintf(stderr, "Changes to %s were not committed\n", spec.c_str());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int pack_main(char *command, int argc, char *argv[]) {
+    int c, optindex = 0;
+    const char *output_path = nullptr;
+    const char *list_path = nullptr;
+
+    static struct option long_options[] = {
+            {"output", required_argument, nullptr, 'o'},
+            {"list",   required_argument, nullptr, 0 },
+            {"help",   no_argument,       nullptr, 'h'},
+            {nullptr,  0,                 nullptr, 0}
+    };
+
+    while ((c = getopt_long(argc, argv, "o:h", long_options, &optindex)) != -1) {
+        switch (c) {
+            case 0:
+                if (0 == strcmp(long_options[optindex].name, "list"))
+                    list_path = optarg;
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'h':
+                print_help(command);
+                return EXIT_SUCCESS;
+            default:
+                print_help(command);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (list_path) {
+        save_pack pack;
+        std::string error;
+        if (!pack.map(list_path, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return EXIT_FAILURE;
+        }
+        for (size_t i = 0; i < pack.size(); ++i) {
+            const struct pack_entry &e = pack.entry(i);
+            printf("%s %d week %d %s %.16s (%d) %.16s (%d)\n", pack.spec(i).c_str(), e.year,
+                   e.turn / TIMETABLE_DAYS + 1, day[e.turn % TIMETABLE_DAYS],
+                   e.manager[0], e.manager_club_idx[0], e.manager[1], e.manager_club_idx[1]);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (!output_path || optind == argc) {
+        fprintf(stderr, "pack needs -o FILE and a path\n");
+        print_help(command);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> game_paths(argv + optind, argv + argc);
+    for (const std::string &game_path : game_paths) {
+        if (get_pm3_game_type(game_path.c_str()) == PM3_UNKNOWN) {
+            fprintf(stderr, "Did not find %s or %s in %s\n", EXE_STANDARD_FILENAME, EXE_DELUXE_FILENAME,
+                    game_path.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        size_t count = write_pack(output_path, find_fleet_saves(game_paths));
+        fprintf(stderr, "%zu savegame%s packed into %s\n", count, count == 1 ? "" : "s", output_path);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
 }
@@ -0,0 +1,73 @@
+#include "boost.hh"
+
+static const char roles[] = "GDMA";
+
+const struct boost_profile boost_profiles[BOOST_PROFILE_COUNT] = {
+        { "max",     97, 99, 99, 99, 99, 8, 99 },
+        { "strong",  80, 90, 85, 85, 85, 7, 80 },
+        { "average", 55, 65, 60, 60, 60, 5,  0 },
+        { "weak",    30, 40, 35, 35, 35, 3,  0 },
+};
+
+const struct boost_profile *find_boost_profile(const char *name) {
+    for (int i = 0; i < BOOST_PROFILE_COUNT; ++i) {
+        if (0 == strcmp(boost_profiles[i].name, name))
+            return &boost_profiles[i];
+    }
+    return nullptr;
+}
+
+void boost_club(int club_idx, const struct boost_profile &profile, position_source positions,
+                struct boost_summary &summary, edit_journal *journal,
+                struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) {
+    struct gameb::club &club = club_data.club[club_idx];
+
+    for (struct gamea::manager &manager : game_data.manager) {
+        if (manager.club_idx != club_idx || !profile.staff)
+            continue;
+
+        for (struct gamea::manager::employee &employee : manager.employee) {
+            if (journal)
+                journal->touch(&employee.skill, sizeof(employee.skill));
+            employee.skill = profile.staff;
+            ++summary.staff;
+        }
+    }
+
+    for (int slot = 0; slot < 24; ++slot) {
+        int16_t idx = club.player_index[slot];
+        if (idx < 0 || idx >= 3932)
+            continue;
+
+        struct gamec::player &player = player_data.player[idx];
+        char role = positions == POSITIONS_SLOT ? squad_slot_role[slot] : determine_player_type(player);
+
+        if (journal)
+            journal->touch(&player, sizeof(player));
+
+        player.hn = role == 'G' ? profile.specialty : profile.skill;
+        player.tk = role == 'D' ? profile.specialty : profile.skill;
+        player.ps = role == 'M' ? profile.specialty : profile.skill;
+        player.sh = role == 'A' ? profile.specialty : profile.skill;
+        player.hd = profile.hd;
+        player.cr = profile.cr;
+        player.ft = profile.ft;
+        player.morl = profile.morl;
+
+        ++summary.players;
+        ++summary.role[strchr(roles, role) - roles];
+    }
+
+    ++summary.clubs;
+}
+
+void boost_division(int division, const struct boost_profile &profile, position_source positions,
+                    struct boost_summary &summary, edit_journal *journal,
+                    struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) {
+    for (int i = division_offset[division]; i < division_offset[division + 1]; ++i) {
+        int16_t idx = game_data.club_index.all[i];
+        if (idx < 0 || idx >= CLUB_IDX_MAX)
+            continue;
+        boost_club(idx, profile, positions, summary, journal, game_data, club_data, player_data);
+    }
+}
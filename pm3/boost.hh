@@ -0,0 +1,55 @@
+#ifndef BOOST_H
+#define BOOST_H
+
+#include "pm3.hh"
+#include "journal.hh"
+
+/* Role of each squad slot in the game's default squad layout */
+static const char squad_slot_role[24] = {
+        'G', 'D', 'D', 'M', 'D', 'D', 'A', 'A', 'A', 'A', 'M', 'G',
+        'D', 'M', 'A', 'G', 'D', 'M', 'A', 'D', 'M', 'A', 'D', 'A'
+};
+
+typedef enum {
+    POSITIONS_SLOT,     // squad_slot_role
+    POSITIONS_INFERRED  // determine_player_type
+} position_source;
+
+/*
+ * Attribute targets. Every player gets skill in hn, tk, ps and sh, with the
+ * one matching the role raised to specialty. staff is the skill given to the
+ * employees of a human manager at the club, 0 leaves them alone.
+ */
+struct boost_profile {
+    const char *name;
+    uint8_t skill;
+    uint8_t specialty;
+    uint8_t hd, cr, ft;
+    uint8_t morl;
+    uint8_t staff;
+};
+
+/* max, strong, average and weak */
+#define BOOST_PROFILE_COUNT 4
+
+extern const struct boost_profile boost_profiles[BOOST_PROFILE_COUNT];
+
+struct boost_summary {
+    int clubs;
+    int players;
+    int staff;
+    int role[4];  // G, D, M, A
+};
+
+const struct boost_profile *find_boost_profile(const char *name);
+
+void boost_club(int club_idx, const struct boost_profile &profile, position_source positions,
+                struct boost_summary &summary, edit_journal *journal = nullptr,
+                struct gamea &game_data = gamea, struct gameb &club_data = gameb, struct gamec &player_data = gamec);
+
+/* Boost every club in the division (0 is the Premier League) */
+void boost_division(int division, const struct boost_profile &profile, position_source positions,
+                    struct boost_summary &summary, edit_journal *journal = nullptr,
+                    struct gamea &game_data = gamea, struct gameb &club_data = gameb, struct gamec &player_data = gamec);
+
+#endif
@@ -0,0 +1,116 @@
+#include "calendar.hh"
+
+#include <algorithm>
+
+void calendar::build(const struct gameb &club_data) {
+    fixtures.clear();
+
+    for (int w = 0; w < TIMETABLE_WEEKS; ++w) {
+        for (int d = 0; d < TIMETABLE_DAYS; ++d) {
+            slot_offset[w * TIMETABLE_DAYS + d] = fixtures.size();
+
+            for (int c = 0; c < CLUB_IDX_MAX; ++c) {
+                const struct gameb::club::timetable::week::day &rnd = club_data.club[c].timetable.week[w].day[d];
+
+                /* Every match is in both timetables, only take it from the home club. */
+                if (rnd.opponent_idx >= CLUB_IDX_MAX || rnd.game > 1)
+                    continue;
+
+                struct fixture f{};
+                f.home_idx = c;
+                f.away_idx = rnd.opponent_idx;
+                f.type = rnd.type;
+                f.game = rnd.game;
+                f.week = w;
+                f.day = d;
+                f.home_goals = rnd.result == -1 ? -1 : rnd.home;
+                f.away_goals = rnd.result == -1 ? -1 : rnd.away;
+                fixtures.push_back(f);
+            }
+        }
+    }
+    slot_offset[TIMETABLE_SLOTS] = fixtures.size();
+
+    /* Counting sort of the fixture indices by club keeps them in turn order. */
+    club_offset.assign(CLUB_IDX_MAX + 1, 0);
+    for (const struct fixture &f : fixtures) {
+        club_offset[f.home_idx + 1]++;
+        club_offset[f.away_idx + 1]++;
+    }
+    for (int c = 0; c < CLUB_IDX_MAX; ++c)
+        club_offset[c + 1] += club_offset[c];
+
+    std::vector<uint32_t> next(club_offset.begin(), club_offset.end() - 1);
+    club_index.resize(club_offset[CLUB_IDX_MAX]);
+    for (uint32_t i = 0; i < fixtures.size(); ++i) {
+        club_index[next[fixtures[i].home_idx]++] = i;
+        club_index[next[fixtures[i].away_idx]++] = i;
+    }
+}
+
+void calendar::assign(const struct fixture *first, size_t count, const uint32_t *slot_offsets,
+                      const uint32_t *club_offsets, const uint32_t *club_indexes) {
+    fixtures.assign(first, first + count);
+    std::copy(slot_offsets, slot_offsets + TIMETABLE_SLOTS + 1, slot_offset);
+    club_offset.assign(club_offsets, club_offsets + CLUB_IDX_MAX + 1);
+    club_index.assign(club_indexes, club_indexes + club_offset[CLUB_IDX_MAX]);
+}
+
+struct fixture_range calendar::slot(int turn) const {
+    if (turn < 0 || turn >= TIMETABLE_SLOTS)
+        return {nullptr, nullptr};
+
+    return {fixtures.data() + slot_offset[turn], fixtures.data() + slot_offset[turn + 1]};
+}
+
+struct fixture_range calendar::week(int week) const {
+    if (week < 0 || week >= TIMETABLE_WEEKS)
+        return {nullptr, nullptr};
+
+    return {fixtures.data() + slot_offset[week * TIMETABLE_DAYS],
+            fixtures.data() + slot_offset[(week + 1) * TIMETABLE_DAYS]};
+}
+
+std::vector<const struct fixture *> calendar::club_fixtures(int club_idx) const {
+    std::vector<const struct fixture *> result;
+
+    for (uint32_t i = club_offset[club_idx]; i < club_offset[club_idx + 1]; ++i)
+        result.push_back(&fixtures[club_index[i]]);
+
+    return result;
+}
+
+std::vector<const struct fixture *> calendar::next_fixtures(int club_idx, int from_turn, int count) const {
+    std::vector<const struct fixture *> result;
+
+    for (uint32_t i = club_offset[club_idx]; i < club_offset[club_idx + 1] && (int) result.size() < count; ++i) {
+        const struct fixture &f = fixtures[club_index[i]];
+        if (f.turn() >= from_turn)
+            result.push_back(&f);
+    }
+
+    return result;
+}
+
+std::vector<const struct fixture *> calendar::remaining_fixtures(int type) const {
+    std::vector<const struct fixture *> result;
+
+    for (const struct fixture &f : fixtures) {
+        if (!f.played() && f.type == type)
+            result.push_back(&f);
+    }
+
+    return result;
+}
+
+std::vector<const struct fixture *> calendar::remaining_fixtures(int club_idx, int type) const {
+    std::vector<const struct fixture *> result;
+
+    for (uint32_t i = club_offset[club_idx]; i < club_offset[club_idx + 1]; ++i) {
+        const struct fixture &f = fixtures[club_index[i]];
+        if (!f.played() && (type == -1 || f.type == type))
+            result.push_back(&f);
+    }
+
+    return result;
+}
@@ -0,0 +1,74 @@
+#ifndef CALENDAR_H
+#define CALENDAR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "pm3.hh"
+
+#define TIMETABLE_WEEKS 41
+#define TIMETABLE_DAYS 3
+#define TIMETABLE_SLOTS (TIMETABLE_WEEKS * TIMETABLE_DAYS)
+
+/* One match decoded from the timetable of its home club. */
+struct fixture {
+    uint8_t home_idx;
+    uint8_t away_idx;
+    uint8_t type;        // timetable match type
+    uint8_t game;        // timetable game code of the home club (home or home friendly)
+    uint8_t week;        // 0 - 40
+    uint8_t day;         // 0 - 2, see day[]
+    int8_t home_goals;   // -1 if not played yet
+    int8_t away_goals;
+
+    int turn() const { return week * TIMETABLE_DAYS + day; }
+    bool played() const { return home_goals >= 0; }
+};
+
+struct fixture_range {
+    const struct fixture *first;
+    const struct fixture *last;
+
+    const struct fixture *begin() const { return first; }
+    const struct fixture *end() const { return last; }
+    size_t size() const { return last - first; }
+};
+
+/*
+ * Fixture list of a whole save, built once from the gameb timetables.
+ * Fixtures are stored in (week, day) order with an offset table per slot, and
+ * every club has a list of its fixtures in the same order.
+ */
+class calendar {
+public:
+    calendar() = default;
+    explicit calendar(const struct gameb &club_data) { build(club_data); }
+
+    void build(const struct gameb &club_data);
+
+    /* Take over the tables of a calendar built earlier, see the accessors below */
+    void assign(const struct fixture *first, size_t count, const uint32_t *slot_offsets,
+                const uint32_t *club_offsets, const uint32_t *club_indexes);
+
+    const std::vector<struct fixture> &all() const { return fixtures; }
+    struct fixture_range slot(int turn) const;
+    struct fixture_range week(int week) const;
+
+    std::vector<const struct fixture *> club_fixtures(int club_idx) const;
+    std::vector<const struct fixture *> next_fixtures(int club_idx, int from_turn, int count) const;
+    std::vector<const struct fixture *> remaining_fixtures(int type) const;
+    std::vector<const struct fixture *> remaining_fixtures(int club_idx, int type) const;
+
+    /* TIMETABLE_SLOTS + 1 and CLUB_IDX_MAX + 1 offsets, and one entry per fixture and club */
+    const uint32_t *slot_offsets() const { return slot_offset; }
+    const std::vector<uint32_t> &club_offsets() const { return club_offset; }
+    const std::vector<uint32_t> &club_indexes() const { return club_index; }
+
+private:
+    std::vector<struct fixture> fixtures;
+    uint32_t slot_offset[TIMETABLE_SLOTS + 1] = {};
+    std::vector<uint32_t> club_offset;
+    std::vector<uint32_t> club_index;
+};
+
+#endif
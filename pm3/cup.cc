@@ -0,0 +1,275 @@
+#include "cup.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "random.hh"
+
+const struct cup_competition cup_competitions[CUP_COMPETITION_COUNT] = {
+        { "F.A. Cup",        "fa",         0,   36, true },
+        { "League Cup",      "league",     36,  28, true },
+        { "data090",         "data090",    64,  4,  false },
+        { "Champions Cup",   "champions",  68,  16, true },
+        { "data091",         "data091",    84,  16, false },
+        { "Cup Winners Cup", "cupwinners", 100, 16, true },
+        { "U.E.F.A. Cup",    "uefa",       116, 32, true },
+        { "Charity Shield",  "charity",    148, 1,  true },
+};
+
+bool cup_tie::played() const {
+    for (int l = 0; l < legs; ++l) {
+        if (leg[l].home_goals < 0 || leg[l].away_goals < 0)
+            return false;
+    }
+    return true;
+}
+
+int cup_tie::goals(int side) const {
+    int total = 0;
+    for (int l = 0; l < legs; ++l) {
+        if (leg[l].home_goals < 0 || leg[l].away_goals < 0)
+            continue;
+        total += leg[l].home_idx == club[side] ? leg[l].home_goals : leg[l].away_goals;
+    }
+    return total;
+}
+
+int32_t cup_tie::audience() const {
+    int32_t total = 0;
+    for (int l = 0; l < legs; ++l)
+        total += leg[l].audience;
+    return total;
+}
+
+void cup_bracket::build(const struct cup_competition &c, const struct gamea &game_data) {
+    int last_tie[CLUB_IDX_MAX];
+
+    competition = &c;
+    ties.clear();
+    rounds = 0;
+    std::fill(last_tie, last_tie + CLUB_IDX_MAX, -1);
+
+    for (int i = c.first; i < c.first + c.count; ++i) {
+        const auto &e = game_data.cuppy.all[i];
+        int16_t h = e.club[0].idx, a = e.club[1].idx;
+        if (h < 0 || h >= CLUB_IDX_MAX || a < 0 || a >= CLUB_IDX_MAX || h == a)
+            continue;
+
+        struct cup_leg leg = {h, a, (int8_t) std::max<int16_t>(-1, std::min<int16_t>(e.club[0].goals, 127)),
+                              (int8_t) std::max<int16_t>(-1, std::min<int16_t>(e.club[1].goals, 127)),
+                              e.club[0].audience + e.club[1].audience, (uint8_t) i};
+
+        /* Second leg of the last tie both clubs played */
+        int previous = last_tie[h];
+        if (previous != -1 && previous == last_tie[a] && ties[previous].legs == 1 &&
+            ties[previous].club[0] == a && ties[previous].club[1] == h) {
+            ties[previous].leg[1] = leg;
+            ties[previous].legs = 2;
+            continue;
+        }
+
+        struct cup_tie t{};
+        t.club[0] = h;
+        t.club[1] = a;
+        t.legs = 1;
+        t.leg[0] = leg;
+        t.winner = -1;
+        t.round = ties.empty() ? 0 : ties.back().round;
+        for (int side = 0; side < 2; ++side) {
+            t.parent[side] = last_tie[t.club[side]];
+            if (t.parent[side] != -1)
+                t.round = std::max(t.round, ties[t.parent[side]].round + 1);
+        }
+
+        last_tie[h] = last_tie[a] = (int) ties.size();
+        ties.push_back(t);
+        rounds = std::max(rounds, t.round + 1);
+    }
+
+    for (struct cup_tie &t : ties) {
+        if (t.played() && t.goals(0) != t.goals(1))
+            t.winner = t.club[t.goals(0) > t.goals(1) ? 0 : 1];
+    }
+
+    /* Whoever played on won, whatever the score says (replays and penalties are not stored) */
+    for (const struct cup_tie &t : ties) {
+        for (int side = 0; side < 2; ++side) {
+            if (t.parent[side] != -1)
+                ties[t.parent[side]].winner = t.club[side];
+        }
+    }
+}
+
+std::vector<const struct cup_tie *> cup_bracket::round(int r) const {
+    std::vector<const struct cup_tie *> result;
+    for (const struct cup_tie &t : ties) {
+        if (t.round == r)
+            result.push_back(&t);
+    }
+    return result;
+}
+
+namespace {
+
+struct knockout {
+    const struct cup_bracket &bracket;
+    const struct match_model &model;
+    const int *strength;
+    std::vector<std::vector<int>> open;   // by round, ties no later tie comes out of
+    int rounds;
+
+    knockout(const struct cup_bracket &bracket, const struct match_model &model, const int *strength)
+            : bracket(bracket), model(model), strength(strength), open(bracket.rounds), rounds(bracket.rounds) {}
+
+    /* Single match or second leg; returns the goals of home and away */
+    void play(struct rng &random, int16_t home, int16_t away, int &home_goals, int &away_goals) const {
+        home_goals = random.poisson(std::exp(-model.home_mean(strength[home], strength[away])));
+        away_goals = random.poisson(std::exp(-model.away_mean(strength[home], strength[away])));
+    }
+
+    int16_t decide(struct rng &random, const struct cup_tie &t) const {
+        if (t.winner != -1)
+            return t.winner;
+
+        int goals[2] = {t.goals(0), t.goals(1)};
+        for (int l = 0; l < t.legs; ++l) {
+            const struct cup_leg &leg = t.leg[l];
+            if (leg.home_goals >= 0 && leg.away_goals >= 0)
+                continue;
+            int hg, ag;
+            play(random, leg.home_idx, leg.away_idx, hg, ag);
+            goals[leg.home_idx == t.club[0] ? 0 : 1] += hg;
+            goals[leg.home_idx == t.club[0] ? 1 : 0] += ag;
+        }
+
+        if (goals[0] == goals[1])
+            return t.club[random.next() >> 63];
+        return t.club[goals[0] > goals[1] ? 0 : 1];
+    }
+
+    void simulate(int simulations, uint64_t seed, int stream, std::vector<uint32_t> &reach,
+                  std::vector<uint32_t> &win) const {
+        struct rng random(seed, stream);
+        std::vector<int16_t> survivors, next;
+
+        for (int sim = 0; sim < simulations; ++sim) {
+            survivors.clear();
+
+            /* Winners of round r are drawn against each other for r + 1, then meet the ties drawn there */
+            for (int round = 0; ; ++round) {
+                if (round < (int) open.size()) {
+                    for (int i : open[round])
+                        survivors.push_back(decide(random, bracket.ties[i]));
+                }
+                if (round + 1 >= (int) open.size() && survivors.size() <= 1)
+                    break;
+
+                for (size_t i = survivors.size(); i > 1; --i)
+                    std::swap(survivors[i - 1], survivors[random.next() % i]);
+
+                if (round + 1 < CUP_ROUNDS_MAX) {
+                    for (int16_t c : survivors)
+                        ++reach[c * CUP_ROUNDS_MAX + round + 1];
+                }
+
+                next.clear();
+                for (size_t i = 0; i < survivors.size(); ++i) {
+                    if (i + 1 == survivors.size()) {
+                        next.push_back(survivors[i]);
+                        break;
+                    }
+                    int hg, ag;
+                    play(random, survivors[i], survivors[i + 1], hg, ag);
+                    next.push_back(hg == ag ? survivors[i + (random.next() >> 63)]
+                                            : survivors[hg > ag ? i : i + 1]);
+                    ++i;
+                }
+                survivors.swap(next);
+            }
+
+            if (!survivors.empty())
+                ++win[survivors[0]];
+        }
+    }
+};
+
+}
+
+void simulate_cup(const struct cup_bracket &bracket, const struct gameb &club_data, const struct gamec &player_data,
+                  const struct formation &f, int simulations, struct cup_odds &odds, int threads, uint64_t seed,
+                  const struct match_model &model) {
+    int strength[CLUB_IDX_MAX] = {};
+    std::vector<bool> has_child(bracket.ties.size());
+
+    std::fill(odds.entered, odds.entered + CLUB_IDX_MAX, false);
+    for (const struct cup_tie &t : bracket.ties) {
+        for (int side = 0; side < 2; ++side) {
+            if (!odds.entered[t.club[side]]) {
+                struct lineup l{};
+                pick_lineup(t.club[side], f, l, club_data, player_data);
+                strength[t.club[side]] = l.strength;
+                odds.entered[t.club[side]] = true;
+            }
+            if (t.parent[side] != -1)
+                has_child[t.parent[side]] = true;
+        }
+    }
+
+    knockout k(bracket, model, strength);
+    for (size_t i = 0; i < bracket.ties.size(); ++i) {
+        if (!has_child[i])
+            k.open[bracket.ties[i].round].push_back((int) i);
+    }
+
+    /* As knockout::simulate goes, one round further for every draw */
+    size_t left = 0;
+    for (int round = 0; ; ++round) {
+        if (round < (int) k.open.size())
+            left += k.open[round].size();
+        if (round + 1 >= (int) k.open.size() && left <= 1)
+            break;
+        left = (left + 1) / 2;
+        k.rounds = std::max(k.rounds, round + 2);
+    }
+    k.rounds = std::min(k.rounds, CUP_ROUNDS_MAX);
+
+    if (!threads)
+        threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, simulations));
+
+    std::vector<std::vector<uint32_t>> reach(threads, std::vector<uint32_t>(CLUB_IDX_MAX * CUP_ROUNDS_MAX));
+    std::vector<std::vector<uint32_t>> win(threads, std::vector<uint32_t>(CLUB_IDX_MAX));
+    std::vector<std::thread> pool;
+
+    for (int t = 0; t < threads; ++t) {
+        int share = simulations / threads + (t < simulations % threads);
+        pool.emplace_back(&knockout::simulate, &k, share, seed, t, std::ref(reach[t]), std::ref(win[t]));
+    }
+    for (std::thread &thread : pool)
+        thread.join();
+
+    odds.simulations = simulations;
+    odds.rounds = k.rounds;
+    for (int c = 0; c < CLUB_IDX_MAX; ++c) {
+        uint64_t wins = 0;
+        for (int t = 0; t < threads; ++t)
+            wins += win[t][c];
+        odds.win[c] = (double) wins / simulations;
+
+        for (int r = 0; r < CUP_ROUNDS_MAX; ++r) {
+            uint64_t n = 0;
+            for (int t = 0; t < threads; ++t)
+                n += reach[t][c * CUP_ROUNDS_MAX + r];
+            odds.reach[c][r] = (double) n / simulations;
+        }
+    }
+
+    /* Ties already drawn are certain */
+    for (const struct cup_tie &t : bracket.ties) {
+        if (t.round < CUP_ROUNDS_MAX) {
+            odds.reach[t.club[0]][t.round] = 1;
+            odds.reach[t.club[1]][t.round] = 1;
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef CUP_H
+#define CUP_H
+
+#include <vector>
+
+#include "pm3.hh"
+#include "lineup.hh"
+#include "season.hh"
+
+#define CUP_ROUNDS_MAX 12
+
+/* Slices of gamea.cuppy.all; the data blocks are not competitions */
+struct cup_competition {
+    const char *name;
+    const char *key;
+    uint8_t first;
+    uint8_t count;
+    bool known;
+};
+
+#define CUP_COMPETITION_COUNT 8
+
+extern const struct cup_competition cup_competitions[CUP_COMPETITION_COUNT];
+
+struct cup_leg {
+    int16_t home_idx, away_idx;
+    int8_t home_goals, away_goals;  // -1 if not played yet
+    int32_t audience;               // both sets of supporters
+    uint8_t entry;                  // index into gamea.cuppy.all
+};
+
+struct cup_tie {
+    int16_t club[2];
+    int legs;
+    struct cup_leg leg[2];
+    int round;                // 0 is the first round in the slice
+    int parent[2];            // tie of the previous round each club came through, -1 if none
+    int16_t winner;           // -1 while undecided
+
+    bool played() const;
+    int goals(int side) const;  // aggregate, counting played legs only
+    int32_t audience() const;
+};
+
+/*
+ * A cup rebuilt from its slice. A repeat of the last tie between two clubs,
+ * with home and away swapped, is its second leg. A tie is in the round
+ * after the latest one either club played in, and its parents are those
+ * earlier ties. Drawn ties are decided by whoever turns up in a later round.
+ */
+struct cup_bracket {
+    const struct cup_competition *competition;
+    std::vector<struct cup_tie> ties;
+    int rounds;
+
+    void build(const struct cup_competition &c, const struct gamea &game_data = gamea);
+    std::vector<const struct cup_tie *> round(int r) const;
+};
+
+struct cup_odds {
+    int simulations;
+    int rounds;                                   // known rounds plus the ones still to be drawn
+    double reach[CLUB_IDX_MAX][CUP_ROUNDS_MAX];   // probability of playing in each round
+    double win[CLUB_IDX_MAX];
+    bool entered[CLUB_IDX_MAX];
+};
+
+/*
+ * Plays out the undecided ties of a bracket, then draws the survivors at
+ * random, round after round, until one is left. Ties drawn after normal time
+ * are settled on penalties, evenly. Threads keep their own random streams and
+ * counters, merged at the end.
+ */
+void simulate_cup(const struct cup_bracket &bracket, const struct gameb &club_data, const struct gamec &player_data,
+                  const struct formation &f, int simulations, struct cup_odds &odds, int threads = 0,
+                  uint64_t seed = 0, const struct match_model &model = match_model());
+
+#endif
@@ -0,0 +1,214 @@
+#include "delta.hh"
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "hash.hh"
+#include "journal.hh"
+
+#define DELTA_END_OF_FILE 0xffffffffu
+#define DELTA_FILL 0x8000u
+
+namespace {
+
+const size_t file_size[NUM_SAVE_FILES] = {
+        sizeof(struct gamea),
+        sizeof(struct gameb),
+        sizeof(struct gamec)
+};
+
+template <typename T>
+void put(std::vector<uint8_t> &buffer, T value) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(&value);
+    buffer.insert(buffer.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+T get(std::istream &in) {
+    T value;
+    if (!in.read(reinterpret_cast<char *>(&value), sizeof(T)))
+        throw std::runtime_error("Truncated pm3 delta");
+    return value;
+}
+
+/* Runs of one changed record; returns the number of runs added to the buffer */
+uint16_t encode_record(const uint8_t *base, const uint8_t *target, size_t size, std::vector<uint8_t> &buffer) {
+    uint16_t runs = 0;
+    size_t end = 0;   // end of the previous run
+    size_t i = 0;
+
+    while (i < size) {
+        if (base[i] == target[i]) {
+            ++i;
+            continue;
+        }
+
+        /* A span of changes, taking in gaps too short to be worth a run header */
+        size_t first = i, last = i + 1;
+        for (size_t j = last; j < size && j - last < DELTA_GAP_MAX; ++j) {
+            if (base[j] != target[j])
+                last = j + 1;
+        }
+
+        /* Split the span into fills and literals */
+        size_t p = first;
+        while (p < last) {
+            size_t repeat = 1;
+            while (p + repeat < last && target[p + repeat] == target[p])
+                ++repeat;
+
+            size_t length = repeat;
+            bool fill = repeat >= DELTA_FILL_MIN;
+            if (!fill) {
+                /* Literal up to the next fill */
+                length = 0;
+                while (p + length < last) {
+                    size_t r = 1;
+                    while (p + length + r < last && target[p + length + r] == target[p + length])
+                        ++r;
+                    if (r >= DELTA_FILL_MIN)
+                        break;
+                    length += r;
+                }
+            }
+
+            put<uint16_t>(buffer, (uint16_t) (p - end));
+            put<uint16_t>(buffer, (uint16_t) (length | (fill ? DELTA_FILL : 0)));
+            if (fill)
+                buffer.push_back(target[p]);
+            else
+                buffer.insert(buffer.end(), target + p, target + p + length);
+            ++runs;
+
+            p += length;
+            end = p;
+        }
+        i = last;
+    }
+    return runs;
+}
+
+}
+
+void write_delta(std::ostream &out, const struct gamea &base_game, const struct gameb &base_club,
+                 const struct gamec &base_player, const struct gamea &game_data, const struct gameb &club_data,
+                 const struct gamec &player_data, struct delta_stats *stats) {
+    const uint8_t *base[NUM_SAVE_FILES] = {
+            reinterpret_cast<const uint8_t *>(&base_game),
+            reinterpret_cast<const uint8_t *>(&base_club),
+            reinterpret_cast<const uint8_t *>(&base_player)
+    };
+    const uint8_t *target[NUM_SAVE_FILES] = {
+            reinterpret_cast<const uint8_t *>(&game_data),
+            reinterpret_cast<const uint8_t *>(&club_data),
+            reinterpret_cast<const uint8_t *>(&player_data)
+    };
+    struct delta_stats local;
+    std::vector<uint8_t> buffer;
+
+    if (!stats)
+        stats = &local;
+
+    buffer.insert(buffer.end(), DELTA_MAGIC, DELTA_MAGIC + 4);
+    put<uint16_t>(buffer, DELTA_VERSION);
+    for (int f = 0; f < NUM_SAVE_FILES; ++f)
+        put<uint64_t>(buffer, hash64(base[f], file_size[f]));
+    for (int f = 0; f < NUM_SAVE_FILES; ++f)
+        put<uint64_t>(buffer, hash64(target[f], file_size[f]));
+
+    for (int f = 0; f < NUM_SAVE_FILES; ++f) {
+        size_t record_size = save_file_record_size((save_file) f);
+        size_t records = file_size[f] / record_size;
+
+        for (size_t r = 0; r < records; ++r) {
+            const uint8_t *a = base[f] + r * record_size, *b = target[f] + r * record_size;
+            if (0 == memcmp(a, b, record_size))
+                continue;
+
+            size_t header = buffer.size();
+            put<uint32_t>(buffer, (uint32_t) r);
+            put<uint16_t>(buffer, 0);
+            uint16_t runs = encode_record(a, b, record_size, buffer);
+            memcpy(buffer.data() + header + sizeof(uint32_t), &runs, sizeof(runs));
+
+            ++stats->records;
+            stats->runs += runs;
+        }
+        put<uint32_t>(buffer, DELTA_END_OF_FILE);
+
+        /* Stream a file at a time */
+        out.write(reinterpret_cast<const char *>(buffer.data()), buffer.size());
+        stats->bytes += buffer.size();
+        buffer.clear();
+    }
+
+    if (!out)
+        throw std::runtime_error("Could not write pm3 delta");
+}
+
+bool apply_delta(std::istream &in, struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) {
+    char magic[4];
+    if (!in.read(magic, 4)) {
+        if (in.gcount() == 0)
+            return false;
+        throw std::runtime_error("Truncated pm3 delta");
+    }
+    if (memcmp(magic, DELTA_MAGIC, 4) != 0 || get<uint16_t>(in) != DELTA_VERSION)
+        throw std::runtime_error("Not a pm3 delta");
+
+    uint8_t *data[NUM_SAVE_FILES] = {
+            reinterpret_cast<uint8_t *>(&game_data),
+            reinterpret_cast<uint8_t *>(&club_data),
+            reinterpret_cast<uint8_t *>(&player_data)
+    };
+    uint64_t base_hash[NUM_SAVE_FILES], target_hash[NUM_SAVE_FILES];
+    for (uint64_t &h : base_hash)
+        h = get<uint64_t>(in);
+    for (uint64_t &h : target_hash)
+        h = get<uint64_t>(in);
+
+    for (int f = 0; f < NUM_SAVE_FILES; ++f) {
+        if (hash64(data[f], file_size[f]) != base_hash[f])
+            throw std::runtime_error("pm3 delta was made from another savegame");
+    }
+
+    /* Patch copies, so that a corrupt delta leaves the savegame alone */
+    std::unique_ptr<uint8_t[]> copies[NUM_SAVE_FILES];
+    for (int f = 0; f < NUM_SAVE_FILES; ++f) {
+        size_t record_size = save_file_record_size((save_file) f);
+        std::unique_ptr<uint8_t[]> copy(new uint8_t[file_size[f]]);
+        memcpy(copy.get(), data[f], file_size[f]);
+
+        for (uint32_t record; (record = get<uint32_t>(in)) != DELTA_END_OF_FILE;) {
+            if ((size_t) record >= file_size[f] / record_size)
+                throw std::runtime_error("Corrupt pm3 delta");
+
+            uint8_t *p = copy.get() + record * record_size;
+            size_t at = 0;
+            for (uint16_t runs = get<uint16_t>(in); runs; --runs) {
+                uint16_t skip = get<uint16_t>(in), length = get<uint16_t>(in);
+                bool fill = length & DELTA_FILL;
+                length &= ~DELTA_FILL;
+                at += skip;
+                if (at + length > record_size)
+                    throw std::runtime_error("Corrupt pm3 delta");
+
+                if (fill)
+                    memset(p + at, get<uint8_t>(in), length);
+                else if (!in.read(reinterpret_cast<char *>(p + at), length))
+                    throw std::runtime_error("Truncated pm3 delta");
+                at += length;
+            }
+        }
+
+        if (hash64(copy.get(), file_size[f]) != target_hash[f])
+            throw std::runtime_error("Corrupt pm3 delta");
+        copies[f] = std::move(copy);
+    }
+
+    for (int f = 0; f < NUM_SAVE_FILES; ++f)
+        memcpy(data[f], copies[f].get(), file_size[f]);
+    return true;
+}
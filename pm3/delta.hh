@@ -0,0 +1,49 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+#include "pm3.hh"
+
+#define DELTA_MAGIC "PM3D"
+#define DELTA_VERSION 1
+
+/* Runs of at least this many equal bytes are stored as a fill */
+#define DELTA_FILL_MIN 6
+/* Unchanged gaps shorter than a run header are copied instead of starting a new run */
+#define DELTA_GAP_MAX 4
+
+struct delta_stats {
+    size_t records = 0;   // changed records
+    size_t runs = 0;
+    size_t bytes = 0;     // size of the delta
+};
+
+/*
+ * Delta from one savegame to the next, record by record.
+ *
+ *   "PM3D" version:u16 base_hash:u64[3] target_hash:u64[3]
+ *   per file A, B, C:
+ *     { record:u32 runs:u16 { skip:u16 length:u16 data } * } * 0xffffffff
+ *
+ * Records are a club or player, or the whole of gamea. skip counts the bytes
+ * left alone since the end of the previous run of the record. A length with
+ * its top bit set is a fill of one byte, otherwise length literal bytes
+ * follow. The hashes are XXH64 of each file before and after, so a delta is
+ * never applied to the wrong base. Deltas can be written one after another
+ * into the same stream to make a chain.
+ */
+void write_delta(std::ostream &out, const struct gamea &base_game, const struct gameb &base_club,
+                 const struct gamec &base_player, const struct gamea &game_data, const struct gameb &club_data,
+                 const struct gamec &player_data, struct delta_stats *stats = nullptr);
+
+/*
+ * Applies the next delta of the stream. Returns false at the end of the
+ * stream, throws std::runtime_error if the delta is corrupt or was made
+ * from another base, leaving the triple as it was.
+ */
+bool apply_delta(std::istream &in, struct gamea &game_data, struct gameb &club_data, struct gamec &player_data);
+
+#endif
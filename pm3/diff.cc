@@ -0,0 +1,54 @@
+#include "diff.hh"
+
+#include <algorithm>
+
+namespace {
+
+/* Decodes the changed fields of one record */
+template <typename T>
+bool diff_record(save_file file, int record, const T &a, const T &b, struct save_diff &result,
+                 const char *skip = nullptr) {
+    size_t before = result.changes.size();
+
+    diff_fields(a, b, [&](const struct field_desc &f, int e, const uint8_t *pa, const uint8_t *pb) {
+        if (skip && 0 == strcmp(f.name, skip))
+            return;
+        result.changes.push_back({file, schema<T>::name, record, &f, e, field_to_string(pa, f, e),
+                                  field_to_string(pb, f, e)});
+    });
+    return result.changes.size() != before;
+}
+
+template <typename T>
+void diff_records(save_file file, const T *a, const T *b, int count, struct save_diff &result) {
+    result.records += count;
+
+    for (int first = 0; first < count; first += DIFF_BLOCK_RECORDS) {
+        int n = std::min(DIFF_BLOCK_RECORDS, count - first);
+        if (0 == memcmp(a + first, b + first, n * sizeof(T)))
+            continue;
+
+        for (int i = first; i < first + n; ++i) {
+            if (0 != memcmp(a + i, b + i, sizeof(T)) && diff_record(file, i, a[i], b[i], result))
+                ++result.changed;
+        }
+    }
+}
+
+}
+
+void diff_saves(const struct gamea &a_game, const struct gameb &a_club, const struct gamec &a_player,
+                const struct gamea &b_game, const struct gameb &b_club, const struct gamec &b_player,
+                struct save_diff &result) {
+    result.records += 1;
+    if (0 != memcmp(&a_game, &b_game, sizeof(struct gamea))) {
+        if (diff_record(SAVE_GAMEA, -1, a_game, b_game, result, "manager"))
+            ++result.changed;
+        diff_records(SAVE_GAMEA, a_game.manager, b_game.manager, 2, result);
+    } else {
+        result.records += 2;
+    }
+
+    diff_records(SAVE_GAMEB, a_club.club, b_club.club, CLUB_IDX_MAX, result);
+    diff_records(SAVE_GAMEC, a_player.player, b_player.player, 3932, result);
+}
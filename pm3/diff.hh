@@ -0,0 +1,40 @@
+#ifndef DIFF_H
+#define DIFF_H
+
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+#include "schema.hh"
+#include "journal.hh"
+
+/* Records compared per memcmp before looking at them one by one */
+#define DIFF_BLOCK_RECORDS 64
+
+struct record_change {
+    save_file file;
+    const char *record_type;        // schema name: gamea, manager, club or player
+    int record;                     // manager, club or player index, -1 for gamea itself
+    const struct field_desc *field;
+    int element;
+    std::string before;
+    std::string after;
+};
+
+struct save_diff {
+    size_t records = 0;             // compared
+    size_t changed = 0;             // records with at least one change
+    std::vector<struct record_change> changes;
+};
+
+/*
+ * Field by field changes from the first triple to the second. Clubs and
+ * players are compared a block of records at a time, and only the records
+ * of a block that differs are compared alone and decoded with their schema.
+ * The managers in gamea are decoded as records of their own.
+ */
+void diff_saves(const struct gamea &a_game, const struct gameb &a_club, const struct gamec &a_player,
+                const struct gamea &b_game, const struct gameb &b_club, const struct gamec &b_player,
+                struct save_diff &result);
+
+#endif
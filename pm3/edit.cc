@@ -0,0 +1,349 @@
+#include "edit.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+static bool parse_number(const std::string &token, int64_t min, int64_t max, int64_t &value) {
+    char *end;
+    errno = 0;
+    long long v = strtoll(token.c_str(), &end, 0);
+    if (token.empty() || *end || errno || v < min || v > max)
+        return false;
+    value = v;
+    return true;
+}
+
+/* Club and player indexes have to name one, or be -1 for none, whatever the width of the field */
+static int64_t edit_min(const struct field_desc &f) {
+    if (f.type == FIELD_CLUB_IDX || f.type == FIELD_PLAYER_IDX)
+        return std::max<int64_t>(field_min(f), -1);
+    return field_min(f);
+}
+
+static int64_t edit_max(const struct field_desc &f) {
+    if (f.type == FIELD_CLUB_IDX)
+        return std::min<int64_t>(field_max(f), CLUB_IDX_MAX - 1);
+    if (f.type == FIELD_PLAYER_IDX)
+        return std::min<int64_t>(field_max(f), 3931);
+    return field_max(f);
+}
+
+template <typename T>
+static bool parse_field(std::istringstream &words, struct edit_command &command, std::string &error) {
+    std::string name, value;
+    if (!(words >> name)) {
+        error = "missing field name";
+        return false;
+    }
+
+    command.element = 0;
+    size_t bracket = name.find('[');
+    if (bracket != std::string::npos) {
+        int64_t element;
+        if (name.back() != ']' ||
+            !parse_number(name.substr(bracket + 1, name.size() - bracket - 2), 0, UINT16_MAX, element)) {
+            error = "bad element in " + name;
+            return false;
+        }
+        command.element = (int) element;
+        name.resize(bracket);
+    }
+
+    command.field = find_field<T>(name);
+    if (!command.field) {
+        error = std::string("unknown ") + schema<T>::name + " field " + name;
+        return false;
+    }
+    if (command.element >= command.field->count) {
+        error = name + " has " + std::to_string(command.field->count) + " elements";
+        return false;
+    }
+
+    if (command.field->type == FIELD_TEXT) {
+        std::getline(words >> std::ws, command.text);
+        if (command.text.size() > command.field->width) {
+            error = name + " is at most " + std::to_string(command.field->width) + " characters";
+            return false;
+        }
+        return true;
+    }
+
+    if (!is_numeric(*command.field)) {
+        error = name + " can not be edited";
+        return false;
+    }
+
+    if (!(words >> value) ||
+        !parse_number(value, edit_min(*command.field), edit_max(*command.field), command.value)) {
+        error = name + " must be between " + std::to_string(edit_min(*command.field)) + " and " +
+                std::to_string(edit_max(*command.field));
+        return false;
+    }
+
+    return true;
+}
+
+static bool parse_edit_line(const std::string &line, struct edit_command &command, std::string &error) {
+    std::istringstream words(line);
+    std::string verb, token;
+    int64_t value;
+
+    words >> verb;
+    command.field = nullptr;
+    command.slot = -1;
+
+    if (verb == "transform") {
+        std::string filter, transforms;
+        command.type = EDIT_TRANSFORM;
+        if (!(words >> filter >> transforms)) {
+            error = "transform needs a filter and transforms";
+            return false;
+        }
+        if ((filter != "all" && !parse_player_filter(filter, command.filter, error)) ||
+            !parse_player_transforms(transforms, command.transforms, error))
+            return false;
+    } else if (verb == "boost") {
+        std::string scope;
+        int64_t max;
+
+        words >> scope;
+        if (scope != "club" && scope != "division") {
+            error = "boost needs club or division";
+            return false;
+        }
+        command.type = scope == "club" ? EDIT_BOOST_CLUB : EDIT_BOOST_DIVISION;
+        max = scope == "club" ? CLUB_IDX_MAX - 1 : 4;
+        if (!(words >> token) || !parse_number(token, 0, max, value)) {
+            error = scope + " must be between 0 and " + std::to_string(max);
+            return false;
+        }
+        command.index = (int) value;
+
+        command.profile = &boost_profiles[0];
+        command.positions = POSITIONS_SLOT;
+        while (words >> token) {
+            if (token == "slot") {
+                command.positions = POSITIONS_SLOT;
+            } else if (token == "inferred") {
+                command.positions = POSITIONS_INFERRED;
+            } else if (!(command.profile = find_boost_profile(token.c_str()))) {
+                error = "unknown profile " + token;
+                return false;
+            }
+        }
+    } else if (verb == "player" || verb == "club" || verb == "manager" || verb == "bank" || verb == "move") {
+        int64_t max = verb == "manager" ? 1 : verb == "club" || verb == "bank" ? CLUB_IDX_MAX - 1 : 3931;
+        if (!(words >> token) || !parse_number(token, 0, max, value)) {
+            error = verb + " index must be between 0 and " + std::to_string(max);
+            return false;
+        }
+        command.index = (int) value;
+    } else {
+        error = "unknown command " + verb;
+        return false;
+    }
+
+    if (verb == "player") {
+        command.type = EDIT_PLAYER;
+        if (!parse_field<struct gamec::player>(words, command, error))
+            return false;
+    } else if (verb == "club") {
+        command.type = EDIT_CLUB;
+        if (!parse_field<struct gameb::club>(words, command, error))
+            return false;
+    } else if (verb == "manager") {
+        std::streampos field_start = words.tellg();
+        if (words >> token && token == "club") {
+            command.type = EDIT_MANAGER_CLUB;
+            if (!(words >> token) || !parse_number(token, 0, 113, command.value)) {
+                error = "manager club must be between 0 and 113";
+                return false;
+            }
+        } else {
+            command.type = EDIT_MANAGER;
+            words.clear();
+            words.seekg(field_start);
+            if (!parse_field<struct gamea::manager>(words, command, error))
+                return false;
+            /* Taking over a club changes more than the index, see change_club */
+            if (0 == strcmp(command.field->name, "club_idx")) {
+                error = "use manager N club 0-113 to change the club of a manager";
+                return false;
+            }
+        }
+    } else if (verb == "bank") {
+        command.type = EDIT_CLUB;
+        command.field = find_field<struct gameb::club>("bank_account");
+        command.element = 0;
+        if (!(words >> token) ||
+            !parse_number(token, field_min(*command.field), field_max(*command.field), command.value)) {
+            error = "bad bank balance";
+            return false;
+        }
+    } else if (verb == "move") {
+        command.type = EDIT_MOVE;
+        if (!(words >> token) || !parse_number(token, 0, CLUB_IDX_MAX - 1, command.value)) {
+            error = "move club must be between 0 and " + std::to_string(CLUB_IDX_MAX - 1);
+            return false;
+        }
+        if (words >> token) {
+            if (!parse_number(token, 0, 23, value)) {
+                error = "move slot must be between 0 and 23";
+                return false;
+            }
+            command.slot = (int) value;
+        }
+    }
+
+    bool text = command.field && command.field->type == FIELD_TEXT;
+    if (!text && words >> token) {
+        error = "trailing " + token;
+        return false;
+    }
+
+    return true;
+}
+
+bool parse_edit_script(std::istream &in, std::vector<struct edit_command> &commands, std::string &error) {
+    std::string line;
+    int line_nr = 0;
+
+    while (std::getline(in, line)) {
+        ++line_nr;
+
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.resize(comment);
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        struct edit_command command{};
+        command.line = line_nr;
+        if (!parse_edit_line(line, command, error)) {
+            error = "line " + std::to_string(line_nr) + ": " + error;
+            return false;
+        }
+        commands.push_back(command);
+    }
+
+    return true;
+}
+
+static void edit_field(void *record, const struct edit_command &command, edit_journal &journal) {
+    const struct field_desc &f = *command.field;
+    uint8_t *p = static_cast<uint8_t *>(record) + f.offset + command.element * f.width;
+
+    journal.touch(p, f.width);
+    if (f.type == FIELD_TEXT) {
+        memset(p, 0, f.width);
+        memcpy(p, command.text.data(), command.text.size());
+    } else {
+        set_field(record, f, command.value, command.element);
+    }
+}
+
+static bool move_player(const struct edit_command &command, edit_journal &journal, std::string &error,
+                        struct gameb &club_data) {
+    struct gameb::club &to = club_data.club[command.value];
+    int slot = command.slot;
+
+    if (slot == -1) {
+        for (int i = 0; i < 24 && slot == -1; ++i) {
+            if (to.player_index[i] == -1 || to.player_index[i] == command.index)
+                slot = i;
+        }
+        if (slot == -1) {
+            error = "no free slot in club " + std::to_string(command.value);
+            return false;
+        }
+    } else if (to.player_index[slot] != -1 && to.player_index[slot] != command.index) {
+        error = "slot " + std::to_string(slot) + " of club " + std::to_string(command.value) + " is taken";
+        return false;
+    }
+
+    for (int c = 0; c < CLUB_IDX_MAX; ++c) {
+        struct gameb::club &club = club_data.club[c];
+        for (int i = 0; i < 24; ++i) {
+            if (club.player_index[i] == command.index) {
+                journal.touch(&club.player_index[i], sizeof(club.player_index[i]));
+                club.player_index[i] = -1;
+            }
+        }
+    }
+
+    journal.touch(&to.player_index[slot], sizeof(to.player_index[slot]));
+    to.player_index[slot] = (int16_t) command.index;
+    return true;
+}
+
+/* One command; false with the reason in error if it cannot be applied */
+static bool apply_edit(const struct edit_command &command, const std::string &game_path,
+                       edit_journal &journal, std::string &error,
+                       struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) {
+    switch (command.type) {
+        case EDIT_PLAYER:
+            edit_field(&player_data.player[command.index], command, journal);
+            break;
+        case EDIT_CLUB:
+            edit_field(&club_data.club[command.index], command, journal);
+            break;
+        case EDIT_MANAGER:
+            edit_field(&game_data.manager[command.index], command, journal);
+            break;
+        case EDIT_MANAGER_CLUB: {
+            /* The second manager of a one player game has no club to hand over */
+            int16_t club_idx = game_data.manager[command.index].club_idx;
+            if (club_idx < 0 || club_idx >= CLUB_IDX_MAX) {
+                error = "manager " + std::to_string(command.index) + " has no club";
+                return false;
+            }
+            change_club((int16_t) command.value, game_path.c_str(), command.index, &journal,
+                        game_data, club_data);
+            break;
+        }
+        case EDIT_MOVE:
+            return move_player(command, journal, error, club_data);
+        case EDIT_BOOST_CLUB:
+        case EDIT_BOOST_DIVISION: {
+            struct boost_summary summary{};
+            if (command.type == EDIT_BOOST_CLUB)
+                boost_club(command.index, *command.profile, command.positions, summary, &journal,
+                           game_data, club_data, player_data);
+            else
+                boost_division(command.index, *command.profile, command.positions, summary, &journal,
+                               game_data, club_data, player_data);
+            break;
+        }
+        case EDIT_TRANSFORM:
+            transform_players(select_players(command.filter, game_data, club_data, player_data),
+                              command.transforms, &journal, player_data);
+            break;
+    }
+    return true;
+}
+
+bool apply_edits(const std::vector<struct edit_command> &commands, const std::string &game_path,
+                 edit_journal &journal, std::string &error,
+                 struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) {
+    for (const struct edit_command &command : commands) {
+        bool applied;
+        try {
+            applied = apply_edit(command, game_path, journal, error, game_data, club_data, player_data);
+        } catch (const std::exception &e) {
+            /* The default club data of change_club may be missing */
+            error = e.what();
+            applied = false;
+        }
+
+        if (!applied) {
+            error = "line " + std::to_string(command.line) + ": " + error;
+            journal.rollback();
+            return false;
+        }
+    }
+
+    return true;
+}
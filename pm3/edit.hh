@@ -0,0 +1,72 @@
+#ifndef EDIT_H
+#define EDIT_H
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+#include "schema.hh"
+#include "journal.hh"
+#include "transform.hh"
+#include "boost.hh"
+
+/*
+ * Line-oriented edit scripts, one command per line, '#' starts a comment:
+ *
+ *   player <0-3931> <field>[<element>] <value>
+ *   club <0-243> <field>[<element>] <value>
+ *   manager <0-1> <field>[<element>] <value>
+ *   manager <0-1> club <0-113>
+ *   bank <0-243> <amount>
+ *   move <0-3931> <0-243> [<0-23>]
+ *   transform all|<filter> <transforms>
+ *   boost club <0-243>|division <0-4> [<profile>] [slot|inferred]
+ *
+ * Fields are looked up in the schema tables; text fields take the rest of the
+ * line. move takes the player out of every club squad it is in and puts it
+ * into the given slot, or the first free one. transform takes the filter and
+ * transform lists of parse_player_filter and parse_player_transforms.
+ */
+
+typedef enum {
+    EDIT_PLAYER,
+    EDIT_CLUB,
+    EDIT_MANAGER,
+    EDIT_MANAGER_CLUB,
+    EDIT_MOVE,
+    EDIT_TRANSFORM,
+    EDIT_BOOST_CLUB,
+    EDIT_BOOST_DIVISION
+} edit_type;
+
+struct edit_command {
+    edit_type type;
+    int line;
+    int index;                      // player, club or manager
+    const struct field_desc *field; // nullptr for moves and manager club changes
+    int element;
+    int64_t value;                  // field value, destination club or new manager club
+    int slot;                       // destination slot of a move, -1 for the first free one
+    std::string text;               // value of a text field
+    struct player_filter filter;
+    std::vector<struct player_transform> transforms;
+    const struct boost_profile *profile;
+    position_source positions;
+};
+
+/* Parse and range-check a whole script. Stops at the first bad line. */
+bool parse_edit_script(std::istream &in, std::vector<struct edit_command> &commands, std::string &error);
+
+/*
+ * Apply the commands in order, recording every change in the journal, which
+ * must be bound to the same savegame. Checks that depend on the savegame
+ * (a free squad slot for a move, a club for the manager to leave) happen
+ * here; if one fails, or a command cannot read what it needs, the journal
+ * is rolled back and the savegame is left untouched.
+ */
+bool apply_edits(const std::vector<struct edit_command> &commands, const std::string &game_path,
+                 edit_journal &journal, std::string &error,
+                 struct gamea &game_data = gamea, struct gameb &club_data = gameb, struct gamec &player_data = gamec);
+
+#endif
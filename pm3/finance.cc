@@ -0,0 +1,426 @@
+#include "finance.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "calendar.hh"
+
+void attendance_model::features(const struct stand_features &x, double row[ATTENDANCE_FEATURES]) {
+    row[0] = 1;
+    row[1] = std::log(std::max(1.0, x.price));
+    row[2] = std::log(std::max(1.0, x.capacity));
+    row[3] = x.safety;
+    row[4] = x.facilities;
+    row[5] = x.division;
+    row[6] = x.terrace;
+}
+
+void attendance_model::coefficients(double beta[ATTENDANCE_FEATURES]) const {
+    const double values[ATTENDANCE_FEATURES] = {intercept, price, capacity, safety, facilities, division, terrace};
+    std::copy(values, values + ATTENDANCE_FEATURES, beta);
+}
+
+void attendance_model::set_coefficients(const double beta[ATTENDANCE_FEATURES]) {
+    intercept = beta[0];
+    price = beta[1];
+    capacity = beta[2];
+    safety = beta[3];
+    facilities = beta[4];
+    division = beta[5];
+    terrace = beta[6];
+}
+
+double attendance_model::log_demand(const struct stand_features &x) const {
+    double row[ATTENDANCE_FEATURES], beta[ATTENDANCE_FEATURES], sum = 0;
+
+    features(x, row);
+    coefficients(beta);
+    for (int i = 0; i < ATTENDANCE_FEATURES; ++i)
+        sum += beta[i] * row[i];
+    return sum;
+}
+
+double attendance_model::predict(const struct stand_features &x, double offset) const {
+    if (x.capacity <= 0)
+        return 0;
+    return std::min(x.capacity, std::exp(log_demand(x) + offset));
+}
+
+struct stand_features stadium_features(const struct gamea::manager &manager, stand_type type, bool cup) {
+    const auto &stadium = manager.stadium;
+    struct stand_features x{};
+
+    if (type == STAND_SEATING)
+        x.price = cup ? manager.price.cup_match_seating : manager.price.league_match_seating;
+    else
+        x.price = cup ? manager.price.cup_match_terrace : manager.price.league_match_terrace;
+
+    for (int i = 0; i < 4; ++i) {
+        if (stadium.capacity[i].terraces == (type == STAND_TERRACE))
+            x.capacity += stadium.capacity[i].seating;
+        x.safety += stadium.safety_rating[i] / 4.0;
+    }
+
+    x.facilities = stadium.ground_facilities.level + stadium.supporters_club.level + stadium.flood_lights.level +
+                   stadium.scoreboard.level + stadium.undersoil_heating.level + stadium.changing_rooms.level +
+                   stadium.gymnasium.level + stadium.car_park.level;
+    x.division = std::max<int>(0, std::min<int>(4, manager.division));
+    x.terrace = type == STAND_TERRACE;
+    return x;
+}
+
+namespace {
+
+/* Average of the matches in the history so far, 0 if there are none */
+double average_attendance(const uint32_t *history) {
+    uint64_t total = 0;
+    int matches = 0;
+
+    for (int i = 0; i < ATTENDANCE_HISTORY; ++i) {
+        if (history[i]) {
+            total += history[i];
+            ++matches;
+        }
+    }
+    return matches ? (double) total / matches : 0;
+}
+
+double takings(const struct finance_projection &p, const struct attendance_model &model, bool cup, stand_type type,
+               double price) {
+    struct stand_features x = p.stand[cup][type];
+    x.price = price;
+    return model.predict(x, p.offset[type]) * price;
+}
+
+void balances(const struct finance_projection &p, double league_gate, double cup_gate, struct price_scenario &s) {
+    int64_t receipts = 0;
+
+    s.final_balance = s.lowest_balance = p.balance;
+    s.overdraft_turn = p.balance < 0 ? p.turn : -1;
+    for (size_t k = 0; k < p.base.size(); ++k) {
+        receipts = std::llround(league_gate * p.league_homes[k] + cup_gate * p.cup_homes[k]);
+        s.final_balance = p.base[k] + receipts;
+        s.lowest_balance = std::min(s.lowest_balance, s.final_balance);
+        if (s.final_balance < 0 && s.overdraft_turn == -1)
+            s.overdraft_turn = p.turn + (int) k;
+    }
+    s.receipts = receipts;
+}
+
+}
+
+void attendance_sample::add(const struct gamea &game_data) {
+    for (const struct gamea::manager &m : game_data.manager) {
+        if (m.club_idx < 0 || m.club_idx >= CLUB_IDX_MAX)
+            continue;
+
+        uint32_t history[NUM_STAND_TYPES][ATTENDANCE_HISTORY];
+        memcpy(history[STAND_SEATING], m.seating_history, sizeof(history[STAND_SEATING]));
+        memcpy(history[STAND_TERRACE], m.terrace_history, sizeof(history[STAND_TERRACE]));
+
+        for (int type = 0; type < NUM_STAND_TYPES; ++type) {
+            struct stand_features x = stadium_features(m, (stand_type) type, false);
+            double row[ATTENDANCE_FEATURES];
+            attendance_model::features(x, row);
+
+            for (uint32_t seen : history[type]) {
+                if (!seen || seen >= x.capacity)
+                    continue;
+                for (int i = 0; i < ATTENDANCE_FEATURES; ++i)
+                    column[i].push_back(row[i]);
+                log_attendance.push_back(std::log((double) seen));
+            }
+        }
+    }
+    ++saves;
+}
+
+namespace {
+
+/* Normal equations of a share of the rows */
+struct normal_equations {
+    double xtx[ATTENDANCE_FEATURES][ATTENDANCE_FEATURES] = {};
+    double xty[ATTENDANCE_FEATURES] = {};
+    double yy = 0, y = 0;
+
+    void sum(const struct attendance_sample &sample, size_t first, size_t end) {
+        for (int i = 0; i < ATTENDANCE_FEATURES; ++i) {
+            const double *xi = sample.column[i].data();
+            const double *target = sample.log_attendance.data();
+            for (int j = i; j < ATTENDANCE_FEATURES; ++j) {
+                const double *xj = sample.column[j].data();
+                double s = 0;
+                for (size_t r = first; r < end; ++r)
+                    s += xi[r] * xj[r];
+                xtx[i][j] += s;
+            }
+            double s = 0;
+            for (size_t r = first; r < end; ++r)
+                s += xi[r] * target[r];
+            xty[i] += s;
+        }
+        for (size_t r = first; r < end; ++r) {
+            yy += sample.log_attendance[r] * sample.log_attendance[r];
+            y += sample.log_attendance[r];
+        }
+    }
+};
+
+/* Gaussian elimination with partial pivoting; false if singular */
+bool solve(double a[ATTENDANCE_FEATURES][ATTENDANCE_FEATURES], double b[ATTENDANCE_FEATURES]) {
+    const int n = ATTENDANCE_FEATURES;
+
+    for (int col = 0; col < n; ++col) {
+        int pivot = col;
+        for (int r = col + 1; r < n; ++r) {
+            if (std::fabs(a[r][col]) > std::fabs(a[pivot][col]))
+                pivot = r;
+        }
+        if (std::fabs(a[pivot][col]) < 1e-12)
+            return false;
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+
+        for (int r = col + 1; r < n; ++r) {
+            double f = a[r][col] / a[col][col];
+            for (int k = col; k < n; ++k)
+                a[r][k] -= f * a[col][k];
+            b[r] -= f * b[col];
+        }
+    }
+    for (int r = n - 1; r >= 0; --r) {
+        for (int k = r + 1; k < n; ++k)
+            b[r] -= a[r][k] * b[k];
+        b[r] /= a[r][r];
+    }
+    return true;
+}
+
+}
+
+struct attendance_fit fit_attendance(const struct attendance_sample &sample, const struct attendance_model &prior,
+                                     int threads) {
+    const int n = ATTENDANCE_FEATURES;
+    struct attendance_fit fit{};
+    size_t rows = sample.size();
+
+    fit.model = prior;
+    fit.samples = rows;
+    if (!rows)
+        return fit;
+
+    if (!threads)
+        threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1, std::min<int>(threads, (int) rows));
+
+    std::vector<struct normal_equations> part(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+        pool.emplace_back(&normal_equations::sum, &part[t], std::cref(sample), rows * t / threads,
+                          rows * (t + 1) / threads);
+    for (std::thread &thread : pool)
+        thread.join();
+
+    struct normal_equations total;
+    for (const struct normal_equations &p : part) {
+        for (int i = 0; i < n; ++i) {
+            for (int j = i; j < n; ++j)
+                total.xtx[i][j] += p.xtx[i][j];
+            total.xty[i] += p.xty[i];
+        }
+        total.yy += p.yy;
+        total.y += p.y;
+    }
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < i; ++j)
+            total.xtx[i][j] = total.xtx[j][i];
+    }
+
+    /* Ridge towards the prior: (X'X + lI) b = X'y + l b0 */
+    const double ridge = 1e-3 * rows;
+    double a[ATTENDANCE_FEATURES][ATTENDANCE_FEATURES], beta[ATTENDANCE_FEATURES], b0[ATTENDANCE_FEATURES];
+    prior.coefficients(b0);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j)
+            a[i][j] = total.xtx[i][j] + (i == j ? ridge : 0);
+        beta[i] = total.xty[i] + ridge * b0[i];
+    }
+    if (!solve(a, beta))
+        return fit;
+    fit.model.set_coefficients(beta);
+
+    /* Residual sum of squares from the normal equations: y'y - 2b'X'y + b'X'Xb */
+    double sse = total.yy;
+    for (int i = 0; i < n; ++i) {
+        sse -= 2 * beta[i] * total.xty[i];
+        for (int j = 0; j < n; ++j)
+            sse += beta[i] * total.xtx[i][j] * beta[j];
+    }
+    sse = std::max(0.0, sse);
+    double sst = total.yy - total.y * total.y / rows;
+    fit.rmse = std::sqrt(sse / rows);
+    fit.r2 = sst > 0 ? 1 - sse / sst : 0;
+    return fit;
+}
+
+double finance_projection::gate(bool cup, double seating_price, double terrace_price,
+                                const struct attendance_model &model) const {
+    return takings(*this, model, cup, STAND_SEATING, seating_price) +
+           takings(*this, model, cup, STAND_TERRACE, terrace_price);
+}
+
+struct finance_projection project_finances(int manager, const struct attendance_model &model,
+                                           const struct gamea &game_data, const struct gameb &club_data) {
+    const struct gamea::manager &m = game_data.manager[manager];
+    const auto &s = m.bank_statement[1];
+    struct finance_projection p{};
+
+    if (m.club_idx < 0 || m.club_idx >= CLUB_IDX_MAX)
+        throw std::runtime_error("manager " + std::to_string(manager) + " has no club");
+
+    p.manager = manager;
+    p.club_idx = m.club_idx;
+    p.turn = std::min<int>(game_data.turn, TIMETABLE_SLOTS);
+    p.balance = club_data.club[p.club_idx].bank_account;
+
+    /* Credit less debit of the season so far, per turn */
+    auto net = [](int32_t debit, int32_t credit) { return (int64_t) credit - debit; };
+    int64_t running = net(s.club_wages[0], s.club_wages[1]) + net(s.club_fines[0], s.club_fines[1]) +
+                      net(s.grants_for_club[0], s.grants_for_club[1]) + net(s.club_bills[0], s.club_bills[1]) +
+                      net(s.miscellaneous_sales[0], s.miscellaneous_sales[1]) +
+                      net(s.advertising_boards[0], s.advertising_boards[1]) +
+                      net(s.other_items[0], s.other_items[1]) +
+                      net(s.account_interest[0], s.account_interest[1]);
+    p.running = p.turn ? (double) running / p.turn : 0;
+
+    for (int cup = 0; cup < 2; ++cup) {
+        p.stand[cup][STAND_SEATING] = stadium_features(m, STAND_SEATING, cup);
+        p.stand[cup][STAND_TERRACE] = stadium_features(m, STAND_TERRACE, cup);
+    }
+
+    uint32_t history[NUM_STAND_TYPES][ATTENDANCE_HISTORY];
+    memcpy(history[STAND_SEATING], m.seating_history, sizeof(history[STAND_SEATING]));
+    memcpy(history[STAND_TERRACE], m.terrace_history, sizeof(history[STAND_TERRACE]));
+    for (int type = 0; type < NUM_STAND_TYPES; ++type) {
+        const struct stand_features &x = p.stand[0][type];
+        double seen = average_attendance(history[type]);
+        if (seen <= 0 || x.capacity <= 0)
+            continue;
+
+        /* A full ground only says that demand is at least the capacity */
+        p.offset[type] = std::log(std::min(seen, x.capacity)) - model.log_demand(x);
+        if (seen >= x.capacity)
+            p.offset[type] = std::max(0.0, p.offset[type]);
+    }
+
+    int turns = TIMETABLE_SLOTS - p.turn;
+    p.base.resize(turns);
+    p.league_homes.resize(turns);
+    p.cup_homes.resize(turns);
+
+    calendar cal(club_data);
+    for (const struct fixture *fx : cal.club_fixtures(p.club_idx)) {
+        if (fx->played() || fx->home_idx != p.club_idx || fx->turn() < p.turn)
+            continue;
+        /* Timetable types 10-18 are cup matches */
+        if (fx->type >= 10 && fx->type <= 18)
+            ++p.cup_homes[fx->turn() - p.turn];
+        else
+            ++p.league_homes[fx->turn() - p.turn];
+    }
+
+    std::vector<int64_t> repayments(turns);
+    for (int i = 0; i < 4; ++i) {
+        /* Years and turns left until the loan is repaid, counted from now */
+        int due = m.loan[i].year * TIMETABLE_SLOTS + m.loan[i].turn;
+        if (m.loan[i].amount && due < turns)
+            repayments[due] += m.loan[i].amount;
+    }
+
+    int64_t repaid = 0;
+    for (int k = 0; k < turns; ++k) {
+        repaid += repayments[k];
+        p.base[k] = p.balance + std::llround(p.running * (k + 1)) - repaid;
+        if (k) {
+            p.league_homes[k] += p.league_homes[k - 1];
+            p.cup_homes[k] += p.cup_homes[k - 1];
+        }
+    }
+
+    return p;
+}
+
+struct price_scenario current_prices(const struct finance_projection &p, const struct attendance_model &model) {
+    struct price_scenario s{};
+
+    s.seating = (uint8_t) p.stand[0][STAND_SEATING].price;
+    s.terrace = (uint8_t) p.stand[0][STAND_TERRACE].price;
+    balances(p, p.gate(false, s.seating, s.terrace, model),
+             p.gate(true, p.stand[1][STAND_SEATING].price, p.stand[1][STAND_TERRACE].price, model), s);
+    return s;
+}
+
+std::vector<struct price_scenario> sweep_prices(const struct finance_projection &p,
+                                                const struct attendance_model &model, int low, int high,
+                                                int threads) {
+    low = std::max(1, low);
+    high = std::min(255, high);
+    if (high < low)
+        return {};
+
+    int prices = high - low + 1;
+    size_t count = (size_t) prices * prices;
+    std::vector<double> seating(prices), terrace(prices);
+    for (int i = 0; i < prices; ++i) {
+        seating[i] = takings(p, model, false, STAND_SEATING, low + i);
+        terrace[i] = takings(p, model, false, STAND_TERRACE, low + i);
+    }
+    double cup_gate = p.gate(true, p.stand[1][STAND_SEATING].price, p.stand[1][STAND_TERRACE].price, model);
+
+    /* Columns: takings per league match, then balances */
+    std::vector<double> league(count), lowest(count, (double) p.balance), last(count, (double) p.balance);
+    for (size_t s = 0; s < count; ++s)
+        league[s] = seating[s / prices] + terrace[s % prices];
+
+    if (!threads)
+        threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1, std::min<int>(threads, (int) count));
+
+    auto sweep = [&](size_t first, size_t end) {
+        double *gate = league.data(), *low_balance = lowest.data(), *balance = last.data();
+        for (size_t k = 0; k < p.base.size(); ++k) {
+            double fixed = p.base[k] + cup_gate * p.cup_homes[k];
+            double homes = p.league_homes[k];
+            for (size_t s = first; s < end; ++s) {
+                balance[s] = fixed + gate[s] * homes;
+                low_balance[s] = std::min(low_balance[s], balance[s]);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+        pool.emplace_back(sweep, count * t / threads, count * (t + 1) / threads);
+    for (std::thread &thread : pool)
+        thread.join();
+
+    std::vector<struct price_scenario> result(count);
+    for (size_t s = 0; s < count; ++s) {
+        struct price_scenario &r = result[s];
+        r.seating = (uint8_t) (low + s / prices);
+        r.terrace = (uint8_t) (low + s % prices);
+        if (lowest[s] < 0) {
+            /* Only the scenarios that go overdrawn need the turn it happens */
+            balances(p, league[s], cup_gate, r);
+            continue;
+        }
+        r.final_balance = std::llround(last[s]);
+        r.lowest_balance = std::llround(lowest[s]);
+        r.receipts = p.base.empty() ? 0 : r.final_balance - p.base.back();
+        r.overdraft_turn = -1;
+    }
+    return result;
+}
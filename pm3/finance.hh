@@ -0,0 +1,136 @@
+#ifndef FINANCE_H
+#define FINANCE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "pm3.hh"
+
+#define ATTENDANCE_HISTORY 23
+#define ATTENDANCE_FEATURES 7
+
+enum stand_type {
+    STAND_SEATING, STAND_TERRACE, NUM_STAND_TYPES
+};
+
+/* What one kind of place in the ground offers for one match */
+struct stand_features {
+    double price;        // pounds per ticket
+    double capacity;     // places of this kind over all stands
+    double safety;       // average safety rating of the stands
+    double facilities;   // sum of the ground improvement levels
+    int division;
+    bool terrace;
+};
+
+/*
+ * log(attendance) is linear in log(price), log(capacity) and the other
+ * features, and never more than the capacity. Until fitted from real saves
+ * the coefficients are guesses that fill most of a top flight ground at
+ * ten pounds a ticket. Demand is elastic, so takings are highest at the
+ * price that just fills the ground.
+ */
+struct attendance_model {
+    double intercept = 3.35;
+    double price = -1.5;         // elasticity of demand
+    double capacity = 1.0;
+    double safety = 0.002;       // per safety rating point
+    double facilities = 0.02;    // per improvement level
+    double division = -0.15;     // per division below the top flight
+    double terrace = 0.1;
+
+    /* 1, log(price), log(capacity), safety, facilities, division, terrace */
+    static void features(const struct stand_features &x, double row[ATTENDANCE_FEATURES]);
+    void coefficients(double beta[ATTENDANCE_FEATURES]) const;
+    void set_coefficients(const double beta[ATTENDANCE_FEATURES]);
+
+    double log_demand(const struct stand_features &x) const;
+    double predict(const struct stand_features &x, double offset = 0) const;
+};
+
+/*
+ * Attendances from the history of managers' clubs, one column per feature.
+ * Matches played to a full ground are left out, as they only put a floor
+ * under demand. The history keeps no prices, so every match is taken at the
+ * prices the club charges now.
+ */
+struct attendance_sample {
+    std::vector<double> column[ATTENDANCE_FEATURES];
+    std::vector<double> log_attendance;
+    int saves = 0;
+
+    void add(const struct gamea &game_data);
+    size_t size() const { return log_attendance.size(); }
+};
+
+struct attendance_fit {
+    struct attendance_model model;
+    size_t samples;
+    double rmse;       // of log attendance
+    double r2;
+};
+
+/*
+ * Least squares over the sample. Every thread sums the normal equations of
+ * its share of the rows, and the sums are added up and solved. A slight pull
+ * towards the prior keeps features that never vary in the sample (no
+ * terraces anywhere, say) at the prior instead of leaving the system
+ * singular.
+ */
+struct attendance_fit fit_attendance(const struct attendance_sample &sample,
+                                     const struct attendance_model &prior = attendance_model(), int threads = 0);
+
+struct stand_features stadium_features(const struct gamea::manager &manager, stand_type type, bool cup);
+
+/*
+ * Bank balance of a manager's club for every turn to the end of the season.
+ *
+ * Everything but gate receipts runs at the rate of the season statement so
+ * far, with transfers and ground improvements left out as one-offs. Loans are
+ * paid back when they fall due. Gate receipts come from the attendance model,
+ * shifted per kind of place so that it matches the attendance history of the
+ * club at its current prices.
+ */
+struct finance_projection {
+    int manager;
+    int club_idx;
+    int turn;                              // first projected turn
+    int64_t balance;                       // now
+    double running;                        // per turn, without gates and loans
+    double offset[NUM_STAND_TYPES];        // log attendance the model is off by for this club
+    struct stand_features stand[2][NUM_STAND_TYPES];  // league and cup matches
+    std::vector<int64_t> base;             // balance after each turn, without gate receipts
+    std::vector<uint16_t> league_homes;    // home league (and friendly) matches played by each turn
+    std::vector<uint16_t> cup_homes;
+
+    double gate(bool cup, double seating_price, double terrace_price, const struct attendance_model &model) const;
+};
+
+struct price_scenario {
+    uint8_t seating, terrace;              // league ticket prices
+    int64_t receipts;                      // rest of the season, cup matches included
+    int64_t final_balance;
+    int64_t lowest_balance;
+    int overdraft_turn;                    // first turn below zero, -1 if none
+};
+
+/* Throws std::runtime_error if the manager has no club, like the second one of a one player game */
+struct finance_projection project_finances(int manager, const struct attendance_model &model = attendance_model(),
+                                           const struct gamea &game_data = gamea,
+                                           const struct gameb &club_data = gameb);
+
+/* Balance with the current prices, as one scenario */
+struct price_scenario current_prices(const struct finance_projection &p, const struct attendance_model &model);
+
+/*
+ * Every pair of league seating and terrace prices in [low, high]. Prices are
+ * whole pounds, so the takings per match of each price come from a table and
+ * each scenario is a few additions per turn. Scenarios are stored column by
+ * column and the loop over turns runs across a column, which the compiler
+ * vectorizes. The columns are split between threads.
+ */
+std::vector<struct price_scenario> sweep_prices(const struct finance_projection &p,
+                                                const struct attendance_model &model, int low = 1, int high = 60,
+                                                int threads = 0);
+
+#endif
@@ -0,0 +1,117 @@
+#include "fleet.hh"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "hash.hh"
+
+namespace {
+
+std::filesystem::path result_path(const std::string &directory, const std::string &report, uint64_t hash) {
+    char name[17];
+    snprintf(name, sizeof(name), "%016" PRIx64, hash);
+    return std::filesystem::path(directory) / report / name;
+}
+
+void write_file(const std::filesystem::path &path, const std::string &contents) {
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size());
+    out.close();
+    if (!out)
+        throw std::runtime_error("Could not write " + temporary.string());
+
+    std::filesystem::rename(temporary, path);
+}
+
+}
+
+std::vector<struct fleet_save> find_fleet_saves(const std::vector<std::string> &game_paths) {
+    std::vector<struct fleet_save> saves;
+
+    for (const std::string &game_path : game_paths) {
+        for (int nr = 1; nr <= 8; ++nr) {
+            struct fleet_save save{game_path, nr, game_path + ":" + std::to_string(nr), {}};
+            if (stat_save_files(game_path, nr, save.key))
+                saves.push_back(save);
+        }
+    }
+    return saves;
+}
+
+uint64_t save_content_hash(const struct sidecar_key &key) {
+    return hash64(key.hash, sizeof(key.hash), FLEET_CACHE_VERSION);
+}
+
+fleet_cache::fleet_cache(const std::string &directory) : directory(directory) {
+    std::filesystem::create_directories(directory);
+
+    std::ifstream in(std::filesystem::path(directory) / FLEET_MANIFEST_FILE);
+    std::string line;
+    while (std::getline(in, line)) {
+        struct sidecar_key key{};
+        int spec = 0;
+
+        /* size, time and hash of A, B and C, then the save */
+        if (sscanf(line.c_str(), "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNd64 " %" SCNd64 " %" SCNd64
+                                 " %" SCNx64 " %" SCNx64 " %" SCNx64 " %n",
+                   &key.size[0], &key.size[1], &key.size[2], &key.mtime[0], &key.mtime[1], &key.mtime[2],
+                   &key.hash[0], &key.hash[1], &key.hash[2], &spec) != 9 || spec == 0)
+            continue;
+        manifest[line.substr(spec)] = key;
+    }
+}
+
+bool fleet_cache::known(struct fleet_save &save) const {
+    auto it = manifest.find(save.spec);
+    if (it == manifest.end() ||
+        memcmp(it->second.size, save.key.size, sizeof(save.key.size)) != 0 ||
+        memcmp(it->second.mtime, save.key.mtime, sizeof(save.key.mtime)) != 0)
+        return false;
+
+    memcpy(save.key.hash, it->second.hash, sizeof(save.key.hash));
+    return true;
+}
+
+void fleet_cache::remember(const struct fleet_save &save) {
+    manifest[save.spec] = save.key;
+}
+
+void fleet_cache::save_manifest() const {
+    std::ostringstream out;
+
+    for (const auto &entry : manifest) {
+        const struct sidecar_key &key = entry.second;
+        char line[256];
+        snprintf(line, sizeof(line),
+                 "%" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRId64 " %" PRId64 " %" PRId64
+                 " %016" PRIx64 " %016" PRIx64 " %016" PRIx64 " ",
+                 key.size[0], key.size[1], key.size[2], key.mtime[0], key.mtime[1], key.mtime[2],
+                 key.hash[0], key.hash[1], key.hash[2]);
+        out << line << entry.first << '\n';
+    }
+    write_file(std::filesystem::path(directory) / FLEET_MANIFEST_FILE, out.str());
+}
+
+bool fleet_cache::get(const std::string &report, uint64_t hash, std::string &result) const {
+    std::ifstream in(result_path(directory, report, hash), std::ios::binary);
+    if (!in)
+        return false;
+
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    result = contents.str();
+    return true;
+}
+
+void fleet_cache::put(const std::string &report, uint64_t hash, const std::string &result) const {
+    std::filesystem::create_directories(std::filesystem::path(directory) / report);
+    write_file(result_path(directory, report, hash), result);
+}
@@ -0,0 +1,55 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+#include "sidecar.hh"
+
+#define FLEET_CACHE_VERSION 1
+#define FLEET_MANIFEST_FILE "manifest"
+
+/* A savegame of the fleet, N of the install at PATH */
+struct fleet_save {
+    std::string game_path;
+    int game_nr;
+    std::string spec;   // PATH:N
+    struct sidecar_key key;
+};
+
+/* Every savegame 1-8 with all three files present, path by path */
+std::vector<struct fleet_save> find_fleet_saves(const std::vector<std::string> &game_paths);
+
+/* One value for the contents of a save, from the hashes of its files */
+uint64_t save_content_hash(const struct sidecar_key &key);
+
+/*
+ * Report results of many savegames in a directory, keyed by report name and
+ * content hash, so a save is only processed again once it has changed.
+ *
+ * The manifest remembers the size, time and content hashes of every save
+ * seen. A save whose size and times are unchanged gets its content hash from
+ * there without being read. Results are files under DIR/REPORT/, named by
+ * the hash; every file is written aside and renamed into place.
+ */
+class fleet_cache {
+public:
+    explicit fleet_cache(const std::string &directory);
+
+    /* Content hashes of a save from the manifest if its files are unchanged */
+    bool known(struct fleet_save &save) const;
+    void remember(const struct fleet_save &save);
+    void save_manifest() const;
+
+    bool get(const std::string &report, uint64_t hash, std::string &result) const;
+    void put(const std::string &report, uint64_t hash, const std::string &result) const;
+
+private:
+    std::string directory;
+    std::map<std::string, struct sidecar_key> manifest;
+};
+
+#endif
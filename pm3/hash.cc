@@ -0,0 +1,136 @@
+#include "hash.hh"
+
+#include <cstring>
+
+namespace {
+
+const uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+const uint64_t PRIME3 = 0x165667B19E3779F9ull;
+const uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+const uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+inline uint64_t merge_round(uint64_t acc, uint64_t value) {
+    acc ^= round(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+inline uint64_t converge(uint64_t v1, uint64_t v2, uint64_t v3, uint64_t v4) {
+    uint64_t h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = merge_round(h, v1);
+    h = merge_round(h, v2);
+    h = merge_round(h, v3);
+    return merge_round(h, v4);
+}
+
+/* The bytes after the last whole stripe, and the final avalanche */
+uint64_t finish(uint64_t h, const uint8_t *p, const uint8_t *end, size_t length) {
+    h += length;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+    if (p + 4 <= end) {
+        h ^= read32(p) * PRIME1;
+        h = rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= *p * PRIME5;
+        h = rotl(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+}
+
+uint64_t hash64(const void *data, size_t length, uint64_t seed) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    const uint8_t *end = p + length;
+
+    if (length < 32)
+        return finish(seed + PRIME5, p, end, length);
+
+    uint64_t v1 = seed + PRIME1 + PRIME2;
+    uint64_t v2 = seed + PRIME2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - PRIME1;
+
+    for (; p + 32 <= end; p += 32) {
+        v1 = round(v1, read64(p));
+        v2 = round(v2, read64(p + 8));
+        v3 = round(v3, read64(p + 16));
+        v4 = round(v4, read64(p + 24));
+    }
+    return finish(converge(v1, v2, v3, v4), p, end, length);
+}
+
+void hash64_records(const void *first, size_t length, size_t stride, size_t count, uint64_t *out, uint64_t seed) {
+    const uint8_t *records = static_cast<const uint8_t *>(first);
+    size_t stripes = length / 32;
+    size_t i = 0;
+
+    if (!stripes) {
+        for (; i < count; ++i)
+            out[i] = hash64(records + i * stride, length, seed);
+        return;
+    }
+
+    for (; i + HASH_LANES <= count; i += HASH_LANES) {
+        uint64_t v1[HASH_LANES], v2[HASH_LANES], v3[HASH_LANES], v4[HASH_LANES];
+
+        for (int l = 0; l < HASH_LANES; ++l) {
+            v1[l] = seed + PRIME1 + PRIME2;
+            v2[l] = seed + PRIME2;
+            v3[l] = seed;
+            v4[l] = seed - PRIME1;
+        }
+
+        for (size_t s = 0; s < stripes; ++s) {
+            for (int l = 0; l < HASH_LANES; ++l) {
+                const uint8_t *p = records + (i + l) * stride + s * 32;
+                v1[l] = round(v1[l], read64(p));
+                v2[l] = round(v2[l], read64(p + 8));
+                v3[l] = round(v3[l], read64(p + 16));
+                v4[l] = round(v4[l], read64(p + 24));
+            }
+        }
+
+        for (int l = 0; l < HASH_LANES; ++l) {
+            const uint8_t *p = records + (i + l) * stride;
+            out[i + l] = finish(converge(v1[l], v2[l], v3[l], v4[l]), p + stripes * 32, p + length, length);
+        }
+    }
+
+    for (; i < count; ++i)
+        out[i] = hash64(records + i * stride, length, seed);
+}
@@ -0,0 +1,22 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+/* Records hashed side by side by hash64_records */
+#define HASH_LANES 8
+
+/* XXH64 of a buffer; the same value the reference xxHash implementation gives */
+uint64_t hash64(const void *data, size_t length, uint64_t seed = 0);
+
+/*
+ * hash64 of count records of length bytes each, stride bytes apart. The
+ * 32 byte stripes of HASH_LANES records are mixed in lockstep, which keeps
+ * the multipliers busy and lets the compiler vectorize across records; the
+ * results are the same as hashing each record alone.
+ */
+void hash64_records(const void *first, size_t length, size_t stride, size_t count, uint64_t *out,
+                    uint64_t seed = 0);
+
+#endif
@@ -0,0 +1,227 @@
+#include "journal.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#define JOURNAL_MAGIC "PM3J"
+#define JOURNAL_VERSION 2
+/* Magic, version and the two counts; file, record, offset, length and image */
+#define JOURNAL_HEADER_SIZE (4 + 2 + 4 + 4)
+#define JOURNAL_ENTRY_SIZE (1 + 2 + 2 + 2 + 4)
+
+static const size_t save_file_size[NUM_SAVE_FILES] = {
+        sizeof(struct gamea),
+        sizeof(struct gameb),
+        sizeof(struct gamec)
+};
+
+/* Fields are written one by one, little endian as the saves, so no padding ends up in the file */
+template <typename T>
+static void put(std::ostream &out, T value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static T get(std::istream &in) {
+    T value{};
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return value;
+}
+
+size_t save_file_record_size(save_file file) {
+    switch (file) {
+        case SAVE_GAMEB:
+            return sizeof(struct gameb::club);
+        case SAVE_GAMEC:
+            return sizeof(struct gamec::player);
+        default:
+            return sizeof(struct gamea);
+    }
+}
+
+edit_journal::edit_journal(struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) {
+    base[SAVE_GAMEA] = reinterpret_cast<uint8_t *>(&game_data);
+    base[SAVE_GAMEB] = reinterpret_cast<uint8_t *>(&club_data);
+    base[SAVE_GAMEC] = reinterpret_cast<uint8_t *>(&player_data);
+}
+
+void edit_journal::touch(const void *ptr, size_t length) {
+    const uint8_t *p = static_cast<const uint8_t *>(ptr);
+
+    for (int file = 0; file < NUM_SAVE_FILES; ++file) {
+        if (p < base[file] || p + length > base[file] + save_file_size[file])
+            continue;
+
+        size_t offset = p - base[file];
+        size_t record_size = save_file_record_size((save_file) file);
+
+        /* Ranges that cross a record boundary are split per record. */
+        while (length) {
+            size_t record = offset / record_size;
+            size_t in_record = offset % record_size;
+            size_t n = std::min(length, record_size - in_record);
+
+            if (journal.empty() || journal.back().file != file || journal.back().record != record ||
+                journal.back().offset != in_record || journal.back().length != n) {
+                journal.push_back({(uint8_t) file, (uint16_t) record, (uint16_t) in_record, (uint16_t) n,
+                                   (uint32_t) pool.size()});
+                pool.insert(pool.end(), base[file] + offset, base[file] + offset + n);
+                pool.resize(pool.size() + n);
+            }
+
+            offset += n;
+            length -= n;
+        }
+
+        is_committed = false;
+        return;
+    }
+
+    throw std::invalid_argument("edit_journal: range is not part of the save");
+}
+
+void edit_journal::commit() {
+    for (const struct journal_entry &e : journal) {
+        const uint8_t *p = base[e.file] + e.record * save_file_record_size((save_file) e.file) + e.offset;
+        std::copy(p, p + e.length, pool.begin() + e.image + e.length);
+    }
+    is_committed = true;
+}
+
+void edit_journal::rollback() {
+    for (auto e = journal.rbegin(); e != journal.rend(); ++e) {
+        uint8_t *p = base[e->file] + e->record * save_file_record_size((save_file) e->file) + e->offset;
+        std::copy(pool.begin() + e->image, pool.begin() + e->image + e->length, p);
+    }
+    clear();
+}
+
+void edit_journal::clear() {
+    journal.clear();
+    pool.clear();
+    is_committed = false;
+}
+
+bool edit_journal::apply(struct gamea &game_data, struct gameb &club_data, struct gamec &player_data,
+                         bool forward) const {
+    uint8_t *target[NUM_SAVE_FILES] = {
+            reinterpret_cast<uint8_t *>(&game_data),
+            reinterpret_cast<uint8_t *>(&club_data),
+            reinterpret_cast<uint8_t *>(&player_data)
+    };
+
+    if (!is_committed)
+        return false;
+
+    /*
+     * Overlay the images that must already be in place: the first before image
+     * of every byte when replaying, the after images when undoing. Writing
+     * them in the opposite order to apply leaves the right one on top.
+     */
+    for (int file = 0; file < NUM_SAVE_FILES; ++file) {
+        std::vector<uint8_t> expected(target[file], target[file] + save_file_size[file]);
+        size_t record_size = save_file_record_size((save_file) file);
+
+        for (size_t i = 0; i < journal.size(); ++i) {
+            const struct journal_entry &e = forward ? journal[journal.size() - 1 - i] : journal[i];
+            if (e.file != file)
+                continue;
+            const uint8_t *image = pool.data() + e.image + (forward ? 0 : e.length);
+            std::copy(image, image + e.length, expected.begin() + e.record * record_size + e.offset);
+        }
+
+        if (memcmp(expected.data(), target[file], save_file_size[file]) != 0)
+            return false;
+    }
+
+    for (size_t i = 0; i < journal.size(); ++i) {
+        const struct journal_entry &e = forward ? journal[i] : journal[journal.size() - 1 - i];
+        const uint8_t *image = pool.data() + e.image + (forward ? e.length : 0);
+        uint8_t *p = target[e.file] + e.record * save_file_record_size((save_file) e.file) + e.offset;
+        std::copy(image, image + e.length, p);
+    }
+
+    return true;
+}
+
+bool edit_journal::replay(struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) const {
+    return apply(game_data, club_data, player_data, true);
+}
+
+bool edit_journal::undo(struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) const {
+    return apply(game_data, club_data, player_data, false);
+}
+
+void edit_journal::save(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open file for writing: " + path);
+    }
+
+    file.write(JOURNAL_MAGIC, 4);
+    put<uint16_t>(file, JOURNAL_VERSION);
+    put<uint32_t>(file, journal.size());
+    put<uint32_t>(file, pool.size());
+    for (const struct journal_entry &e : journal) {
+        put<uint8_t>(file, e.file);
+        put<uint16_t>(file, e.record);
+        put<uint16_t>(file, e.offset);
+        put<uint16_t>(file, e.length);
+        put<uint32_t>(file, e.image);
+    }
+    file.write(reinterpret_cast<const char *>(pool.data()), pool.size());
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Could not write journal: " + path);
+    }
+}
+
+void edit_journal::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open file for reading: " + path);
+    }
+
+    char magic[4];
+    file.read(magic, 4);
+    uint16_t version = get<uint16_t>(file);
+    uint32_t entries = get<uint32_t>(file);
+    uint32_t pool_size = get<uint32_t>(file);
+    if (!file || memcmp(magic, JOURNAL_MAGIC, 4) != 0 || version != JOURNAL_VERSION) {
+        throw std::runtime_error("Not a pm3 journal: " + path);
+    }
+
+    /* The counts come from the file, which has to hold that much before anything is allocated */
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec || size != JOURNAL_HEADER_SIZE + (uint64_t) entries * JOURNAL_ENTRY_SIZE + pool_size) {
+        throw std::runtime_error("Corrupt pm3 journal: " + path);
+    }
+
+    journal.resize(entries);
+    for (struct journal_entry &e : journal) {
+        e.file = get<uint8_t>(file);
+        e.record = get<uint16_t>(file);
+        e.offset = get<uint16_t>(file);
+        e.length = get<uint16_t>(file);
+        e.image = get<uint32_t>(file);
+    }
+    pool.resize(pool_size);
+    file.read(reinterpret_cast<char *>(pool.data()), pool_size);
+    if (!file) {
+        throw std::runtime_error("Truncated pm3 journal: " + path);
+    }
+
+    for (const struct journal_entry &e : journal) {
+        if (e.file >= NUM_SAVE_FILES ||
+            e.record * save_file_record_size((save_file) e.file) + e.offset + e.length > save_file_size[e.file] ||
+            (size_t) e.image + 2 * e.length > pool.size()) {
+            throw std::runtime_error("Corrupt pm3 journal: " + path);
+        }
+    }
+
+    is_committed = true;
+}
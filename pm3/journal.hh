@@ -0,0 +1,70 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+
+typedef enum {
+    SAVE_GAMEA,
+    SAVE_GAMEB,
+    SAVE_GAMEC,
+    NUM_SAVE_FILES
+} save_file;
+
+struct journal_entry {
+    uint8_t file;     // save_file
+    uint16_t record;  // club or player index, 0 for gamea
+    uint16_t offset;  // first byte within the record
+    uint16_t length;
+    uint32_t image;   // before image in the pool, the after image follows it
+};
+
+/*
+ * Edit transaction over a gamea/gameb/gamec triple.
+ *
+ * Call touch() on every byte range before it is modified. The journal keeps a
+ * before image of each range and, on commit(), the matching after image. An
+ * uncommitted transaction can be rolled back; a committed one can be saved,
+ * replayed onto another save or undone there.
+ */
+class edit_journal {
+public:
+    explicit edit_journal(struct gamea &game_data = gamea, struct gameb &club_data = gameb,
+                          struct gamec &player_data = gamec);
+
+    /* Pass the address and sizeof of the member: a reference to a packed field binds to a copy. */
+    void touch(const void *ptr, size_t length);
+
+    void commit();
+    void rollback();
+    void clear();
+
+    /*
+     * Write the after (replay) or before (undo) images into another triple.
+     * Every range must still hold the opposite image, otherwise nothing is
+     * changed and false is returned.
+     */
+    bool replay(struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) const;
+    bool undo(struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) const;
+
+    void save(const std::string &path) const;
+    void load(const std::string &path);
+
+    const std::vector<struct journal_entry> &entries() const { return journal; }
+    bool committed() const { return is_committed; }
+
+private:
+    uint8_t *base[NUM_SAVE_FILES];
+    std::vector<struct journal_entry> journal;
+    std::vector<uint8_t> pool;
+    bool is_committed = false;
+
+    bool apply(struct gamea &game_data, struct gameb &club_data, struct gamec &player_data, bool forward) const;
+};
+
+size_t save_file_record_size(save_file file);
+
+#endif
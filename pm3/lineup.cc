@@ -0,0 +1,156 @@
+#include "lineup.hh"
+
+#include <algorithm>
+#include <climits>
+
+#define SQUAD_SIZE 24
+/* Fitness of all eleven together must stay below one rating point */
+#define FITNESS_SCALE 2048
+#define WEIGHT_MAX (99 * FITNESS_SCALE + 127)
+
+bool parse_formation(const char *spec, struct formation &f) {
+    int d, m, a;
+    char end;
+
+    if (sscanf(spec, "%d-%d-%d%c", &d, &m, &a, &end) != 3 || d < 0 || m < 0 || a < 0 ||
+        d + m + a != LINEUP_STARTERS - 1)
+        return false;
+
+    snprintf(f.name, sizeof(f.name), "%d-%d-%d", d, m, a);
+    f.role[0] = 'G';
+    std::fill(f.role + 1, f.role + 1 + d, 'D');
+    std::fill(f.role + 1 + d, f.role + 1 + d + m, 'M');
+    std::fill(f.role + 1 + d + m, f.role + LINEUP_STARTERS, 'A');
+    return true;
+}
+
+bool player_available(const struct gamec::player &p) {
+    /* 18 and 19 are retiring at the end of the season, which does not stop anyone playing */
+    return p.period == 0 || p.period_type == 18 || p.period_type == 19;
+}
+
+int role_rating(const struct gamec::player &p, char role) {
+    switch (role) {
+        case 'G': return p.hn;
+        case 'D': return p.tk;
+        case 'M': return p.ps;
+        default:  return p.sh;
+    }
+}
+
+void pick_lineup(int club_idx, const struct formation &f, struct lineup &result,
+                 const struct gameb &club_data, const struct gamec &player_data) {
+    int16_t squad[SQUAD_SIZE];
+
+    memcpy(squad, club_data.club[club_idx].player_index, sizeof(squad));
+    pick_lineup(squad, SQUAD_SIZE, f, result, player_data);
+    result.club_idx = (int16_t) club_idx;
+}
+
+void pick_lineup(const int16_t *squad, int count, const struct formation &f, struct lineup &result,
+                 const struct gamec &player_data) {
+    int16_t candidate[LINEUP_POOL_MAX];
+    int m = 0;
+
+    for (int i = 0; i < count && m < LINEUP_POOL_MAX; ++i) {
+        int16_t idx = squad[i];
+        if (idx >= 0 && idx < 3932 && player_available(player_data.player[idx]))
+            candidate[m++] = idx;
+    }
+
+    /* Short squads get dummy players that fill a slot at a higher cost than anyone real */
+    int real = m;
+    m = std::max(m, LINEUP_STARTERS);
+
+    int cost[LINEUP_STARTERS + 1][LINEUP_POOL_MAX + 1];
+    for (int i = 1; i <= LINEUP_STARTERS; ++i) {
+        for (int j = 1; j <= m; ++j) {
+            if (j > real) {
+                cost[i][j] = WEIGHT_MAX + 1;
+            } else {
+                const struct gamec::player &p = player_data.player[candidate[j - 1]];
+                cost[i][j] = WEIGHT_MAX - (role_rating(p, f.role[i - 1]) * FITNESS_SCALE + std::min<int>(p.ft, 127));
+            }
+        }
+    }
+
+    /* Hungarian method with potentials, rows are formation slots and columns players */
+    int u[LINEUP_STARTERS + 1] = {}, v[LINEUP_POOL_MAX + 1] = {}, row_of[LINEUP_POOL_MAX + 1] = {};
+    int way[LINEUP_POOL_MAX + 1];
+    for (int i = 1; i <= LINEUP_STARTERS; ++i) {
+        int min_v[LINEUP_POOL_MAX + 1];
+        bool used[LINEUP_POOL_MAX + 1] = {};
+        int j0 = 0;
+
+        std::fill(min_v, min_v + m + 1, INT_MAX);
+        row_of[0] = i;
+        do {
+            int i0 = row_of[j0], delta = INT_MAX, j1 = 0;
+            used[j0] = true;
+
+            for (int j = 1; j <= m; ++j) {
+                if (used[j])
+                    continue;
+                int cur = cost[i0][j] - u[i0] - v[j];
+                if (cur < min_v[j]) {
+                    min_v[j] = cur;
+                    way[j] = j0;
+                }
+                if (min_v[j] < delta) {
+                    delta = min_v[j];
+                    j1 = j;
+                }
+            }
+
+            for (int j = 0; j <= m; ++j) {
+                if (used[j]) {
+                    u[row_of[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    min_v[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (row_of[j0] != 0);
+
+        do {
+            int j1 = way[j0];
+            row_of[j0] = row_of[j1];
+            j0 = j1;
+        } while (j0);
+    }
+
+    result.club_idx = -1;
+    result.strength = 0;
+    std::copy(f.role, f.role + LINEUP_STARTERS, result.role);
+    std::fill(result.starter, result.starter + LINEUP_STARTERS, -1);
+    std::fill(result.substitute, result.substitute + LINEUP_SUBSTITUTES, -1);
+
+    bool picked[LINEUP_POOL_MAX] = {};
+    for (int j = 1; j <= real; ++j) {
+        if (!row_of[j])
+            continue;
+        int slot = row_of[j] - 1;
+        result.starter[slot] = candidate[j - 1];
+        result.strength += role_rating(player_data.player[candidate[j - 1]], f.role[slot]);
+        picked[j - 1] = true;
+    }
+
+    for (int s = 0; s < LINEUP_SUBSTITUTES; ++s) {
+        int best = -1, best_rating = -1;
+        for (int j = 0; j < real; ++j) {
+            if (picked[j])
+                continue;
+            const struct gamec::player &p = player_data.player[candidate[j]];
+            int rating = std::max(std::max(p.hn, p.tk), std::max(p.ps, p.sh));
+            if (rating > best_rating) {
+                best = j;
+                best_rating = rating;
+            }
+        }
+        if (best == -1)
+            break;
+        picked[best] = true;
+        result.substitute[s] = candidate[best];
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef LINEUP_H
+#define LINEUP_H
+
+#include "pm3.hh"
+
+#define LINEUP_STARTERS 11
+#define LINEUP_SUBSTITUTES 3
+#define LINEUP_POOL_MAX 256
+
+/* One goalkeeper plus defenders, midfielders and attackers, e.g. 4-4-2 */
+struct formation {
+    char name[8];
+    char role[LINEUP_STARTERS];
+};
+
+struct lineup {
+    int16_t club_idx;
+    int16_t starter[LINEUP_STARTERS];  // -1 if the squad is short
+    char role[LINEUP_STARTERS];
+    int16_t substitute[LINEUP_SUBSTITUTES];
+    int strength;                      // sum of the starters' role ratings
+};
+
+bool parse_formation(const char *spec, struct formation &f);
+
+/* Injured, banned, on international duty or on loan */
+bool player_available(const struct gamec::player &p);
+
+/* hn, tk, ps or sh for G, D, M and A */
+int role_rating(const struct gamec::player &p, char role);
+
+/*
+ * Best starting eleven for the formation by an exact assignment of the
+ * available squad players to the formation slots (Hungarian method), with
+ * fitness breaking ties. The substitutes are the three best remaining
+ * players by their best role rating.
+ */
+void pick_lineup(int club_idx, const struct formation &f, struct lineup &result,
+                 const struct gameb &club_data = gameb, const struct gamec &player_data = gamec);
+
+/* The same for any set of at most LINEUP_POOL_MAX players, e.g. a squad with signings added */
+void pick_lineup(const int16_t *squad, int count, const struct formation &f, struct lineup &result,
+                 const struct gamec &player_data = gamec);
+
+#endif
@@ -0,0 +1,210 @@
+#include "match.hh"
+
+#include <string>
+
+#include "hash.hh"
+
+bool decode_match_summary(const struct gamea::manager::match_summary &ms, uint16_t year, uint16_t turn,
+                          struct match_record &record) {
+    /* An empty summary, before the first match, reads as club 0 against itself */
+    if (ms.club[0].club_idx >= CLUB_IDX_MAX || ms.club[1].club_idx >= CLUB_IDX_MAX ||
+        ms.club[0].club_idx == ms.club[1].club_idx)
+        return false;
+
+    record = {};
+    record.year = year;
+    record.turn = turn;
+    record.match_type = ms.match_type;
+    record.weather = ms.weather;
+    record.referee_idx = ms.referee_idx;
+    record.audience = ms.audience;
+
+    for (int i = 0; i < 2; ++i) {
+        const struct gamea::manager::match_summary::club &club = ms.club[i];
+        struct match_record::side &side = record.club[i];
+
+        side.club_idx = club.club_idx;
+        side.goals = club.total_goals;
+        side.first_half_goals = club.first_half_goals;
+        side.corners = club.corners;
+        side.throw_ins = club.throw_ins;
+        side.free_kicks = club.free_kicks;
+        side.penalties = club.penalties;
+
+        for (int j = 0; j < MATCH_LINEUP_MAX; ++j) {
+            const struct gamea::manager::match_summary::club::lineup &lineup = club.lineup[j];
+            if (lineup.player_idx < 0 || lineup.player_idx >= 3932)
+                continue;
+
+            struct match_record::line &line = record.lineup[record.lineup_count++];
+            line.player_idx = lineup.player_idx;
+            line.side = i;
+            line.slot = j;
+            line.card = lineup.card;
+            line.shots_attempted = lineup.shots_attempted;
+            line.shots_missed = lineup.shots_missed;
+            line.tackles_attempted = lineup.tackles_attempted;
+            line.tackles_won = lineup.tackles_won;
+            line.passes_attempted = lineup.passes_attempted;
+            line.passes_bad = lineup.passes_bad;
+            line.shots_saved = lineup.shots_saved;
+        }
+
+        for (int j = 0; j < MATCH_GOALS_MAX; ++j) {
+            const struct gamea::manager::match_summary::club::goal &goal = club.goal[j];
+            if (goal.player_idx < 0 || goal.player_idx >= 3932)
+                continue;
+
+            struct match_record::goal &g = record.goal[record.goal_count++];
+            g.player_idx = goal.player_idx;
+            g.side = i;
+            g.time = goal.time;
+        }
+    }
+
+    return record.lineup_count > 0;
+}
+
+int decode_match_summaries(const struct gamea &game_data, std::vector<match_record> &records) {
+    int decoded = 0;
+
+    for (int m = 0; m < 2; ++m) {
+        struct match_record record;
+        if (!decode_match_summary(game_data.manager[m].match_summary, game_data.year, game_data.turn, record))
+            continue;
+
+        records.push_back(record);
+        ++decoded;
+    }
+
+    return decoded;
+}
+
+match_stats::match_stats() {
+    player.appearances.resize(3932);
+    player.goals.resize(3932);
+    player.cards.resize(3932);
+    player.shots_attempted.resize(3932);
+    player.shots_missed.resize(3932);
+    player.tackles_attempted.resize(3932);
+    player.tackles_won.resize(3932);
+    player.passes_attempted.resize(3932);
+    player.passes_bad.resize(3932);
+    player.shots_saved.resize(3932);
+
+    club.played.resize(CLUB_IDX_MAX);
+    club.won.resize(CLUB_IDX_MAX);
+    club.drawn.resize(CLUB_IDX_MAX);
+    club.lost.resize(CLUB_IDX_MAX);
+    club.goals_for.resize(CLUB_IDX_MAX);
+    club.goals_against.resize(CLUB_IDX_MAX);
+    club.shots_attempted.resize(CLUB_IDX_MAX);
+    club.tackles_attempted.resize(CLUB_IDX_MAX);
+    club.tackles_won.resize(CLUB_IDX_MAX);
+    club.passes_attempted.resize(CLUB_IDX_MAX);
+    club.passes_bad.resize(CLUB_IDX_MAX);
+    club.audience.resize(CLUB_IDX_MAX);
+}
+
+/*
+ * Hash of what happened in the match, leaving out the date of the save it was
+ * read from: the summary of the last match stays in every save up to the next.
+ */
+static uint64_t match_key(const struct match_record &record) {
+    std::string bytes;
+    auto put = [&bytes](const auto &value) { bytes.append(reinterpret_cast<const char *>(&value), sizeof(value)); };
+
+    put(record.match_type);
+    put(record.weather);
+    put(record.referee_idx);
+    put(record.audience);
+    for (const struct match_record::side &side : record.club) {
+        put(side.club_idx);
+        put(side.goals);
+        put(side.first_half_goals);
+        put(side.corners);
+        put(side.throw_ins);
+        put(side.free_kicks);
+        put(side.penalties);
+    }
+    for (int i = 0; i < record.lineup_count; ++i) {
+        const struct match_record::line &line = record.lineup[i];
+        put(line.player_idx);
+        put(line.side);
+        put(line.slot);
+        put(line.card);
+        put(line.shots_attempted);
+        put(line.shots_missed);
+        put(line.tackles_attempted);
+        put(line.tackles_won);
+        put(line.passes_attempted);
+        put(line.passes_bad);
+        put(line.shots_saved);
+    }
+    for (int i = 0; i < record.goal_count; ++i) {
+        put(record.goal[i].player_idx);
+        put(record.goal[i].side);
+        put(record.goal[i].time);
+    }
+
+    return hash64(bytes.data(), bytes.size());
+}
+
+bool match_stats::add(const struct match_record &record) {
+    if (!seen.insert(match_key(record)).second)
+        return false;
+
+    for (int i = 0; i < 2; ++i) {
+        int c = record.club[i].club_idx;
+        int goals_for = record.club[i].goals;
+        int goals_against = record.club[1 - i].goals;
+
+        club.played[c]++;
+        club.won[c] += goals_for > goals_against;
+        club.drawn[c] += goals_for == goals_against;
+        club.lost[c] += goals_for < goals_against;
+        club.goals_for[c] += goals_for;
+        club.goals_against[c] += goals_against;
+        club.audience[c] += record.audience;
+    }
+
+    for (int i = 0; i < record.lineup_count; ++i) {
+        const struct match_record::line &line = record.lineup[i];
+        int p = line.player_idx;
+        int c = record.club[line.side].club_idx;
+
+        /* The last three lineup slots are the substitutes' bench. */
+        if (line.slot < 11 || line.shots_attempted || line.tackles_attempted || line.passes_attempted)
+            player.appearances[p]++;
+        player.cards[p] += line.card != 0;
+        player.shots_attempted[p] += line.shots_attempted;
+        player.shots_missed[p] += line.shots_missed;
+        player.tackles_attempted[p] += line.tackles_attempted;
+        player.tackles_won[p] += line.tackles_won;
+        player.passes_attempted[p] += line.passes_attempted;
+        player.passes_bad[p] += line.passes_bad;
+        player.shots_saved[p] += line.shots_saved;
+
+        club.shots_attempted[c] += line.shots_attempted;
+        club.tackles_attempted[c] += line.tackles_attempted;
+        club.tackles_won[c] += line.tackles_won;
+        club.passes_attempted[c] += line.passes_attempted;
+        club.passes_bad[c] += line.passes_bad;
+    }
+
+    for (int i = 0; i < record.goal_count; ++i)
+        player.goals[record.goal[i].player_idx]++;
+
+    return true;
+}
+
+int match_stats::add(const struct gamea &game_data) {
+    std::vector<match_record> records;
+    int added = 0;
+
+    decode_match_summaries(game_data, records);
+    for (const struct match_record &record : records)
+        added += add(record);
+
+    return added;
+}
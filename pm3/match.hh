@@ -0,0 +1,106 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "pm3.hh"
+
+#define MATCH_LINEUP_MAX 14
+#define MATCH_GOALS_MAX 8
+
+/* Compact, typed copy of a gamea::manager::match_summary. */
+struct match_record {
+    uint16_t year;
+    uint16_t turn;
+    uint8_t match_type;
+    uint16_t weather;
+    uint8_t referee_idx;
+    uint32_t audience;
+
+    struct side {
+        int16_t club_idx;
+        uint8_t goals;
+        uint8_t first_half_goals;
+        uint8_t corners;
+        uint8_t throw_ins;
+        uint8_t free_kicks;
+        uint8_t penalties;
+    } club[2]; // home + away club
+
+    struct line {
+        int16_t player_idx;
+        uint8_t side;
+        uint8_t slot;
+        uint8_t card;
+        uint8_t shots_attempted;
+        uint8_t shots_missed;
+        uint8_t tackles_attempted;
+        uint8_t tackles_won;
+        uint8_t passes_attempted;
+        uint8_t passes_bad;
+        uint8_t shots_saved;
+    } lineup[2 * MATCH_LINEUP_MAX];
+    uint8_t lineup_count;
+
+    struct goal {
+        int16_t player_idx;
+        uint8_t side;
+        uint16_t time; // seconds
+    } goal[2 * MATCH_GOALS_MAX];
+    uint8_t goal_count;
+};
+
+bool decode_match_summary(const struct gamea::manager::match_summary &ms, uint16_t year, uint16_t turn,
+                          struct match_record &record);
+int decode_match_summaries(const struct gamea &game_data, std::vector<match_record> &records);
+
+/*
+ * Per-player and per-club totals over any number of decoded matches, stored
+ * column by column (one vector per statistic, indexed by player or club).
+ * The same match seen in several saves is only counted once, whatever the
+ * date of the saves: matches are told apart by their clubs, score, audience
+ * and lineups.
+ */
+class match_stats {
+public:
+    struct player_columns {
+        std::vector<uint16_t> appearances;
+        std::vector<uint16_t> goals;
+        std::vector<uint16_t> cards;
+        std::vector<uint32_t> shots_attempted;
+        std::vector<uint32_t> shots_missed;
+        std::vector<uint32_t> tackles_attempted;
+        std::vector<uint32_t> tackles_won;
+        std::vector<uint32_t> passes_attempted;
+        std::vector<uint32_t> passes_bad;
+        std::vector<uint32_t> shots_saved;
+    } player;
+
+    struct club_columns {
+        std::vector<uint16_t> played;
+        std::vector<uint16_t> won;
+        std::vector<uint16_t> drawn;
+        std::vector<uint16_t> lost;
+        std::vector<uint32_t> goals_for;
+        std::vector<uint32_t> goals_against;
+        std::vector<uint32_t> shots_attempted;
+        std::vector<uint32_t> tackles_attempted;
+        std::vector<uint32_t> tackles_won;
+        std::vector<uint32_t> passes_attempted;
+        std::vector<uint32_t> passes_bad;
+        std::vector<uint64_t> audience;
+    } club;
+
+    match_stats();
+
+    bool add(const struct match_record &record);
+    int add(const struct gamea &game_data);
+    size_t matches() const { return seen.size(); }
+
+private:
+    std::set<uint64_t> seen;
+};
+
+#endif
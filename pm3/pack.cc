@@ -0,0 +1,305 @@
+#include "pack.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.hh"
+#include "sidecar.hh"
+
+namespace {
+
+struct pack_header {
+    char magic[4];
+    uint16_t version;
+    uint16_t files;                     // NUM_SAVE_FILES
+    uint64_t count;
+    uint64_t length;                    // of the whole file
+    uint64_t checksum;                  // XXH64 of the entries and strings
+    uint64_t strings_length;
+    uint64_t record_size[NUM_SAVE_FILES];
+    uint64_t section[NUM_SAVE_FILES];   // PACK_PAGE aligned
+};
+
+const size_t record_size[NUM_SAVE_FILES] = {
+        sizeof(struct gamea),
+        sizeof(struct gameb),
+        sizeof(struct gamec),
+};
+
+uint64_t page_align(uint64_t offset) {
+    return (offset + PACK_PAGE - 1) / PACK_PAGE * PACK_PAGE;
+}
+
+void write_at(int fd, const void *data, size_t length, uint64_t offset, const std::string &path) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    while (length > 0) {
+        ssize_t written = pwrite(fd, bytes, length, (off_t) offset);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            throw std::runtime_error("Could not write " + path + ": " + strerror(errno));
+        bytes += written;
+        length -= written;
+        offset += written;
+    }
+}
+
+/* What the load menu of the game shows, false if SAVES.DIR cannot be read */
+bool read_saves_dir(const std::string &game_path, struct saves &saves_dir_data) {
+    std::filesystem::path path = construct_saves_folder_path(game_path) / SAVES_DIR_FILE;
+    std::error_code ec;
+    if (std::filesystem::file_size(path, ec) != sizeof(struct saves) || ec)
+        return false;
+
+    std::ifstream file(path, std::ios::binary);
+    return (bool) file.read(reinterpret_cast<char *>(&saves_dir_data), sizeof(struct saves));
+}
+
+}
+
+size_t write_pack(const std::string &path, const std::vector<struct fleet_save> &saves) {
+    std::vector<struct pack_entry> entries(saves.size());
+    std::string strings;
+    std::map<std::string, uint32_t> path_offsets;
+    std::map<std::string, std::unique_ptr<struct saves>> saves_dirs;   // null if unreadable
+
+    for (size_t i = 0; i < saves.size(); ++i) {
+        const std::string &game_path = saves[i].game_path;
+        if (path_offsets.emplace(game_path, (uint32_t) strings.size()).second) {
+            strings += game_path;
+            strings += '\0';
+        }
+        entries[i].path = path_offsets[game_path];
+        entries[i].game_nr = (uint16_t) saves[i].game_nr;
+    }
+
+    struct pack_header header{};
+    memcpy(header.magic, PACK_MAGIC, 4);
+    header.version = PACK_VERSION;
+    header.files = NUM_SAVE_FILES;
+    header.count = saves.size();
+    header.strings_length = strings.size();
+
+    uint64_t offset = sizeof(header) + entries.size() * sizeof(struct pack_entry) + strings.size();
+    for (int f = 0; f < NUM_SAVE_FILES; ++f) {
+        header.record_size[f] = record_size[f];
+        header.section[f] = page_align(offset);
+        offset = header.section[f] + saves.size() * record_size[f];
+    }
+    header.length = page_align(offset);
+
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Could not create " + temporary + ": " + strerror(errno));
+
+    try {
+        if (ftruncate(fd, (off_t) header.length) != 0)
+            throw std::runtime_error("Could not size " + temporary + ": " + strerror(errno));
+
+        std::unique_ptr<struct gamea> game_data = std::make_unique<struct gamea>();
+        std::unique_ptr<struct gameb> club_data = std::make_unique<struct gameb>();
+        std::unique_ptr<struct gamec> player_data = std::make_unique<struct gamec>();
+
+        for (size_t i = 0; i < saves.size(); ++i) {
+            const struct fleet_save &save = saves[i];
+            std::string error;
+            if (!load_save_spec(save.spec, *game_data, *club_data, *player_data, error))
+                throw std::runtime_error(error);
+
+            /* SAVES.DIR once per install; the save itself stands in if it is missing */
+            auto dir = saves_dirs.find(save.game_path);
+            if (dir == saves_dirs.end()) {
+                std::unique_ptr<struct saves> saves_dir_data = std::make_unique<struct saves>();
+                if (!read_saves_dir(save.game_path, *saves_dir_data))
+                    saves_dir_data.reset();
+                dir = saves_dirs.emplace(save.game_path, std::move(saves_dir_data)).first;
+            }
+            struct saves fallback{};
+            if (!dir->second)
+                update_metadata(save.game_nr, *game_data, fallback);
+
+            struct pack_entry &e = entries[i];
+            const struct saves::game &meta = (dir->second ? *dir->second : fallback).game[save.game_nr - 1];
+            e.year = meta.year;
+            e.turn = meta.turn;
+            for (int m = 0; m < 2; ++m) {
+                e.manager_club_idx[m] = meta.manager[m].club_idx;
+                memcpy(e.manager[m], meta.manager[m].name, sizeof(e.manager[m]));
+            }
+
+            struct sidecar_key key = save.key;
+            hash_save_files(key, *game_data, *club_data, *player_data);
+            memcpy(e.hash, key.hash, sizeof(e.hash));
+
+            const void *record[NUM_SAVE_FILES] = {game_data.get(), club_data.get(), player_data.get()};
+            for (int f = 0; f < NUM_SAVE_FILES; ++f)
+                write_at(fd, record[f], record_size[f], header.section[f] + i * record_size[f], temporary);
+        }
+
+        std::string table(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(struct pack_entry));
+        table += strings;
+        header.checksum = hash64(table.data(), table.size());
+        write_at(fd, &header, sizeof(header), 0, temporary);
+        write_at(fd, table.data(), table.size(), sizeof(header), temporary);
+
+        if (close(fd) != 0) {
+            fd = -1;
+            throw std::runtime_error("Could not write " + temporary + ": " + strerror(errno));
+        }
+    } catch (...) {
+        if (fd >= 0)
+            close(fd);
+        unlink(temporary.c_str());
+        throw;
+    }
+
+    std::filesystem::rename(temporary, path);
+    return saves.size();
+}
+
+save_pack::~save_pack() {
+    unmap();
+}
+
+void save_pack::unmap() {
+    if (mapping)
+        munmap(const_cast<uint8_t *>(mapping), mapping_size);
+    mapping = nullptr;
+    mapping_size = 0;
+    count = 0;
+}
+
+bool save_pack::map(const std::filesystem::path &path, std::string &error) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "Could not open " + path.string();
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(struct pack_header)) {
+        close(fd);
+        error = path.string() + " is not a pack";
+        return false;
+    }
+
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        error = "Could not map " + path.string();
+        return false;
+    }
+
+    unmap();
+    mapping = static_cast<const uint8_t *>(p);
+    mapping_size = st.st_size;
+
+    struct pack_header header;
+    memcpy(&header, mapping, sizeof(header));
+    error.clear();
+    if (memcmp(header.magic, PACK_MAGIC, 4) != 0)
+        error = path.string() + " is not a pack";
+    else if (header.version != PACK_VERSION || header.files != NUM_SAVE_FILES)
+        error = path.string() + " is a pack of version " + std::to_string(header.version);
+    else if (header.length != mapping_size)
+        error = path.string() + " is truncated";
+    if (!error.empty()) {
+        unmap();
+        return false;
+    }
+
+    size_t table = sizeof(header) + header.count * sizeof(struct pack_entry) + header.strings_length;
+    bool valid = header.count <= mapping_size / sizeof(struct pack_entry) &&
+                 header.strings_length <= mapping_size && table <= mapping_size &&
+                 (header.strings_length == 0 || mapping[table - 1] == '\0');
+    for (int f = 0; valid && f < NUM_SAVE_FILES; ++f) {
+        valid = header.record_size[f] == record_size[f] && header.section[f] % PACK_PAGE == 0 &&
+                header.section[f] >= table && header.section[f] <= mapping_size &&
+                header.count <= (mapping_size - header.section[f]) / record_size[f];
+    }
+    if (!valid || header.checksum != hash64(mapping + sizeof(header), table - sizeof(header))) {
+        unmap();
+        error = path.string() + " is corrupt";
+        return false;
+    }
+
+    count = header.count;
+    entries = reinterpret_cast<const struct pack_entry *>(mapping + sizeof(header));
+    strings = reinterpret_cast<const char *>(mapping + table - header.strings_length);
+    strings_length = header.strings_length;
+    for (int f = 0; f < NUM_SAVE_FILES; ++f)
+        section[f] = mapping + header.section[f];
+
+    for (size_t i = 0; i < count; ++i) {
+        if (entries[i].path >= strings_length || entries[i].game_nr < 1 || entries[i].game_nr > 8) {
+            unmap();
+            error = path.string() + " is corrupt";
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string save_pack::game_path(size_t i) const {
+    return strings + entries[i].path;
+}
+
+std::string save_pack::spec(size_t i) const {
+    return game_path(i) + ":" + std::to_string(entries[i].game_nr);
+}
+
+const struct gamea &save_pack::game(size_t i) const {
+    return *reinterpret_cast<const struct gamea *>(section[SAVE_GAMEA] + i * record_size[SAVE_GAMEA]);
+}
+
+const struct gameb &save_pack::clubs(size_t i) const {
+    return *reinterpret_cast<const struct gameb *>(section[SAVE_GAMEB] + i * record_size[SAVE_GAMEB]);
+}
+
+const struct gamec &save_pack::players(size_t i) const {
+    return *reinterpret_cast<const struct gamec *>(section[SAVE_GAMEC] + i * record_size[SAVE_GAMEC]);
+}
+
+void save_pack::prefetch(size_t first, size_t n, unsigned files) const {
+    static const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    if (first >= count)
+        return;
+    n = std::min(n, count - first);
+
+    for (int f = 0; f < NUM_SAVE_FILES; ++f) {
+        if (!(files & (1u << f)))
+            continue;
+        size_t begin = (section[f] - mapping) + first * record_size[f];
+        size_t end = begin + n * record_size[f];
+        begin -= begin % page;
+        madvise(const_cast<uint8_t *>(mapping) + begin, end - begin, MADV_WILLNEED);
+    }
+}
+
+void save_pack::scan(const std::function<void(size_t)> &visit, unsigned files) const {
+    size_t largest = 1;
+    for (int f = 0; f < NUM_SAVE_FILES; ++f) {
+        if (files & (1u << f))
+            largest = std::max(largest, record_size[f]);
+    }
+    size_t window = std::max<size_t>(1, PACK_PREFETCH_BYTES / largest);
+
+    /* The window being visited and the one after it are always asked for */
+    for (size_t i = 0; i < count; ++i) {
+        if (i % window == 0)
+            prefetch(i == 0 ? 0 : i + window, i == 0 ? 2 * window : window, files);
+        visit(i);
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef PACK_H
+#define PACK_H
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+#include "fleet.hh"
+#include "journal.hh"
+
+#define PACK_MAGIC "PM3P"
+#define PACK_VERSION 1
+#define PACK_PAGE 4096
+
+/* Bytes of a section asked for ahead of a scan */
+#define PACK_PREFETCH_BYTES (4 << 20)
+
+#define PACK_ALL_FILES ((1u << NUM_SAVE_FILES) - 1)
+
+/* A savegame of the pack, with what SAVES.DIR says about it */
+struct pack_entry {
+    uint32_t path;                  // of the install, into the strings
+    uint16_t game_nr;
+    uint16_t year;
+    uint16_t turn;
+    uint8_t manager_club_idx[2];
+    char manager[2][16];
+    uint32_t reserved;
+    uint64_t hash[NUM_SAVE_FILES];  // XXH64 of each file, as in sidecar_key
+};
+
+static_assert(sizeof(struct pack_entry) == 72, "pack_entry layout");
+
+/*
+ * Write the savegames into one corpus file at path, which is written aside
+ * and renamed into place. Throws std::runtime_error if a save cannot be read
+ * or the file cannot be written; returns the number of saves.
+ *
+ * The file is a header, a table of pack_entry and the strings they refer to,
+ * then three sections at PACK_PAGE boundaries: every gamea one after another,
+ * then every gameb, then every gamec, each a fixed size. Reading all players
+ * of every save is a single sequential read of the last section.
+ */
+size_t write_pack(const std::string &path, const std::vector<struct fleet_save> &saves);
+
+/*
+ * A corpus file mapped read-only. Records are used in place; the structs are
+ * packed, so any byte offset will do.
+ */
+class save_pack {
+public:
+    save_pack() = default;
+    ~save_pack();
+
+    save_pack(const save_pack &) = delete;
+    save_pack &operator=(const save_pack &) = delete;
+
+    /* False with the reason in error if the file is missing, of another version or corrupt */
+    bool map(const std::filesystem::path &path, std::string &error);
+
+    size_t size() const { return count; }
+    const struct pack_entry &entry(size_t i) const { return entries[i]; }
+    std::string game_path(size_t i) const;
+    std::string spec(size_t i) const;
+
+    const struct gamea &game(size_t i) const;
+    const struct gameb &clubs(size_t i) const;
+    const struct gamec &players(size_t i) const;
+
+    /* Ask the kernel to read the records of saves first to first + n of the files in the mask */
+    void prefetch(size_t first, size_t n, unsigned files = PACK_ALL_FILES) const;
+
+    /*
+     * Visit every save in order, keeping PACK_PREFETCH_BYTES of each section
+     * in the mask read ahead. Only the sections in the mask are touched.
+     */
+    void scan(const std::function<void(size_t)> &visit, unsigned files = PACK_ALL_FILES) const;
+
+private:
+    const uint8_t *mapping = nullptr;
+    size_t mapping_size = 0;
+
+    size_t count = 0;
+    const struct pack_entry *entries = nullptr;
+    const char *strings = nullptr;
+    size_t strings_length = 0;
+    const uint8_t *section[NUM_SAVE_FILES] = {};
+
+    void unmap();
+};
+
+#endif
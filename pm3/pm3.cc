@@ -1,4 +1,7 @@
 #include "pm3.hh"
+#include "journal.hh"
+#include "schema.hh"
+#include "transform.hh"
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -87,9 +90,20 @@ uint8_t determine_player_rating(struct gamec::player &p) {
     return p.sh;
 }
 
-void change_club(int16_t new_club_idx, const char* game_path, int player) {
-	struct gamea::manager &manager = gamea.manager[player];
+void change_club(int16_t new_club_idx, const char* game_path, int player, edit_journal *journal, struct gamea &game_data, struct gameb &club_data) {
+	struct gamea::manager &manager = game_data.manager[player];
 	int old_club_idx = manager.club_idx;
+
+	if (journal && new_club_idx >= 0 && new_club_idx <= 113) {
+		journal->touch(&manager.club_idx, sizeof(manager.club_idx));
+		journal->touch(&manager.division, sizeof(manager.division));
+		journal->touch(&manager.stadium, sizeof(manager.stadium));
+		journal->touch(&manager.price, sizeof(manager.price));
+		journal->touch(&club_data.club[new_club_idx].player_image, sizeof(club_data.club[new_club_idx].player_image));
+		journal->touch(&club_data.club[new_club_idx].manager, sizeof(club_data.club[new_club_idx].manager));
+		journal->touch(&club_data.club[old_club_idx].manager, sizeof(club_data.club[old_club_idx].manager));
+	}
+
 	manager.club_idx = new_club_idx;
 
 	switch (manager.club_idx) {
@@ -238,12 +252,12 @@ void change_club(int16_t new_club_idx, const char* game_path, int player) {
 			exit(EXIT_FAILURE);
 	}
 
-    gameb.club[new_club_idx].player_image = gameb.club[old_club_idx].player_image;
-	strncpy(gameb.club[new_club_idx].manager, gameb.club[old_club_idx].manager, 16);
+    club_data.club[new_club_idx].player_image = club_data.club[old_club_idx].player_image;
+	strncpy(club_data.club[new_club_idx].manager, club_data.club[old_club_idx].manager, 16);
 
     struct gameb default_club_data{};
     load_default_clubdata(game_path, default_club_data);
-	strncpy(gameb.club[old_club_idx].manager, default_club_data.club[old_club_idx].manager, 16);
+	strncpy(club_data.club[old_club_idx].manager, default_club_data.club[old_club_idx].manager, 16);
 }
 
 std::vector<club_player> find_free_players() {
@@ -282,11 +296,16 @@ std::vector<club_player> get_my_players(int player) {
     return my_players;
 }
 
-void level_aggression() {
-    for (int16_t i = 0; i < 3932; ++i) {
-        struct gamec::player &player = get_player(i);
-        player.aggr = 5;
-    }
+void level_aggression(edit_journal *journal) {
+    std::vector<struct player_transform> level = {
+            { find_field<struct gamec::player>("aggr"), TRANSFORM_SET, 5, 0 }
+    };
+    std::vector<int16_t> players(3932);
+
+    for (int16_t i = 0; i < 3932; ++i)
+        players[i] = i;
+
+    transform_players(players, level, journal);
 }
 
 template <typename T>
@@ -345,13 +364,96 @@ void save_metadata(const std::string &game_path, struct saves &saves_dir_data, s
     save_binary_file(full_path / PREFS_FILE, prefs_data);
 }
 
-void update_metadata(int game_nr) {
-    saves.game[game_nr - 1].year = gamea.year;
-    saves.game[game_nr - 1].turn = gamea.turn;
-    strcpy(saves.game[game_nr - 1].manager[0].name, gamea.manager[0].name);
-    strcpy(saves.game[game_nr - 1].manager[1].name, gamea.manager[1].name);
-    saves.game[game_nr - 1].manager[0].club_idx = gamea.manager[0].club_idx;
-    saves.game[game_nr - 1].manager[1].club_idx = gamea.manager[1].club_idx;
+void update_metadata(int game_nr, struct gamea &game_data, struct saves &saves_dir_data) {
+    saves_dir_data.game[game_nr - 1].year = game_data.year;
+    saves_dir_data.game[game_nr - 1].turn = game_data.turn;
+    strcpy(saves_dir_data.game[game_nr - 1].manager[0].name, game_data.manager[0].name);
+    strcpy(saves_dir_data.game[game_nr - 1].manager[1].name, game_data.manager[1].name);
+    saves_dir_data.game[game_nr - 1].manager[0].club_idx = game_data.manager[0].club_idx;
+    saves_dir_data.game[game_nr - 1].manager[1].club_idx = game_data.manager[1].club_idx;
+}
+
+template <typename T>
+static bool read_save_file(const std::string &path, T &data, std::string &error) {
+    std::error_code ec;
+    if (std::filesystem::file_size(path, ec) != sizeof(T) || ec) {
+        error = "Not a savegame file of " + std::to_string(sizeof(T)) + " bytes: " + path;
+        return false;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(reinterpret_cast<char *>(&data), sizeof(T))) {
+        error = "Could not read " + path;
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+static bool write_save_file(const std::string &path, const T &data, std::string &error) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(reinterpret_cast<const char *>(&data), sizeof(T))) {
+        error = "Could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+/* Splits PATH:N; false if the spec is a file prefix instead */
+static bool parse_save_spec(const std::string &spec, std::string &game_path, int &game_nr) {
+    size_t colon = spec.rfind(':');
+    if (colon == std::string::npos || colon + 2 != spec.size() || spec[colon + 1] < '1' || spec[colon + 1] > '8')
+        return false;
+
+    game_path = spec.substr(0, colon);
+    game_nr = spec[colon + 1] - '0';
+    return true;
+}
+
+bool load_save_spec(const std::string &spec, struct gamea &game_data, struct gameb &club_data, struct gamec &player_data, std::string &error) {
+    std::string game_path;
+    int game_nr;
+
+    if (!parse_save_spec(spec, game_path, game_nr)) {
+        return read_save_file(spec + "A", game_data, error) &&
+               read_save_file(spec + "B", club_data, error) &&
+               read_save_file(spec + "C", player_data, error);
+    }
+
+    if (get_pm3_game_type(game_path.c_str()) == PM3_UNKNOWN) {
+        error = "Did not find " EXE_STANDARD_FILENAME " or " EXE_DELUXE_FILENAME " in " + game_path;
+        return false;
+    }
+    return read_save_file(construct_save_file_path(game_path, game_nr, 'A'), game_data, error) &&
+           read_save_file(construct_save_file_path(game_path, game_nr, 'B'), club_data, error) &&
+           read_save_file(construct_save_file_path(game_path, game_nr, 'C'), player_data, error);
+}
+
+bool save_save_spec(const std::string &spec, struct gamea &game_data, struct gameb &club_data, struct gamec &player_data, std::string &error) {
+    std::string game_path;
+    int game_nr;
+
+    if (!parse_save_spec(spec, game_path, game_nr)) {
+        return write_save_file(spec + "A", game_data, error) &&
+               write_save_file(spec + "B", club_data, error) &&
+               write_save_file(spec + "C", player_data, error);
+    }
+
+    if (get_pm3_game_type(game_path.c_str()) == PM3_UNKNOWN) {
+        error = "Did not find " EXE_STANDARD_FILENAME " or " EXE_DELUXE_FILENAME " in " + game_path;
+        return false;
+    }
+    if (!write_save_file(construct_save_file_path(game_path, game_nr, 'A'), game_data, error) ||
+        !write_save_file(construct_save_file_path(game_path, game_nr, 'B'), club_data, error) ||
+        !write_save_file(construct_save_file_path(game_path, game_nr, 'C'), player_data, error))
+        return false;
+
+    struct saves saves_dir_data{};
+    std::filesystem::path folder = construct_saves_folder_path(game_path);
+    if (!read_save_file(folder / SAVES_DIR_FILE, saves_dir_data, error))
+        return false;
+    update_metadata(game_nr, game_data, saves_dir_data);
+    return write_save_file(folder / SAVES_DIR_FILE, saves_dir_data, error);
 }
 
 std::filesystem::path construct_saves_folder_path(const std::string &game_path) {
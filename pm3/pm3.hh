@@ -46,6 +46,9 @@ static const char *division[] = {
         "Conference League"
 };
 
+/* First row of each division in gamea.club_index and gamea.table, and the end of the last one */
+static const int division_offset[] = { 0, 22, 46, 70, 92, 114 };
+
 static const int division_hex[] = {
     0x4E,
     0x42,
@@ -757,8 +760,10 @@ uint8_t determine_player_rating(struct gamec::player &player);
 std::vector<club_player> find_free_players();
 std::vector<club_player> get_my_players(int player);
 
-void change_club(int16_t new_club_idx, const char* game_path, int player=0);
-void level_aggression();
+class edit_journal;
+
+void change_club(int16_t new_club_idx, const char* game_path, int player=0, edit_journal *journal=nullptr, struct gamea &game_data=gamea, struct gameb &club_data=gameb);
+void level_aggression(edit_journal *journal=nullptr);
 
 void check_consistency(void);
 
@@ -769,7 +774,16 @@ void load_default_playdata(const std::string &game_path, struct gamec &player_da
 void load_metadata(const std::string &game_path, struct saves &saves_dir_data=saves, struct prefs &prefs_data=prefs);
 void save_binaries(int game_nr, const std::string &game_path, struct gamea &game_data=gamea, struct gameb &club_data=gameb, struct gamec &player_data=gamec);
 void save_metadata(const std::string &game_path, struct saves &saves_dir_data=saves, struct prefs &prefs_data=prefs);
-void update_metadata(int game_nr);
+void update_metadata(int game_nr, struct gamea &game_data=gamea, struct saves &saves_dir_data=saves);
+
+/*
+ * A savegame named either PATH:N (savegame N of the install at PATH) or by
+ * the prefix of its files, e.g. PATH/SAVES/GAME1 for GAME1A, GAME1B and
+ * GAME1C. Saving to PATH:N also updates SAVES.DIR. Both return false and set
+ * error if the files cannot be read or written.
+ */
+bool load_save_spec(const std::string &spec, struct gamea &game_data, struct gameb &club_data, struct gamec &player_data, std::string &error);
+bool save_save_spec(const std::string &spec, struct gamea &game_data, struct gameb &club_data, struct gamec &player_data, std::string &error);
 
 std::filesystem::path construct_saves_folder_path(const std::string& game_path);
 std::filesystem::path construct_save_file_path(const std::string& game_path, int gameNumber, char gameLetter);
@@ -0,0 +1,57 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cmath>
+#include <cstdint>
+
+/*
+ * xoshiro256** seeded through splitmix64. Small and fast enough to give every
+ * simulation thread its own stream: seed with (seed, thread number).
+ */
+struct rng {
+    uint64_t s[4];
+
+    explicit rng(uint64_t seed, uint64_t stream = 0) {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ull);
+        for (uint64_t &word : s) {
+            x += 0x9E3779B97F4A7C15ull;
+            uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+
+        return result;
+    }
+
+    /* Uniform in [0, 1) */
+    double uniform() { return (next() >> 11) * 0x1.0p-53; }
+
+    /* Poisson variate by multiplication, limit = exp(-mean); fine for the few goals of a match */
+    int poisson(double limit) {
+        int k = 0;
+        double p = uniform();
+        while (p > limit) {
+            ++k;
+            p *= uniform();
+        }
+        return k;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+#endif
@@ -0,0 +1,36 @@
+#include "save_hash.hh"
+
+#include "hash.hh"
+#include "snapshot.hh"
+
+void save_hashes::compute(const struct gamea &game_data, const struct gameb &club_data,
+                          const struct gamec &player_data) {
+    const std::vector<struct snapshot_record> &layout = snapshot_layout();
+    const uint8_t *game = reinterpret_cast<const uint8_t *>(&game_data);
+
+    record.resize(layout.size());
+    gamea_records = 0;
+    while (gamea_records < layout.size() && layout[gamea_records].file == SAVE_GAMEA) {
+        const struct snapshot_record &r = layout[gamea_records];
+        record[gamea_records] = hash64(game + r.offset, r.length);
+        ++gamea_records;
+    }
+
+    hash64_records(club_data.club, sizeof(struct gameb::club), sizeof(struct gameb::club), CLUB_IDX_MAX,
+                   record.data() + gamea_records);
+    hash64_records(player_data.player, sizeof(struct gamec::player), sizeof(struct gamec::player), 3932,
+                   record.data() + gamea_records + CLUB_IDX_MAX);
+}
+
+uint64_t save_hashes::save() const {
+    return hash64(record.data(), record.size() * sizeof(uint64_t));
+}
+
+std::vector<size_t> save_hashes::changed(const struct save_hashes &other) const {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < record.size(); ++i) {
+        if (i >= other.record.size() || record[i] != other.record[i])
+            result.push_back(i);
+    }
+    return result;
+}
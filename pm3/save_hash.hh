@@ -0,0 +1,33 @@
+#ifndef SAVE_HASH_H
+#define SAVE_HASH_H
+
+#include <cstdint>
+#include <vector>
+
+#include "pm3.hh"
+
+/*
+ * XXH64 of every natural record of a savegame, in the order of
+ * snapshot_layout(): the top level members of gamea with each manager on its
+ * own, then every club, then every player. Clubs and players are hashed a
+ * batch of records at a time. Two saves, or one save before and after a
+ * change, can be compared record by record without touching the data again.
+ */
+struct save_hashes {
+    std::vector<uint64_t> record;
+    size_t gamea_records = 0;   // record[0, gamea_records) are the gamea blocks
+
+    void compute(const struct gamea &game_data = gamea, const struct gameb &club_data = gameb,
+                 const struct gamec &player_data = gamec);
+
+    const uint64_t *club() const { return record.data() + gamea_records; }
+    const uint64_t *player() const { return club() + CLUB_IDX_MAX; }
+
+    /* One value for the whole save */
+    uint64_t save() const;
+
+    /* Indexes of the records that differ from another set of hashes */
+    std::vector<size_t> changed(const struct save_hashes &other) const;
+};
+
+#endif
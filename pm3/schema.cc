@@ -0,0 +1,21 @@
+#include "schema.hh"
+
+std::string field_to_string(const void *record, const struct field_desc &f, int element) {
+    const uint8_t *p = static_cast<const uint8_t *>(record) + f.offset + element * f.width;
+
+    if (f.type == FIELD_TEXT)
+        return std::string(reinterpret_cast<const char *>(p), strnlen(reinterpret_cast<const char *>(p), f.width));
+
+    if (f.type == FIELD_BYTES || f.type == FIELD_BLOCK) {
+        static const char hex[] = "0123456789abcdef";
+        std::string s;
+        s.reserve(f.width * 2);
+        for (int i = 0; i < f.width; ++i) {
+            s += hex[p[i] >> 4];
+            s += hex[p[i] & 0x0f];
+        }
+        return s;
+    }
+
+    return std::to_string(get_field(record, f, element));
+}
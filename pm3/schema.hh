@@ -0,0 +1,364 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "pm3.hh"
+
+/*
+ * Compile-time description of the packed save structures.
+ *
+ * Every member of gamea, gamea::manager, gameb::club and gamec::player has a
+ * descriptor with its offset, element width and count, bitfield shift/mask and
+ * semantic type. The tables are constexpr and checked against the real layouts
+ * below, so dump, export and diff code can walk the records generically.
+ */
+
+typedef enum {
+    FIELD_UINT,
+    FIELD_INT,
+    FIELD_MONEY,      /* signed amount in pounds */
+    FIELD_CLUB_IDX,   /* index into gameb.club, -1 for none */
+    FIELD_PLAYER_IDX, /* index into gamec.player, -1 for none */
+    FIELD_TEXT,       /* fixed width, not necessarily nul terminated */
+    FIELD_BYTES,      /* unknown data */
+    FIELD_BLOCK,      /* nested structure */
+} field_type;
+
+struct field_desc {
+    const char *name;
+    uint16_t offset;
+    uint16_t width;  /* bytes per element (storage unit for bitfields) */
+    uint8_t shift;
+    uint32_t mask;   /* 0 unless this is a bitfield */
+    field_type type;
+    uint16_t count;  /* number of elements */
+};
+
+#define PM3_FIELD(T, member, type) \
+    { #member, offsetof(T, member), sizeof(((T *) nullptr)->member), 0, 0, type, 1 }
+
+#define PM3_ARRAY(T, member, type) \
+    { #member, offsetof(T, member), sizeof(((T *) nullptr)->member[0]), 0, 0, type, \
+      sizeof(((T *) nullptr)->member) / sizeof(((T *) nullptr)->member[0]) }
+
+#define PM3_BITFIELD(name, offset, width, shift, bits, type) \
+    { name, offset, width, shift, (1u << (bits)) - 1, type, 1 }
+
+template <typename T>
+struct schema;
+
+template <>
+struct schema<struct gamec::player> {
+    static constexpr const char *name = "player";
+    static constexpr struct field_desc fields[] = {
+            PM3_FIELD(struct gamec::player, name, FIELD_TEXT),
+            PM3_FIELD(struct gamec::player, u13, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, hn, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, u15, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, tk, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, u17, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, ps, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, u19, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, sh, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, u21, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, hd, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, u23, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, cr, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, u25, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, ft, FIELD_UINT),
+            PM3_BITFIELD("morl", 26, 1, 0, 4, FIELD_UINT),
+            PM3_BITFIELD("aggr", 26, 1, 4, 4, FIELD_UINT),
+            PM3_BITFIELD("ins", 27, 1, 0, 2, FIELD_UINT),
+            PM3_BITFIELD("age", 27, 1, 2, 6, FIELD_UINT),
+            PM3_BITFIELD("foot", 28, 1, 0, 2, FIELD_UINT),
+            PM3_BITFIELD("dpts", 28, 1, 2, 6, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, played, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, scored, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, unk2, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, wage, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, ins_cost, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, period, FIELD_UINT),
+            PM3_BITFIELD("period_type", 37, 1, 0, 5, FIELD_UINT),
+            PM3_BITFIELD("contract", 37, 1, 5, 3, FIELD_UINT),
+            PM3_FIELD(struct gamec::player, unk5, FIELD_UINT),
+            PM3_BITFIELD("train", 39, 1, 0, 4, FIELD_UINT),
+            PM3_BITFIELD("intense", 39, 1, 4, 4, FIELD_UINT),
+    };
+};
+
+template <>
+struct schema<struct gameb::club> {
+    static constexpr const char *name = "club";
+    static constexpr struct field_desc fields[] = {
+            PM3_FIELD(struct gameb::club, name, FIELD_TEXT),
+            PM3_FIELD(struct gameb::club, manager, FIELD_TEXT),
+            PM3_FIELD(struct gameb::club, bank_account, FIELD_MONEY),
+            PM3_FIELD(struct gameb::club, stadium, FIELD_TEXT),
+            PM3_FIELD(struct gameb::club, seating_avg, FIELD_INT),
+            PM3_FIELD(struct gameb::club, seating_max, FIELD_INT),
+            PM3_FIELD(struct gameb::club, padding, FIELD_BYTES),
+            PM3_ARRAY(struct gameb::club, player_index, FIELD_PLAYER_IDX),
+            PM3_FIELD(struct gameb::club, misc000, FIELD_BYTES),
+            PM3_ARRAY(struct gameb::club, kit, FIELD_BLOCK),
+            PM3_FIELD(struct gameb::club, player_image, FIELD_UINT),
+            PM3_ARRAY(struct gameb::club, weekly_league_position, FIELD_UINT),
+            PM3_FIELD(struct gameb::club, misc005, FIELD_BYTES),
+            PM3_FIELD(struct gameb::club, league, FIELD_UINT),
+            PM3_FIELD(struct gameb::club, timetable, FIELD_BLOCK),
+    };
+};
+
+template <>
+struct schema<struct gamea::manager> {
+    static constexpr const char *name = "manager";
+    static constexpr struct field_desc fields[] = {
+            PM3_FIELD(struct gamea::manager, name, FIELD_TEXT),
+            PM3_FIELD(struct gamea::manager, club_idx, FIELD_CLUB_IDX),
+            PM3_FIELD(struct gamea::manager, division, FIELD_INT),
+            PM3_FIELD(struct gamea::manager, contract_length, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, price.league_match_seating, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, price.league_match_terrace, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, price.cup_match_seating, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, price.cup_match_terrace, FIELD_UINT),
+            PM3_ARRAY(struct gamea::manager, seating_history, FIELD_UINT),
+            PM3_ARRAY(struct gamea::manager, terrace_history, FIELD_UINT),
+            PM3_ARRAY(struct gamea::manager, bank_statement, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea::manager, loan, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea::manager, employee, FIELD_BLOCK),
+            PM3_FIELD(struct gamea::manager, assistant_manager, FIELD_BLOCK),
+            PM3_FIELD(struct gamea::manager, data120, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, youth_player_type, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, data121, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, youth_player, FIELD_PLAYER_IDX),
+            PM3_FIELD(struct gamea::manager, data147, FIELD_BYTES),
+            PM3_ARRAY(struct gamea::manager, scout, FIELD_BLOCK),
+            PM3_FIELD(struct gamea::manager, smnthn, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, number1, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, number2, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, number3, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, money_from_directors, FIELD_MONEY),
+            PM3_FIELD(struct gamea::manager, data149, FIELD_BYTES),
+            PM3_ARRAY(struct gamea::manager, news, FIELD_BLOCK),
+            PM3_FIELD(struct gamea::manager, minus_one, FIELD_INT),
+            PM3_ARRAY(struct gamea::manager, unknown_player_idx, FIELD_PLAYER_IDX),
+            PM3_FIELD(struct gamea::manager, data150, FIELD_BYTES),
+            PM3_FIELD(struct gamea::manager, stadium, FIELD_BLOCK),
+            PM3_FIELD(struct gamea::manager, numb01, FIELD_INT),
+            PM3_FIELD(struct gamea::manager, numb02, FIELD_INT),
+            PM3_FIELD(struct gamea::manager, numb03, FIELD_INT),
+            PM3_FIELD(struct gamea::manager, numb04, FIELD_INT),
+            PM3_FIELD(struct gamea::manager, managerial_rating_current, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, managerial_rating_start, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, directors_confidence_current, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, directors_confidence_start, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, supporters_confidence_current, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, supporters_confidence_start, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, head6, FIELD_BYTES),
+            PM3_FIELD(struct gamea::manager, player3_idx, FIELD_PLAYER_IDX),
+            PM3_FIELD(struct gamea::manager, magic4, FIELD_BYTES),
+            PM3_FIELD(struct gamea::manager, player4_idx, FIELD_PLAYER_IDX),
+            PM3_FIELD(struct gamea::manager, foot6, FIELD_BYTES),
+            PM3_FIELD(struct gamea::manager, match_summary, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea::manager, league_history, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea::manager, titles, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea::manager, manager_history, FIELD_BLOCK),
+            PM3_FIELD(struct gamea::manager, data159, FIELD_BYTES),
+            PM3_ARRAY(struct gamea::manager, previous_clubs, FIELD_BLOCK),
+            PM3_FIELD(struct gamea::manager, year_start_cur_club, FIELD_INT),
+            PM3_FIELD(struct gamea::manager, manager_of_the_month_awards, FIELD_UINT),
+            PM3_FIELD(struct gamea::manager, manager_of_the_year_awards, FIELD_UINT),
+            PM3_ARRAY(struct gamea::manager, match_history, FIELD_BLOCK),
+            PM3_FIELD(struct gamea::manager, data160, FIELD_BYTES),
+            PM3_ARRAY(struct gamea::manager, tactic, FIELD_TEXT),
+    };
+};
+
+template <>
+struct schema<struct gamea> {
+    static constexpr const char *name = "gamea";
+    static constexpr struct field_desc fields[] = {
+            PM3_ARRAY(struct gamea, club_index.all, FIELD_CLUB_IDX),
+            PM3_ARRAY(struct gamea, table.all, FIELD_BLOCK),
+            PM3_FIELD(struct gamea, data000, FIELD_UINT),
+            PM3_FIELD(struct gamea, data001, FIELD_UINT),
+            PM3_FIELD(struct gamea, data002, FIELD_UINT),
+            PM3_ARRAY(struct gamea, top_scorers.all, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea, sorted_numbers, FIELD_UINT),
+            PM3_ARRAY(struct gamea, referee, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea, cuppy.all, FIELD_BLOCK),
+            PM3_FIELD(struct gamea, data095, FIELD_BYTES),
+            PM3_FIELD(struct gamea, the_charity_shield_history, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea, some_table, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea, last_results.all, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea, league, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea, cup, FIELD_BLOCK),
+            PM3_ARRAY(struct gamea, fixture, FIELD_BLOCK),
+            PM3_FIELD(struct gamea, data100, FIELD_BYTES),
+            PM3_ARRAY(struct gamea, transfer_market, FIELD_BLOCK),
+            PM3_FIELD(struct gamea, data10z, FIELD_BYTES),
+            PM3_ARRAY(struct gamea, transfer, FIELD_BLOCK),
+            PM3_FIELD(struct gamea, data101, FIELD_BYTES),
+            PM3_FIELD(struct gamea, retired_manager_club_idx, FIELD_CLUB_IDX),
+            PM3_FIELD(struct gamea, new_manager_club_idx, FIELD_CLUB_IDX),
+            PM3_FIELD(struct gamea, manager_name, FIELD_TEXT),
+            PM3_FIELD(struct gamea, data10w, FIELD_BYTES),
+            PM3_FIELD(struct gamea, turn, FIELD_UINT),
+            PM3_FIELD(struct gamea, year, FIELD_UINT),
+            PM3_ARRAY(struct gamea, data10x, FIELD_UINT),
+            PM3_ARRAY(struct gamea, manager, FIELD_BLOCK),
+            PM3_FIELD(struct gamea, data200, FIELD_BYTES),
+            PM3_FIELD(struct gamea, inc_number1, FIELD_UINT),
+            PM3_FIELD(struct gamea, inc_number2, FIELD_UINT),
+            PM3_FIELD(struct gamea, inc_number3, FIELD_UINT),
+    };
+};
+
+constexpr uint32_t storage_unit_bits(uint16_t width) {
+    return width >= 4 ? 0xFFFFFFFFu : (1u << (width * 8)) - 1;
+}
+
+/*
+ * The descriptors must tile the record exactly: sorted by offset, no gaps, no
+ * overlaps, and the bitfields sharing a storage unit must cover all of its bits.
+ */
+template <size_t N>
+constexpr bool check_layout(const struct field_desc (&fields)[N], size_t size) {
+    size_t end = 0;
+    size_t unit = SIZE_MAX;
+    uint16_t unit_width = 0;
+    uint32_t unit_bits = 0;
+
+    for (size_t i = 0; i < N; ++i) {
+        const struct field_desc &f = fields[i];
+
+        if (f.mask && f.offset == unit) {
+            if (f.width != unit_width || (unit_bits & (f.mask << f.shift)))
+                return false;
+            unit_bits |= f.mask << f.shift;
+            continue;
+        }
+
+        if (unit != SIZE_MAX && unit_bits != storage_unit_bits(unit_width))
+            return false;
+        if (f.offset != end || f.count == 0)
+            return false;
+
+        if (f.mask) {
+            unit = f.offset;
+            unit_width = f.width;
+            unit_bits = f.mask << f.shift;
+            end = f.offset + f.width;
+        } else {
+            unit = SIZE_MAX;
+            end = f.offset + f.width * f.count;
+        }
+    }
+
+    if (unit != SIZE_MAX && unit_bits != storage_unit_bits(unit_width))
+        return false;
+
+    return end == size;
+}
+
+static_assert(sizeof (struct gamea)         == 0x7372, "gamea layout");
+static_assert(sizeof (struct gameb::club)   == 0x023A, "gameb::club layout");
+static_assert(sizeof (struct gamec::player) == 0x0028, "gamec::player layout");
+
+static_assert(check_layout(schema<struct gamea>::fields, sizeof (struct gamea)), "gamea schema");
+static_assert(check_layout(schema<struct gamea::manager>::fields, sizeof (struct gamea::manager)), "gamea::manager schema");
+static_assert(check_layout(schema<struct gameb::club>::fields, sizeof (struct gameb::club)), "gameb::club schema");
+static_assert(check_layout(schema<struct gamec::player>::fields, sizeof (struct gamec::player)), "gamec::player schema");
+
+inline bool is_numeric(const struct field_desc &f) {
+    return f.type != FIELD_TEXT && f.type != FIELD_BYTES && f.type != FIELD_BLOCK;
+}
+
+inline bool is_signed(const struct field_desc &f) {
+    return f.type == FIELD_INT || f.type == FIELD_MONEY ||
+           f.type == FIELD_CLUB_IDX || f.type == FIELD_PLAYER_IDX;
+}
+
+inline int64_t get_field(const void *record, const struct field_desc &f, int element = 0) {
+    uint64_t raw = 0;
+    memcpy(&raw, static_cast<const uint8_t *>(record) + f.offset + element * f.width, f.width);
+
+    if (f.mask)
+        return (raw >> f.shift) & f.mask;
+
+    if (is_signed(f) && f.width < 8 && (raw >> (f.width * 8 - 1)) & 1)
+        raw |= ~0ull << (f.width * 8);
+
+    return (int64_t) raw;
+}
+
+inline void set_field(void *record, const struct field_desc &f, int64_t value, int element = 0) {
+    uint8_t *p = static_cast<uint8_t *>(record) + f.offset + element * f.width;
+    uint64_t raw = 0;
+
+    if (f.mask) {
+        memcpy(&raw, p, f.width);
+        raw &= ~((uint64_t) f.mask << f.shift);
+        raw |= ((uint64_t) value & f.mask) << f.shift;
+    } else {
+        raw = (uint64_t) value;
+    }
+    memcpy(p, &raw, f.width);
+}
+
+/* Smallest and largest value a numeric field can hold. */
+inline int64_t field_min(const struct field_desc &f) {
+    if (f.mask || !is_signed(f))
+        return 0;
+    return -(1ll << (f.width * 8 - 1));
+}
+
+inline int64_t field_max(const struct field_desc &f) {
+    if (f.mask)
+        return f.mask;
+    if (is_signed(f))
+        return (1ll << (f.width * 8 - 1)) - 1;
+    return f.width >= 8 ? INT64_MAX : (1ll << (f.width * 8)) - 1;
+}
+
+template <typename T>
+const struct field_desc *find_field(const std::string &name) {
+    for (const struct field_desc &f : schema<T>::fields) {
+        if (name == f.name)
+            return &f;
+    }
+    return nullptr;
+}
+
+/* Calls visit(field, record_bytes) for every descriptor of T. */
+template <typename T, typename Visitor>
+void visit_fields(const T &record, Visitor &&visit) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&record);
+    for (const struct field_desc &f : schema<T>::fields)
+        visit(f, bytes);
+}
+
+/* Calls visit(field, element, a_bytes, b_bytes) for every element that differs. */
+template <typename T, typename Visitor>
+void diff_fields(const T &a, const T &b, Visitor &&visit) {
+    const uint8_t *pa = reinterpret_cast<const uint8_t *>(&a);
+    const uint8_t *pb = reinterpret_cast<const uint8_t *>(&b);
+
+    for (const struct field_desc &f : schema<T>::fields) {
+        for (int e = 0; e < f.count; ++e) {
+            if (f.mask || is_numeric(f)) {
+                if (get_field(pa, f, e) != get_field(pb, f, e))
+                    visit(f, e, pa, pb);
+            } else if (memcmp(pa + f.offset + e * f.width, pb + f.offset + e * f.width, f.width) != 0) {
+                visit(f, e, pa, pb);
+            }
+        }
+    }
+}
+
+std::string field_to_string(const void *record, const struct field_desc &f, int element = 0);
+
+#endif
@@ -0,0 +1,146 @@
+#include "season.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "random.hh"
+#include "standings.hh"
+
+double match_model::home_mean(int home_strength, int away_strength) const {
+    return home_goals * std::exp(skill * (home_strength - away_strength) / LINEUP_STARTERS);
+}
+
+double match_model::away_mean(int home_strength, int away_strength) const {
+    return away_goals * std::exp(skill * (away_strength - home_strength) / LINEUP_STARTERS);
+}
+
+season_simulator::season_simulator(const struct gamea &game_data, const struct gameb &club_data,
+                                   const struct gamec &player_data, const struct formation &f,
+                                   const struct match_model &model) {
+    std::fill(club_division, club_division + CLUB_IDX_MAX, -1);
+
+    for (int div = 0; div < 5; ++div) {
+        for (int i = division_offset[div]; i < division_offset[div + 1]; ++i) {
+            const auto &t = game_data.table.all[i];
+            if (t.club_idx < 0 || t.club_idx >= CLUB_IDX_MAX)
+                continue;
+
+            struct lineup l{};
+            pick_lineup(t.club_idx, f, l, club_data, player_data);
+            club_strength[t.club_idx] = l.strength;
+            club_division[t.club_idx] = (int8_t) div;
+
+            int won = t.hw + t.aw, drawn = t.hd + t.ad;
+            int goals_for = t.hf + t.af, goals_against = t.ha + t.aa;
+            table[div].push_back({t.club_idx, POINTS_FOR_WIN * won + POINTS_FOR_DRAW * drawn,
+                                  goals_for - goals_against, goals_for});
+        }
+    }
+
+    calendar cal(club_data);
+    for (const struct fixture &fx : cal.all()) {
+        if (fx.played() || !is_league_match(fx.type))
+            continue;
+        if (club_division[fx.home_idx] == -1 || club_division[fx.home_idx] != club_division[fx.away_idx])
+            continue;
+
+        int h = club_strength[fx.home_idx], a = club_strength[fx.away_idx];
+        fixtures.push_back({fx.home_idx, fx.away_idx, std::exp(-model.home_mean(h, a)), std::exp(-model.away_mean(h, a))});
+    }
+}
+
+void season_simulator::simulate(int simulations, uint64_t seed, int stream, std::vector<uint32_t> &finish,
+                                std::vector<uint64_t> &points) const {
+    struct rng random(seed, stream);
+    int pts[CLUB_IDX_MAX], gd[CLUB_IDX_MAX], gf[CLUB_IDX_MAX];
+    std::vector<int16_t> order[5];
+
+    for (int div = 0; div < 5; ++div) {
+        for (const struct row &r : table[div])
+            order[div].push_back(r.club_idx);
+    }
+
+    for (int sim = 0; sim < simulations; ++sim) {
+        for (int div = 0; div < 5; ++div) {
+            for (const struct row &r : table[div]) {
+                pts[r.club_idx] = r.points;
+                gd[r.club_idx] = r.goal_difference;
+                gf[r.club_idx] = r.goals_for;
+            }
+        }
+
+        for (const struct pending &p : fixtures) {
+            int hg = random.poisson(p.home_limit);
+            int ag = random.poisson(p.away_limit);
+
+            pts[p.home] += hg > ag ? POINTS_FOR_WIN : hg == ag ? POINTS_FOR_DRAW : 0;
+            pts[p.away] += ag > hg ? POINTS_FOR_WIN : hg == ag ? POINTS_FOR_DRAW : 0;
+            gd[p.home] += hg - ag;
+            gd[p.away] += ag - hg;
+            gf[p.home] += hg;
+            gf[p.away] += ag;
+        }
+
+        for (int div = 0; div < 5; ++div) {
+            std::sort(order[div].begin(), order[div].end(), [&](int16_t a, int16_t b) {
+                if (pts[a] != pts[b])
+                    return pts[a] > pts[b];
+                if (gd[a] != gd[b])
+                    return gd[a] > gd[b];
+                return gf[a] > gf[b];
+            });
+
+            for (size_t pos = 0; pos < order[div].size(); ++pos) {
+                int16_t idx = order[div][pos];
+                ++finish[idx * 24 + pos];
+                points[idx] += pts[idx];
+            }
+        }
+    }
+}
+
+void season_simulator::run(int simulations, struct season_odds &odds, int threads, uint64_t seed) const {
+    if (!threads)
+        threads = (int) std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, simulations));
+
+    std::vector<std::vector<uint32_t>> finish(threads, std::vector<uint32_t>(CLUB_IDX_MAX * 24));
+    std::vector<std::vector<uint64_t>> points(threads, std::vector<uint64_t>(CLUB_IDX_MAX));
+    std::vector<std::thread> pool;
+
+    for (int t = 0; t < threads; ++t) {
+        int share = simulations / threads + (t < simulations % threads);
+        pool.emplace_back(&season_simulator::simulate, this, share, seed, t, std::ref(finish[t]), std::ref(points[t]));
+    }
+    for (std::thread &thread : pool)
+        thread.join();
+
+    odds.simulations = simulations;
+    std::copy(club_division, club_division + CLUB_IDX_MAX, odds.division);
+    for (int c = 0; c < CLUB_IDX_MAX; ++c) {
+        uint64_t total_points = 0;
+        for (int t = 0; t < threads; ++t)
+            total_points += points[t][c];
+        odds.points[c] = (double) total_points / simulations;
+
+        for (int pos = 0; pos < 24; ++pos) {
+            uint64_t n = 0;
+            for (int t = 0; t < threads; ++t)
+                n += finish[t][c * 24 + pos];
+            odds.position[c][pos] = (double) n / simulations;
+        }
+
+        odds.title[c] = odds.promotion[c] = odds.relegation[c] = 0;
+        int div = club_division[c];
+        if (div == -1)
+            continue;
+
+        int size = (int) table[div].size();
+        odds.title[c] = odds.position[c][0];
+        for (int pos = 0; pos < promoted_clubs[div]; ++pos)
+            odds.promotion[c] += odds.position[c][pos];
+        for (int pos = size - relegated_clubs[div]; pos < size; ++pos)
+            odds.relegation[c] += odds.position[c][pos];
+    }
+}
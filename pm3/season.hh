@@ -0,0 +1,71 @@
+#ifndef SEASON_H
+#define SEASON_H
+
+#include <vector>
+
+#include "pm3.hh"
+#include "calendar.hh"
+#include "lineup.hh"
+
+/* Clubs going up from and down out of each division at the end of the season */
+static const int promoted_clubs[] = { 0, 3, 3, 4, 1 };
+static const int relegated_clubs[] = { 3, 3, 4, 1, 0 };
+
+/*
+ * Goals are Poisson with a mean that grows exponentially with the difference
+ * in average lineup rating between the sides.
+ */
+struct match_model {
+    double home_goals = 1.45;
+    double away_goals = 1.10;
+    double skill = 0.04;  // per rating point of difference
+
+    double home_mean(int home_strength, int away_strength) const;
+    double away_mean(int home_strength, int away_strength) const;
+};
+
+struct season_odds {
+    int simulations;
+    int8_t division[CLUB_IDX_MAX];       // -1 for clubs outside the league
+    double points[CLUB_IDX_MAX];         // expected final points
+    double title[CLUB_IDX_MAX];
+    double promotion[CLUB_IDX_MAX];
+    double relegation[CLUB_IDX_MAX];
+    double position[CLUB_IDX_MAX][24];   // probability of each final position
+};
+
+/*
+ * Plays out the unplayed league fixtures of the season many times, starting
+ * from the table stored in gamea. Every thread has its own random stream and
+ * its own counters, which are only added together once all threads finish.
+ */
+class season_simulator {
+public:
+    season_simulator(const struct gamea &game_data, const struct gameb &club_data, const struct gamec &player_data,
+                     const struct formation &f, const struct match_model &model = match_model());
+
+    void run(int simulations, struct season_odds &odds, int threads = 0, uint64_t seed = 0) const;
+
+    int strength(int club_idx) const { return club_strength[club_idx]; }
+
+private:
+    struct pending {
+        uint8_t home, away;
+        double home_limit, away_limit;  // exp(-mean) for rng::poisson
+    };
+
+    struct row {
+        int16_t club_idx;
+        int points, goal_difference, goals_for;
+    };
+
+    int club_strength[CLUB_IDX_MAX] = {};
+    int8_t club_division[CLUB_IDX_MAX];
+    std::vector<struct row> table[5];
+    std::vector<struct pending> fixtures;
+
+    void simulate(int simulations, uint64_t seed, int stream, std::vector<uint32_t> &finish,
+                  std::vector<uint64_t> &points) const;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "server.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+bool send_all(int fd, const std::string &data) {
+    for (size_t sent = 0; sent < data.size();) {
+        ssize_t length = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (length < 0 && errno == EINTR)
+            continue;
+        if (length <= 0)
+            return false;
+        sent += length;
+    }
+    return true;
+}
+
+bool send_answer(int fd, const struct command_result &result) {
+    return send_all(fd, (result.ok ? "OK " : "ERR ") + std::to_string(result.output.size()) + "\n" + result.output);
+}
+
+}
+
+query_server::query_server(const std::string &path, save_cache &cache) : path(path), cache(cache) {
+    struct sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Socket path too long: " + path);
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+        throw std::runtime_error(std::string("Could not create socket: ") + strerror(errno));
+
+    unlink(path.c_str());
+    if (bind(listen_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd, 64) != 0) {
+        std::string reason = strerror(errno);
+        close(listen_fd);
+        throw std::runtime_error("Could not listen on " + path + ": " + reason);
+    }
+}
+
+query_server::~query_server() {
+    reap(true);
+    close(listen_fd);
+    unlink(path.c_str());
+}
+
+void query_server::run(const volatile sig_atomic_t &stop) {
+    while (!stop) {
+        struct pollfd fds = {listen_fd, POLLIN, 0};
+        if (poll(&fds, 1, SERVER_POLL_MS) < 0 && errno != EINTR)
+            throw std::runtime_error(std::string("poll: ") + strerror(errno));
+        reap(false);
+        if (!(fds.revents & POLLIN))
+            continue;
+
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        struct client &c = clients.emplace_back();
+        c.fd = fd;
+        c.thread = std::thread(&query_server::serve, this, std::ref(c));
+    }
+    reap(true);
+}
+
+void query_server::reap(bool all) {
+    if (all)
+        stopping = true;
+
+    for (auto it = clients.begin(); it != clients.end();) {
+        if (!all && !it->done) {
+            ++it;
+            continue;
+        }
+        it->thread.join();
+        close(it->fd);
+        it = clients.erase(it);
+    }
+}
+
+void query_server::serve(struct client &c) {
+    session s(cache);
+    std::string pending;
+    char buffer[4096];
+
+    while (!stopping) {
+        struct pollfd fds = {c.fd, POLLIN, 0};
+        int ready = poll(&fds, 1, SERVER_POLL_MS);
+        if (ready < 0 && errno != EINTR)
+            break;
+        if (ready <= 0)
+            continue;
+
+        ssize_t length = recv(c.fd, buffer, sizeof(buffer), 0);
+        if (length < 0 && errno == EINTR)
+            continue;
+        if (length <= 0)
+            break;
+        pending.append(buffer, length);
+
+        size_t start = 0, end;
+        bool open = true;
+        while (open && (end = pending.find('\n', start)) != std::string::npos) {
+            std::string line = pending.substr(start, end - start);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            start = end + 1;
+
+            struct command_result result;
+            try {
+                result = s.execute(line);
+            } catch (const std::exception &e) {
+                result = {false, std::string(e.what()) + "\n"};
+            }
+            open = send_answer(c.fd, result);
+        }
+        pending.erase(0, start);
+
+        if (!open)
+            break;
+        if (pending.size() > SERVER_MAX_LINE) {
+            send_answer(c.fd, {false, "Request too long\n"});
+            break;
+        }
+    }
+    c.done = true;
+}
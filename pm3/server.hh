@@ -0,0 +1,52 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <csignal>
+#include <list>
+#include <string>
+#include <thread>
+
+#include "session.hh"
+
+/* Milliseconds between looks at the stop flag */
+#define SERVER_POLL_MS 200
+
+/* Longest request line; a client sending more is dropped */
+#define SERVER_MAX_LINE 65536
+
+/*
+ * Unix socket server answering session commands. Each client gets a thread
+ * and a session of its own over the shared save_cache. A request is one
+ * line; the answer is a header line "OK <length>" or "ERR <length>"
+ * followed by that many bytes of output.
+ */
+class query_server {
+public:
+    query_server(const std::string &path, save_cache &cache);
+    ~query_server();
+
+    query_server(const query_server &) = delete;
+    query_server &operator=(const query_server &) = delete;
+
+    /* Accept and serve clients until stop is set, then hang up on them */
+    void run(const volatile sig_atomic_t &stop);
+
+private:
+    struct client {
+        int fd;
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    std::string path;
+    int listen_fd = -1;
+    save_cache &cache;
+    std::atomic<bool> stopping{false};
+    std::list<struct client> clients;
+
+    void serve(struct client &c);
+    void reap(bool all);
+};
+
+#endif
@@ -0,0 +1,475 @@
+#include "session.hh"
+
+#include <cstdarg>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+
+#include "diff.hh"
+#include "edit.hh"
+#include "journal.hh"
+#include "schema.hh"
+#include "transform.hh"
+
+#define PLAYER_COUNT 3932
+#define LEAGUE_CLUBS 114
+#define TOP_DEFAULT 20
+
+namespace {
+
+void appendf(std::string &out, const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+
+void appendf(std::string &out, const char *format, ...) {
+    char buffer[512];
+    va_list args, again;
+    va_start(args, format);
+    va_copy(again, args);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    /* Hex dumps of unknown data run to kilobytes */
+    if (length >= (int) sizeof(buffer)) {
+        size_t start = out.size();
+        out.resize(start + length + 1);
+        vsnprintf(&out[start], length + 1, format, again);
+        out.resize(start + length);
+    } else if (length > 0) {
+        out.append(buffer, length);
+    }
+    va_end(again);
+}
+
+bool parse_spec(const std::string &spec, std::string &game_path, int &game_nr) {
+    size_t colon = spec.rfind(':');
+    if (colon == std::string::npos || colon + 2 != spec.size() || spec[colon + 1] < '1' || spec[colon + 1] > '8')
+        return false;
+
+    game_path = spec.substr(0, colon);
+    game_nr = spec[colon + 1] - '0';
+    return true;
+}
+
+bool parse_index(const std::string &word, int limit, int &index) {
+    char *end = nullptr;
+    long value = strtol(word.c_str(), &end, 0);
+    if (word.empty() || *end || value < 0 || value >= limit)
+        return false;
+    index = (int) value;
+    return true;
+}
+
+/* Every field of T, or the named ones; blocks only when named */
+template <typename T>
+bool append_fields(std::string &out, const T &record, const std::vector<std::string> &names, std::string &error) {
+    std::vector<const struct field_desc *> fields;
+
+    for (const std::string &name : names) {
+        const struct field_desc *f = find_field<T>(name);
+        if (!f) {
+            error = "Unknown " + std::string(schema<T>::name) + " field: " + name;
+            return false;
+        }
+        fields.push_back(f);
+    }
+    if (names.empty()) {
+        for (const struct field_desc &f : schema<T>::fields) {
+            if (f.type != FIELD_BLOCK)
+                fields.push_back(&f);
+        }
+    }
+
+    for (const struct field_desc *f : fields) {
+        for (int e = 0; e < f->count; ++e) {
+            if (f->count > 1)
+                appendf(out, "%s[%d] %s\n", f->name, e, field_to_string(&record, *f, e).c_str());
+            else
+                appendf(out, "%s %s\n", f->name, field_to_string(&record, *f, e).c_str());
+        }
+    }
+    return true;
+}
+
+void append_player(std::string &out, const struct resident_save &save, int16_t idx, const struct field_desc *field) {
+    struct gamec::player p;
+    memcpy(&p, &save.player_data->player[idx], sizeof(p));
+    int16_t club_idx = save.index.owner(idx);
+
+    appendf(out, "(%04x) %12.12s %c %16.16s", idx, p.name, determine_player_type(p),
+            club_idx >= 0 ? save.club_data->club[club_idx].name : "-");
+    if (field)
+        appendf(out, " %s", field_to_string(&p, *field).c_str());
+    out += '\n';
+}
+
+void append_diff(std::string &out, const struct save_diff &diff) {
+    for (const struct record_change &c : diff.changes) {
+        if (c.record == -1)
+            appendf(out, "%s.%s", c.record_type, c.field->name);
+        else
+            appendf(out, "%s[%d].%s", c.record_type, c.record, c.field->name);
+        if (c.field->count > 1)
+            appendf(out, "[%d]", c.element);
+        appendf(out, ": %s -> %s\n", c.before.c_str(), c.after.c_str());
+    }
+    appendf(out, "%zu changes in %zu of %zu records\n", diff.changes.size(), diff.changed, diff.records);
+}
+
+}
+
+bool save_cache::load(struct resident_save &save, std::string &error) {
+    std::unique_ptr<struct gamea> game_data = std::make_unique<struct gamea>();
+    std::unique_ptr<struct gameb> club_data = std::make_unique<struct gameb>();
+    std::unique_ptr<struct gamec> player_data = std::make_unique<struct gamec>();
+    struct sidecar_key key{};
+
+    if (!stat_save_files(save.game_path, save.game_nr, key)) {
+        error = "No savegame " + save.spec;
+        return false;
+    }
+    if (!load_save_spec(save.spec, *game_data, *club_data, *player_data, error))
+        return false;
+
+    bool update = std::filesystem::exists(sidecar_path(save.game_path, save.game_nr));
+    open_save_index(save.index, save.game_path, save.game_nr, update, *game_data, *club_data, *player_data);
+
+    save.key = key;
+    save.game_data = std::move(game_data);
+    save.club_data = std::move(club_data);
+    save.player_data = std::move(player_data);
+    save.loaded = true;
+    save.edited = false;
+    ++save.loads;
+    return true;
+}
+
+std::shared_ptr<struct resident_save> save_cache::get(const std::string &spec, std::string &error) {
+    std::shared_ptr<struct resident_save> save;
+    std::string game_path;
+    int game_nr;
+
+    if (!parse_spec(spec, game_path, game_nr)) {
+        error = "Savegames are given as PATH:1-8, not " + spec;
+        return nullptr;
+    }
+    if (get_pm3_game_type(game_path.c_str()) == PM3_UNKNOWN) {
+        error = "Did not find " EXE_STANDARD_FILENAME " or " EXE_DELUXE_FILENAME " in " + game_path;
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::shared_ptr<struct resident_save> &entry = saves[spec];
+        if (!entry) {
+            entry = std::make_shared<struct resident_save>();
+            entry->spec = spec;
+            entry->game_path = game_path;
+            entry->game_nr = game_nr;
+        }
+        save = entry;
+    }
+
+    struct sidecar_key key{};
+    bool exists = stat_save_files(game_path, game_nr, key);
+    auto fresh = [&] {
+        return save->loaded && (save->edited || (exists && 0 == memcmp(save->key.size, key.size, sizeof(key.size)) &&
+                                                 0 == memcmp(save->key.mtime, key.mtime, sizeof(key.mtime))));
+    };
+
+    {
+        std::shared_lock<std::shared_mutex> reader(save->lock);
+        if (fresh())
+            return save;
+    }
+
+    std::unique_lock<std::shared_mutex> writer(save->lock);
+    if (!fresh() && !load(*save, error))
+        return nullptr;
+    return save;
+}
+
+bool save_cache::store(struct resident_save &save, std::string &error) {
+    {
+        std::lock_guard<std::mutex> guard(metadata);
+        if (!save_save_spec(save.spec, *save.game_data, *save.club_data, *save.player_data, error))
+            return false;
+    }
+
+    save.edited = false;
+    stat_save_files(save.game_path, save.game_nr, save.key);
+    bool update = std::filesystem::exists(sidecar_path(save.game_path, save.game_nr));
+    open_save_index(save.index, save.game_path, save.game_nr, update, *save.game_data, *save.club_data,
+                    *save.player_data);
+    return true;
+}
+
+std::vector<std::string> save_cache::specs() const {
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<std::string> result;
+
+    for (const auto &entry : saves)
+        result.push_back(entry.first);
+    return result;
+}
+
+void session::keep_baseline(struct resident_save &save) {
+    std::shared_lock<std::shared_mutex> reader(save.lock);
+    if (baseline_game && baseline_loads == save.loads)
+        return;
+
+    baseline_game = std::make_unique<struct gamea>(*save.game_data);
+    baseline_club = std::make_unique<struct gameb>(*save.club_data);
+    baseline_player = std::make_unique<struct gamec>(*save.player_data);
+    baseline_loads = save.loads;
+}
+
+bool session::uncommitted() {
+    std::string error;
+    std::shared_ptr<struct resident_save> save = current_spec.empty() ? nullptr : cache.get(current_spec, error);
+    return save && save->edited;
+}
+
+struct command_result session::execute(const std::string &line) {
+    std::istringstream in(line);
+    std::vector<std::string> words;
+    std::string word, output, error;
+
+    while (in >> word)
+        words.push_back(word);
+    if (words.empty())
+        return {true, ""};
+
+    const std::string &command = words[0];
+    std::string rest = line.substr(std::min(line.size(), line.find(command) + command.size()));
+    rest.erase(0, rest.find_first_not_of(" \t"));
+
+    if (command == "help") {
+        return {true, "use PATH:N, saves, info, game [FIELD ...], manager IDX [FIELD ...], player IDX [FIELD ...],\n"
+                      "player NAME, club IDX [FIELD ...], find NAME, top FIELD [N], players FILTER, free [--pos G|D|M|A], diff PATH:N,\n"
+                      "edit COMMAND, set COMMAND, diff-since-load, commit\n"};
+    }
+
+    if (command == "saves") {
+        for (const std::string &spec : cache.specs())
+            appendf(output, "%s%s\n", spec.c_str(), spec == current_spec ? " *" : "");
+        return {true, output};
+    }
+
+    if (command == "use") {
+        if (words.size() != 2)
+            return {false, "use needs PATH:N\n"};
+        if (staged && uncommitted())
+            return {false, "Commit the changes to " + current_spec + " first\n"};
+        std::shared_ptr<struct resident_save> save = cache.get(words[1], error);
+        if (!save)
+            return {false, error + "\n"};
+        current_spec = words[1];
+        if (staged)
+            keep_baseline(*save);
+        return {true, ""};
+    }
+
+    if (current_spec.empty())
+        return {false, "No savegame, start with use PATH:N\n"};
+
+    std::shared_ptr<struct resident_save> save = cache.get(current_spec, error);
+    if (!save)
+        return {false, error + "\n"};
+    if (staged)
+        keep_baseline(*save);
+
+    if (command == "edit" || command == "set") {
+        std::istringstream script(rest);
+        std::vector<struct edit_command> commands;
+
+        if (!parse_edit_script(script, commands, error))
+            return {false, error + "\n"};
+
+        std::unique_lock<std::shared_mutex> writer(save->lock);
+        edit_journal journal(*save->game_data, *save->club_data, *save->player_data);
+        bool applied;
+        try {
+            applied = apply_edits(commands, save->game_path, journal, error, *save->game_data, *save->club_data,
+                                  *save->player_data);
+        } catch (const std::exception &e) {
+            /* The resident copy is shared by every client, so it must not keep half an edit */
+            journal.rollback();
+            applied = false;
+            error = e.what();
+        }
+        if (!applied)
+            return {false, error + "\n"};
+
+        size_t changes = journal.entries().size();
+        if (staged) {
+            save->edited = save->edited || changes > 0;
+            save->index.build(save->key, *save->game_data, *save->club_data, *save->player_data);
+            appendf(output, "%zu change%s, not saved until commit\n", changes, changes == 1 ? "" : "s");
+            return {true, output};
+        }
+        if (!cache.store(*save, error)) {
+            save->loaded = false;   // read again from the files on next use
+            return {false, error + "\n"};
+        }
+
+        appendf(output, "%zu change%s\n", changes, changes == 1 ? "" : "s");
+        return {true, output};
+    }
+
+    if (command == "commit") {
+        std::unique_lock<std::shared_mutex> writer(save->lock);
+        if (!save->edited)
+            return {true, "Nothing to commit\n"};
+        if (!cache.store(*save, error))
+            return {false, error + "\n"};
+        return {true, "Saved " + save->spec + "\n"};
+    }
+
+    if (command == "diff-since-load") {
+        if (!staged)
+            return {false, "Edits are saved as they are made, there is nothing to compare with\n"};
+
+        struct save_diff diff;
+        {
+            std::shared_lock<std::shared_mutex> reader(save->lock);
+            diff_saves(*baseline_game, *baseline_club, *baseline_player,
+                       *save->game_data, *save->club_data, *save->player_data, diff);
+        }
+        append_diff(output, diff);
+        return {true, output};
+    }
+
+    if (command == "diff") {
+        if (words.size() != 2)
+            return {false, "diff needs PATH:N\n"};
+        std::shared_ptr<struct resident_save> other = cache.get(words[1], error);
+        if (!other)
+            return {false, error + "\n"};
+
+        struct save_diff diff;
+        {
+            std::shared_lock<std::shared_mutex> reader(save->lock);
+            if (other == save) {
+                diff_saves(*save->game_data, *save->club_data, *save->player_data,
+                           *save->game_data, *save->club_data, *save->player_data, diff);
+            } else {
+                std::shared_lock<std::shared_mutex> other_reader(other->lock);
+                diff_saves(*save->game_data, *save->club_data, *save->player_data,
+                           *other->game_data, *other->club_data, *other->player_data, diff);
+            }
+        }
+        append_diff(output, diff);
+        return {true, output};
+    }
+
+    std::shared_lock<std::shared_mutex> reader(save->lock);
+
+    if (command == "info") {
+        appendf(output, "%s %d week %d %s\n", save->spec.c_str(), save->game_data->year,
+                save->game_data->turn / TIMETABLE_DAYS + 1, day[save->game_data->turn % TIMETABLE_DAYS]);
+        for (int m = 0; m < 2; ++m) {
+            const struct gamea::manager &manager = save->game_data->manager[m];
+            int16_t club_idx = manager.club_idx;
+            appendf(output, "manager %d %16.16s %16.16s\n", m, manager.name,
+                    club_idx >= 0 && club_idx < CLUB_IDX_MAX ? save->club_data->club[club_idx].name : "-");
+        }
+        return {true, output};
+    }
+
+    if (command == "player" && words.size() >= 2 && !isdigit((unsigned char) words[1][0])) {
+        std::string name = rest;
+        if (name.size() >= 2 && name.front() == '"' && name.back() == '"')
+            name = name.substr(1, name.size() - 2);
+        for (int16_t idx : save->index.find_players(name, *save->player_data))
+            append_player(output, *save, idx, nullptr);
+        return {true, output};
+    }
+
+    if (command == "game") {
+        std::vector<std::string> names(words.begin() + 1, words.end());
+        if (!append_fields(output, *save->game_data, names, error))
+            return {false, error + "\n"};
+        return {true, output};
+    }
+
+    if (command == "manager" || command == "player" || command == "club") {
+        int idx;
+        int limit = command == "player" ? PLAYER_COUNT : command == "club" ? CLUB_IDX_MAX : 2;
+        std::vector<std::string> names(words.begin() + std::min<size_t>(2, words.size()), words.end());
+
+        if (words.size() < 2 || !parse_index(words[1], limit, idx))
+            return {false, command + " needs an index\n"};
+
+        bool ok;
+        if (command == "player")
+            ok = append_fields(output, save->player_data->player[idx], names, error);
+        else if (command == "club")
+            ok = append_fields(output, save->club_data->club[idx], names, error);
+        else
+            ok = append_fields(output, save->game_data->manager[idx], names, error);
+        return ok ? command_result{true, output} : command_result{false, error + "\n"};
+    }
+
+    if (command == "find") {
+        if (rest.empty())
+            return {false, "find needs a name\n"};
+        for (int16_t idx : save->index.find_players(rest, *save->player_data))
+            append_player(output, *save, idx, nullptr);
+        return {true, output};
+    }
+
+    if (command == "top") {
+        int count = TOP_DEFAULT;
+        const struct field_desc *f = words.size() >= 2 ? find_field<struct gamec::player>(words[1]) : nullptr;
+
+        if (words.size() < 2 || words.size() > 3 || (words.size() == 3 && !parse_index(words[2], PLAYER_COUNT + 1, count)))
+            return {false, "top needs a player field and a count\n"};
+        if (!f)
+            return {false, "Unknown player field: " + words[1] + "\n"};
+        std::vector<int16_t> players = save->index.top_players(*f, count);
+        if (players.empty() && count > 0)
+            return {false, std::string(f->name) + " is not sorted\n"};
+        for (int16_t idx : players)
+            append_player(output, *save, idx, f);
+        return {true, output};
+    }
+
+    if (command == "players") {
+        struct player_filter filter;
+        if (!rest.empty() && !parse_player_filter(rest, filter, error))
+            return {false, error + "\n"};
+        for (int16_t idx : select_players(filter, *save->game_data, *save->club_data, *save->player_data))
+            append_player(output, *save, idx, nullptr);
+        return {true, output};
+    }
+
+    if (command == "free") {
+        char position = 0;
+        if (words.size() == 3 && words[1] == "--pos" && words[2].size() == 1)
+            position = (char) toupper((unsigned char) words[2][0]);
+        else if (words.size() == 2 && words[1].compare(0, 6, "--pos=") == 0 && words[1].size() == 7)
+            position = (char) toupper((unsigned char) words[1][6]);
+        else if (words.size() != 1)
+            return {false, "free takes --pos G, D, M or A\n"};
+        if (position && !strchr("GDMA", position))
+            return {false, "free takes --pos G, D, M or A\n"};
+
+        /* As find_free_players */
+        for (int c = 0; c < LEAGUE_CLUBS; ++c) {
+            const struct gameb::club &club = save->club_data->club[c];
+            if (club.league == 0)
+                continue;
+            for (int16_t idx : club.player_index) {
+                if (idx < 0 || idx >= PLAYER_COUNT || save->player_data->player[idx].contract != 0)
+                    continue;
+                struct gamec::player p;
+                memcpy(&p, &save->player_data->player[idx], sizeof(p));
+                if (!position || determine_player_type(p) == position)
+                    append_player(output, *save, idx, nullptr);
+            }
+        }
+        return {true, output};
+    }
+
+    return {false, "Unknown command: " + command + "\n"};
+}
@@ -0,0 +1,110 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+#include "sidecar.hh"
+
+/* A savegame kept in memory, with its indexes */
+struct resident_save {
+    std::string spec;               // PATH:N
+    std::string game_path;
+    int game_nr;
+
+    /* Shared while answering queries, exclusive while loading or editing */
+    std::shared_mutex lock;
+    bool loaded = false;
+    unsigned loads = 0;             // times read from the files
+    bool edited = false;            // changed in memory only, so not read again until stored
+    struct sidecar_key key;         // size and time of the files when loaded
+    std::unique_ptr<struct gamea> game_data;
+    std::unique_ptr<struct gameb> club_data;
+    std::unique_ptr<struct gamec> player_data;
+    save_index index;
+};
+
+/*
+ * The savegames that have been asked for, by PATH:N. A save is read on
+ * first use and again whenever the size or time of one of its files has
+ * changed, so the game can keep playing while they are being served.
+ */
+class save_cache {
+public:
+    /* Null with the reason in error if the save cannot be read */
+    std::shared_ptr<struct resident_save> get(const std::string &spec, std::string &error);
+
+    /* Write an edited save back; it must be held exclusively */
+    bool store(struct resident_save &save, std::string &error);
+
+    std::vector<std::string> specs() const;
+
+private:
+    mutable std::mutex lock;
+    std::mutex metadata;            // SAVES.DIR is shared by the saves of an install
+    std::map<std::string, std::shared_ptr<struct resident_save>> saves;
+
+    bool load(struct resident_save &save, std::string &error);
+};
+
+struct command_result {
+    bool ok;
+    std::string output;
+};
+
+/*
+ * Interpreter of one client, one command per line:
+ *
+ *   use PATH:N                   make a save the current one
+ *   saves                        list the saves in memory
+ *   info                         date and managers of the current save
+ *   game [FIELD ...]             fields of gamea itself, all but blocks by default
+ *   manager 0-1 [FIELD ...]      fields of a manager
+ *   player 0-3931 [FIELD ...]    fields of a player, all by default
+ *   player NAME                  players whose name contains NAME
+ *   club 0-243 [FIELD ...]       fields of a club
+ *   find NAME                    players whose name contains NAME
+ *   top FIELD [N]                players with the highest FIELD
+ *   players FILTER               players matching a --where filter
+ *   free [--pos G|D|M|A]         out of contract players in league squads
+ *   diff PATH:N                  changes from the current save to another
+ *   edit COMMAND, set COMMAND    apply one edit script command
+ *   diff-since-load              changes made since the save was read
+ *   commit                       write the changes back
+ *   help
+ *
+ * Sessions share the cache; each one only keeps its current save. Edits
+ * are saved as they are made, unless the session is staged: then they stay
+ * in memory, with the indexes rebuilt, until commit, and diff-since-load
+ * compares with a copy of the save taken when it was read.
+ */
+class session {
+public:
+    explicit session(save_cache &cache, bool staged = false) : cache(cache), staged(staged) {}
+
+    struct command_result execute(const std::string &line);
+    const std::string &current() const { return current_spec; }
+
+    /* Staged edits not committed yet */
+    bool uncommitted();
+
+private:
+    save_cache &cache;
+    bool staged;
+    std::string current_spec;
+
+    /* The current save as read, for diff-since-load */
+    unsigned baseline_loads = 0;
+    std::unique_ptr<struct gamea> baseline_game;
+    std::unique_ptr<struct gameb> baseline_club;
+    std::unique_ptr<struct gamec> baseline_player;
+
+    void keep_baseline(struct resident_save &save);
+};
+
+#endif
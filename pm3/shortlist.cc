@@ -0,0 +1,271 @@
+#include "shortlist.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#define SQUAD_SIZE 24
+
+int64_t estimate_fee(const struct gamec::player &p) {
+    return p.contract == 0 ? 0 : (int64_t) p.wage * TRANSFER_FEE_WAGES;
+}
+
+static int squad_strength(const int16_t *squad, int count, const struct formation &f,
+                          const struct gamec &player_data) {
+    struct lineup l{};
+    pick_lineup(squad, count, f, l, player_data);
+    return l.strength;
+}
+
+std::vector<struct transfer_candidate> transfer_candidates(int club_idx, const struct formation &f, int wage_weeks,
+                                                           const struct gamea &game_data,
+                                                           const struct gameb &club_data,
+                                                           const struct gamec &player_data) {
+    std::vector<struct transfer_candidate> candidates;
+    std::vector<bool> seen(3932);
+    int16_t squad[SQUAD_SIZE];
+    int count = 0;
+
+    for (int16_t idx : club_data.club[club_idx].player_index) {
+        if (idx >= 0 && idx < 3932) {
+            squad[count++] = idx;
+            seen[idx] = true;
+        }
+    }
+
+    int base = squad_strength(squad, count, f, player_data);
+
+    auto consider = [&](int16_t idx, int16_t from, bool listed) {
+        if (idx < 0 || idx >= 3932 || seen[idx] || count == SQUAD_SIZE)
+            return;
+        seen[idx] = true;
+
+        const struct gamec::player &p = player_data.player[idx];
+        struct transfer_candidate c{idx, from, listed, estimate_fee(p), 0, 0};
+        c.cost = c.fee + (int64_t) p.wage * wage_weeks;
+
+        squad[count] = idx;
+        c.gain = squad_strength(squad, count + 1, f, player_data) - base;
+        if (c.gain > 0)
+            candidates.push_back(c);
+    };
+
+    for (const auto &listing : game_data.transfer_market)
+        consider(listing.player_idx, listing.club_idx, true);
+
+    for (int c = 0; c < 114; ++c) {
+        const struct gameb::club &club = club_data.club[c];
+        if (club.league == 0 || c == club_idx)
+            continue;
+        for (int16_t idx : club.player_index) {
+            if (idx >= 0 && idx < 3932 && player_data.player[idx].contract == 0)
+                consider(idx, (int16_t) c, false);
+        }
+    }
+
+    return candidates;
+}
+
+namespace {
+
+struct search {
+    const struct formation &f;
+    const struct gamec &player_data;
+    const std::vector<struct transfer_candidate> &candidates;
+    int64_t budget;
+    int slots;
+    uint64_t node_limit;
+
+    std::atomic<int> best_strength;
+    std::atomic<uint64_t> nodes{0};
+    std::mutex best_mutex;
+    int64_t best_cost = INT64_MAX;
+    std::vector<int> best_set;
+
+    search(const struct formation &f, const struct gamec &player_data,
+           const std::vector<struct transfer_candidate> &candidates, int64_t budget, int slots,
+           uint64_t node_limit, int base)
+            : f(f), player_data(player_data), candidates(candidates), budget(budget), slots(slots),
+              node_limit(node_limit), best_strength(base) {}
+
+    /*
+     * Single-signing gains from k on: the fractional knapsack of all of them,
+     * or the slots_left largest, whichever is less. Neither limit can be
+     * applied to the other, as the best set may skip the best value for money.
+     */
+    int bound(size_t k, int64_t budget_left, int slots_left) const {
+        double value = 0;
+        std::vector<int> gains;
+
+        for (size_t j = k; j < candidates.size(); ++j) {
+            gains.push_back(candidates[j].gain);
+            if (budget_left < 0)
+                continue;
+            if (candidates[j].cost <= budget_left) {
+                value += candidates[j].gain;
+                budget_left -= candidates[j].cost;
+            } else {
+                value += (double) candidates[j].gain * budget_left / candidates[j].cost;
+                budget_left = -1;
+            }
+        }
+
+        size_t top = std::min(gains.size(), (size_t) std::max(slots_left, 0));
+        std::nth_element(gains.begin(), gains.begin() + top, gains.end(), std::greater<int>());
+        int largest = std::accumulate(gains.begin(), gains.begin() + top, 0);
+
+        return std::min(largest, (int) value);
+    }
+
+    void offer(int strength, int64_t cost, const std::vector<int> &set) {
+        std::lock_guard<std::mutex> lock(best_mutex);
+        if (strength > best_strength || (strength == best_strength && cost < best_cost)) {
+            best_strength = strength;
+            best_cost = cost;
+            best_set = set;
+        }
+    }
+
+    /* Strength is monotone, so the squad with every remaining affordable candidate is an upper bound */
+    int pool_bound(size_t k, const int16_t *squad, int count, int64_t budget_left) const {
+        int16_t pool[LINEUP_POOL_MAX];
+        int n = std::min(count, LINEUP_POOL_MAX);
+
+        std::copy(squad, squad + n, pool);
+        for (size_t j = k; j < candidates.size() && n < LINEUP_POOL_MAX; ++j) {
+            if (candidates[j].cost <= budget_left)
+                pool[n++] = candidates[j].player_idx;
+        }
+        return squad_strength(pool, n, f, player_data);
+    }
+
+    void explore(size_t k, int16_t *squad, int count, int strength, int64_t budget_left,
+                 std::vector<int> &set) {
+        if (nodes.fetch_add(1, std::memory_order_relaxed) >= node_limit)
+            return;
+
+        int slots_left = slots - (int) set.size();
+        if (k == candidates.size() || slots_left == 0 ||
+            strength + bound(k, budget_left, slots_left) <= best_strength ||
+            pool_bound(k, squad, count, budget_left) <= best_strength)
+            return;
+
+        const struct transfer_candidate &c = candidates[k];
+        if (c.cost <= budget_left) {
+            squad[count] = c.player_idx;
+            int with = squad_strength(squad, count + 1, f, player_data);
+            set.push_back((int) k);
+            if (with > strength)
+                offer(with, budget - budget_left + c.cost, set);
+            explore(k + 1, squad, count + 1, with, budget_left - c.cost, set);
+            set.pop_back();
+        }
+
+        explore(k + 1, squad, count, strength, budget_left, set);
+    }
+};
+
+}
+
+struct shortlist plan_signings(int club_idx, const struct formation &f, const struct shortlist_options &options,
+                               const struct gamea &game_data, const struct gameb &club_data,
+                               const struct gamec &player_data) {
+    struct shortlist result{};
+    result.club_idx = club_idx;
+    int16_t squad[SQUAD_SIZE];
+    int count = 0;
+
+    for (int16_t idx : club_data.club[club_idx].player_index) {
+        if (idx >= 0 && idx < 3932)
+            squad[count++] = idx;
+    }
+    result.strength_before = squad_strength(squad, count, f, player_data);
+
+    std::vector<struct transfer_candidate> candidates =
+            transfer_candidates(club_idx, f, options.wage_weeks, game_data, club_data, player_data);
+
+    /* Best value for money first, so the knapsack bound holds and good sets are found early */
+    std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+        return (double) a.gain * b.cost > (double) b.gain * a.cost;
+    });
+
+    search s(f, player_data, candidates, options.budget, SQUAD_SIZE - count, options.node_limit,
+             result.strength_before);
+
+    /* Greedy on marginal gain gives the search a good first set to prune against */
+    {
+        int16_t greedy[SQUAD_SIZE];
+        int n = count, strength = result.strength_before;
+        int64_t spent = 0;
+        std::vector<int> set;
+        std::vector<bool> taken(candidates.size());
+
+        std::copy(squad, squad + count, greedy);
+        while (n < SQUAD_SIZE) {
+            int best = -1, best_with = strength;
+            for (size_t k = 0; k < candidates.size(); ++k) {
+                if (taken[k] || spent + candidates[k].cost > options.budget)
+                    continue;
+                greedy[n] = candidates[k].player_idx;
+                int with = squad_strength(greedy, n + 1, f, player_data);
+                if (with > best_with || (with == best_with && best != -1 && candidates[k].cost < candidates[best].cost)) {
+                    best = (int) k;
+                    best_with = with;
+                }
+            }
+            if (best == -1)
+                break;
+            taken[best] = true;
+            greedy[n++] = candidates[best].player_idx;
+            spent += candidates[best].cost;
+            strength = best_with;
+            set.push_back(best);
+        }
+        if (!set.empty())
+            s.offer(strength, spent, set);
+    }
+
+    /* Thread t takes the subtrees whose first signing is candidate t, t + threads, ... */
+    int threads = options.threads ? options.threads : (int) std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, (int) candidates.size()));
+
+    auto worker = [&](int t) {
+        int16_t local[SQUAD_SIZE];
+        std::vector<int> set;
+
+        std::copy(squad, squad + count, local);
+        for (size_t first = t; first < candidates.size(); first += threads) {
+            const struct transfer_candidate &c = candidates[first];
+            if (c.cost > options.budget || count == SQUAD_SIZE)
+                continue;
+            if (result.strength_before + c.gain + s.bound(first + 1, options.budget - c.cost, SQUAD_SIZE - count - 1)
+                <= s.best_strength)
+                continue;
+
+            local[count] = c.player_idx;
+            int with = squad_strength(local, count + 1, f, player_data);
+            set.assign(1, (int) first);
+            s.offer(with, c.cost, set);
+            s.explore(first + 1, local, count + 1, with, options.budget - c.cost, set);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back(worker, t);
+    worker(0);
+    for (std::thread &thread : pool)
+        thread.join();
+
+    result.strength_after = s.best_strength;
+    result.cost = s.best_set.empty() ? 0 : s.best_cost;
+    for (int k : s.best_set)
+        result.signings.push_back(candidates[k]);
+    result.nodes = s.nodes;
+    result.optimal = s.nodes < options.node_limit;
+
+    return result;
+}
@@ -0,0 +1,66 @@
+#ifndef SHORTLIST_H
+#define SHORTLIST_H
+
+#include <vector>
+
+#include "pm3.hh"
+#include "lineup.hh"
+
+/*
+ * The save has no asking prices, so a listed player is costed at this many
+ * weeks of wages. Players out of contract cost no fee.
+ */
+#define TRANSFER_FEE_WAGES 50
+
+struct transfer_candidate {
+    int16_t player_idx;
+    int16_t club_idx;  // current club
+    bool listed;       // on the transfer market, otherwise out of contract
+    int64_t fee;
+    int64_t cost;      // fee plus the wages counted against the budget
+    int gain;          // strength gained by signing only this player
+};
+
+struct shortlist_options {
+    int64_t budget;
+    int wage_weeks;            // weeks of wages counted against the budget
+    int threads = 0;           // 0 for one per core
+    uint64_t node_limit = 4000000;
+};
+
+struct shortlist {
+    int club_idx;
+    int strength_before;
+    int strength_after;
+    int64_t cost;
+    std::vector<struct transfer_candidate> signings;
+    uint64_t nodes;
+    bool optimal;              // false if the node limit stopped the search
+};
+
+int64_t estimate_fee(const struct gamec::player &p);
+
+/* Listed and out of contract players of other clubs that would improve the lineup */
+std::vector<struct transfer_candidate> transfer_candidates(int club_idx, const struct formation &f, int wage_weeks,
+                                                           const struct gamea &game_data = gamea,
+                                                           const struct gameb &club_data = gameb,
+                                                           const struct gamec &player_data = gamec);
+
+/*
+ * Best set of signings for the club within the budget and its free squad
+ * slots, by lineup strength.
+ *
+ * Branch and bound over the candidates. Lineup strength is an assignment
+ * value, so it is submodular in the squad: a signing never adds more than it
+ * adds on its own to the current squad. One bound is the lesser of the
+ * fractional knapsack of those single-signing gains and the sum of the
+ * largest of them that fit the free slots; the other is the strength with
+ * every remaining affordable candidate signed. A greedy pass on marginal
+ * gains provides the first set to prune against. The top level branches are
+ * shared out over threads that prune against a common best.
+ */
+struct shortlist plan_signings(int club_idx, const struct formation &f, const struct shortlist_options &options,
+                               const struct gamea &game_data = gamea, const struct gameb &club_data = gameb,
+                               const struct gamec &player_data = gamec);
+
+#endif
@@ -0,0 +1,407 @@
+#include "sidecar.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.hh"
+#include "save_hash.hh"
+#include "snapshot.hh"
+
+#define PLAYER_COUNT 3932
+#define SIDECAR_EXTENSION ".IDX"
+
+namespace {
+
+struct sidecar_header {
+    char magic[4];
+    uint16_t version;
+    uint16_t sections;
+    uint64_t length;     // of the whole file
+    uint64_t checksum;   // XXH64 of everything from the key on
+    struct sidecar_key key;
+};
+
+struct sidecar_section_entry {
+    uint32_t id;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t length;
+};
+
+#define CHECKSUMMED offsetof(struct sidecar_header, key)
+
+size_t align(size_t n) {
+    return (n + SIDECAR_ALIGN - 1) / SIDECAR_ALIGN * SIDECAR_ALIGN;
+}
+
+uint32_t trigram(const char *s) {
+    return (uint32_t) (uint8_t) s[0] << 16 | (uint32_t) (uint8_t) s[1] << 8 | (uint8_t) s[2];
+}
+
+std::string upper_name(const struct gamec::player &p) {
+    std::string name(p.name, strnlen(p.name, sizeof(p.name)));
+    for (char &c : name)
+        c = (char) toupper((unsigned char) c);
+    return name;
+}
+
+}
+
+bool stat_save_files(const std::string &game_path, int game_nr, struct sidecar_key &key) {
+    static const char letter[NUM_SAVE_FILES] = {'A', 'B', 'C'};
+
+    for (int f = 0; f < NUM_SAVE_FILES; ++f) {
+        struct stat st{};
+        if (stat(construct_save_file_path(game_path, game_nr, letter[f]).c_str(), &st) != 0)
+            return false;
+        key.size[f] = st.st_size;
+        key.mtime[f] = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    }
+    return true;
+}
+
+void hash_save_files(struct sidecar_key &key, const struct gamea &game_data, const struct gameb &club_data,
+                     const struct gamec &player_data) {
+    key.hash[SAVE_GAMEA] = hash64(&game_data, sizeof(struct gamea));
+    key.hash[SAVE_GAMEB] = hash64(&club_data, sizeof(struct gameb));
+    key.hash[SAVE_GAMEC] = hash64(&player_data, sizeof(struct gamec));
+}
+
+std::filesystem::path sidecar_path(const std::string &game_path, int game_nr) {
+    return construct_saves_folder_path(game_path) / (GAME_FILE_PREFIX + std::to_string(game_nr) + SIDECAR_EXTENSION);
+}
+
+const std::vector<const struct field_desc *> &sortable_player_fields() {
+    static const std::vector<const struct field_desc *> fields = [] {
+        std::vector<const struct field_desc *> result;
+        for (const struct field_desc &f : schema<struct gamec::player>::fields) {
+            if (is_numeric(f) && f.count == 1)
+                result.push_back(&f);
+        }
+        return result;
+    }();
+    return fields;
+}
+
+save_index::~save_index() {
+    unmap();
+}
+
+void save_index::unmap() {
+    if (mapping)
+        munmap(const_cast<uint8_t *>(mapping), mapping_size);
+    mapping = nullptr;
+    mapping_size = 0;
+    image = nullptr;
+    image_size = 0;
+}
+
+void save_index::build(const struct sidecar_key &key, const struct gamea &game_data,
+                       const struct gameb &club_data, const struct gamec &player_data) {
+    std::vector<uint8_t> section[NUM_SIDECAR_SECTIONS];
+
+    /* Ownership, the first squad a player is in */
+    std::vector<int16_t> owner(PLAYER_COUNT, -1);
+    for (int c = CLUB_IDX_MAX - 1; c >= 0; --c) {
+        for (int16_t idx : club_data.club[c].player_index) {
+            if (idx >= 0 && idx < PLAYER_COUNT)
+                owner[idx] = (int16_t) c;
+        }
+    }
+
+    /* Trigrams of the upper case names; sorting the pairs groups the postings */
+    std::vector<std::pair<uint32_t, int16_t>> pairs;
+    for (int16_t p = 0; p < PLAYER_COUNT; ++p) {
+        std::string name = upper_name(player_data.player[p]);
+        for (size_t i = 0; i + 3 <= name.size(); ++i)
+            pairs.emplace_back(trigram(name.c_str() + i), p);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    std::vector<struct trigram_entry> entries;
+    std::vector<int16_t> posting;
+    for (const std::pair<uint32_t, int16_t> &pair : pairs) {
+        if (entries.empty() || entries.back().trigram != pair.first)
+            entries.push_back({pair.first, (uint32_t) posting.size()});
+        posting.push_back(pair.second);
+    }
+    entries.push_back({UINT32_MAX, (uint32_t) posting.size()});
+
+    /* Players by descending value of each field */
+    std::vector<int16_t> order;
+    std::vector<int64_t> value(PLAYER_COUNT);
+    for (const struct field_desc *f : sortable_player_fields()) {
+        for (int p = 0; p < PLAYER_COUNT; ++p)
+            value[p] = get_field(&player_data.player[p], *f);
+        size_t first = order.size();
+        order.resize(first + PLAYER_COUNT);
+        std::iota(order.begin() + first, order.end(), 0);
+        std::stable_sort(order.begin() + first, order.end(),
+                         [&value](int16_t a, int16_t b) { return value[a] > value[b]; });
+    }
+
+    calendar cal(club_data);
+    struct save_hashes record_hashes;
+    record_hashes.compute(game_data, club_data, player_data);
+
+    auto put = [&section](sidecar_section id, const void *data, size_t length) {
+        section[id].assign(static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + length);
+    };
+    put(SIDECAR_OWNERSHIP, owner.data(), owner.size() * sizeof(int16_t));
+    put(SIDECAR_TRIGRAMS, entries.data(), entries.size() * sizeof(struct trigram_entry));
+    put(SIDECAR_POSTINGS, posting.data(), posting.size() * sizeof(int16_t));
+    put(SIDECAR_SORTED, order.data(), order.size() * sizeof(int16_t));
+    put(SIDECAR_FIXTURES, cal.all().data(), cal.all().size() * sizeof(struct fixture));
+    put(SIDECAR_SLOT_OFFSETS, cal.slot_offsets(), (TIMETABLE_SLOTS + 1) * sizeof(uint32_t));
+    put(SIDECAR_CLUB_OFFSETS, cal.club_offsets().data(), cal.club_offsets().size() * sizeof(uint32_t));
+    put(SIDECAR_CLUB_FIXTURES, cal.club_indexes().data(), cal.club_indexes().size() * sizeof(uint32_t));
+    put(SIDECAR_HASHES, record_hashes.record.data(), record_hashes.record.size() * sizeof(uint64_t));
+
+    /* Lay the image out and fill it in */
+    struct sidecar_section_entry table[NUM_SIDECAR_SECTIONS];
+    size_t length = align(sizeof(struct sidecar_header) + sizeof(table));
+    for (int s = 0; s < NUM_SIDECAR_SECTIONS; ++s) {
+        table[s] = {(uint32_t) s, 0, length, section[s].size()};
+        length = align(length + section[s].size());
+    }
+
+    unmap();
+    storage.assign(length / sizeof(uint64_t), 0);
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(storage.data());
+
+    memcpy(bytes + sizeof(struct sidecar_header), table, sizeof(table));
+    for (int s = 0; s < NUM_SIDECAR_SECTIONS; ++s) {
+        if (!section[s].empty())
+            memcpy(bytes + table[s].offset, section[s].data(), section[s].size());
+    }
+
+    struct sidecar_header header{};
+    memcpy(header.magic, SIDECAR_MAGIC, 4);
+    header.version = SIDECAR_VERSION;
+    header.sections = NUM_SIDECAR_SECTIONS;
+    header.length = length;
+    header.key = key;
+    memcpy(bytes, &header, sizeof(header));
+    header.checksum = hash64(bytes + CHECKSUMMED, length - CHECKSUMMED);
+    memcpy(bytes, &header, sizeof(header));
+
+    std::string error;
+    if (!attach(bytes, length, error))
+        throw std::logic_error("Built a broken index: " + error);
+}
+
+bool save_index::attach(const uint8_t *data, size_t size, std::string &error) {
+    struct sidecar_header header;
+    struct sidecar_section_entry table[NUM_SIDECAR_SECTIONS];
+
+    if (size < sizeof(header) + sizeof(table)) {
+        error = "truncated";
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, SIDECAR_MAGIC, 4) != 0) {
+        error = "not an index";
+        return false;
+    }
+    if (header.version != SIDECAR_VERSION || header.sections != NUM_SIDECAR_SECTIONS) {
+        error = "version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.length != size || header.checksum != hash64(data + CHECKSUMMED, size - CHECKSUMMED)) {
+        error = "checksum mismatch";
+        return false;
+    }
+
+    memcpy(table, data + sizeof(header), sizeof(table));
+    for (int s = 0; s < NUM_SIDECAR_SECTIONS; ++s) {
+        if (table[s].id != (uint32_t) s || table[s].offset % SIDECAR_ALIGN != 0 ||
+            table[s].offset > size || table[s].length > size - table[s].offset) {
+            error = "bad section " + std::to_string(s);
+            return false;
+        }
+    }
+    auto at = [&](sidecar_section s) { return data + table[s].offset; };
+    auto count = [&](sidecar_section s, size_t width) { return table[s].length / width; };
+
+    size_t trigrams_end = count(SIDECAR_TRIGRAMS, sizeof(struct trigram_entry));
+    size_t fixtures_end = count(SIDECAR_FIXTURES, sizeof(struct fixture));
+    const struct trigram_entry *last = reinterpret_cast<const struct trigram_entry *>(at(SIDECAR_TRIGRAMS)) +
+                                       trigrams_end - 1;
+    const uint32_t *club_end = reinterpret_cast<const uint32_t *>(at(SIDECAR_CLUB_OFFSETS)) + CLUB_IDX_MAX;
+
+    if (count(SIDECAR_OWNERSHIP, sizeof(int16_t)) != PLAYER_COUNT || trigrams_end == 0 ||
+        count(SIDECAR_POSTINGS, sizeof(int16_t)) != last->first ||
+        count(SIDECAR_SORTED, sizeof(int16_t)) != sortable_player_fields().size() * PLAYER_COUNT ||
+        count(SIDECAR_SLOT_OFFSETS, sizeof(uint32_t)) != TIMETABLE_SLOTS + 1 ||
+        count(SIDECAR_CLUB_OFFSETS, sizeof(uint32_t)) != CLUB_IDX_MAX + 1 ||
+        count(SIDECAR_CLUB_FIXTURES, sizeof(uint32_t)) != *club_end ||
+        count(SIDECAR_HASHES, sizeof(uint64_t)) != snapshot_layout().size()) {
+        error = "bad section size";
+        return false;
+    }
+
+    image = data;
+    image_size = size;
+    ownership = reinterpret_cast<const int16_t *>(at(SIDECAR_OWNERSHIP));
+    trigrams = reinterpret_cast<const struct trigram_entry *>(at(SIDECAR_TRIGRAMS));
+    trigram_count = trigrams_end - 1;
+    postings = reinterpret_cast<const int16_t *>(at(SIDECAR_POSTINGS));
+    sorted = reinterpret_cast<const int16_t *>(at(SIDECAR_SORTED));
+    fixtures = reinterpret_cast<const struct fixture *>(at(SIDECAR_FIXTURES));
+    fixture_count = fixtures_end;
+    slot_offsets = reinterpret_cast<const uint32_t *>(at(SIDECAR_SLOT_OFFSETS));
+    club_offsets = reinterpret_cast<const uint32_t *>(at(SIDECAR_CLUB_OFFSETS));
+    club_fixtures = reinterpret_cast<const uint32_t *>(at(SIDECAR_CLUB_FIXTURES));
+    hashes = reinterpret_cast<const uint64_t *>(at(SIDECAR_HASHES));
+    hash_count = count(SIDECAR_HASHES, sizeof(uint64_t));
+    return true;
+}
+
+bool save_index::map(const std::filesystem::path &path, std::string &error) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "missing";
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        error = "empty";
+        return false;
+    }
+
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        error = "could not map";
+        return false;
+    }
+
+    unmap();
+    storage.clear();
+    mapping = static_cast<const uint8_t *>(p);
+    mapping_size = st.st_size;
+    if (!attach(mapping, mapping_size, error)) {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void save_index::write(const std::filesystem::path &path) const {
+    if (!image)
+        throw std::logic_error("No index to write");
+
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(image), image_size);
+    out.close();
+    if (!out)
+        throw std::runtime_error("Could not write " + temporary.string());
+
+    std::filesystem::rename(temporary, path);
+}
+
+const struct sidecar_key &save_index::key() const {
+    if (!image)
+        throw std::logic_error("No index");
+    return reinterpret_cast<const struct sidecar_header *>(image)->key;
+}
+
+std::vector<int16_t> save_index::find_players(const std::string &text, const struct gamec &player_data) const {
+    std::vector<int16_t> result;
+    std::string needle(text);
+    for (char &c : needle)
+        c = (char) toupper((unsigned char) c);
+
+    auto matches = [&](int16_t p) { return upper_name(player_data.player[p]).find(needle) != std::string::npos; };
+
+    if (needle.size() < 3) {
+        for (int16_t p = 0; p < PLAYER_COUNT; ++p) {
+            if (matches(p))
+                result.push_back(p);
+        }
+        return result;
+    }
+
+    /* Every match is in the postings of each trigram of the text; check the shortest list */
+    const int16_t *first = nullptr, *last = nullptr;
+    for (size_t i = 0; i + 3 <= needle.size(); ++i) {
+        uint32_t t = trigram(needle.c_str() + i);
+        const struct trigram_entry *e = std::lower_bound(trigrams, trigrams + trigram_count, t,
+                [](const struct trigram_entry &entry, uint32_t value) { return entry.trigram < value; });
+        if (e == trigrams + trigram_count || e->trigram != t)
+            return result;
+        if (!first || e[1].first - e->first < (size_t) (last - first)) {
+            first = postings + e->first;
+            last = postings + e[1].first;
+        }
+    }
+
+    for (const int16_t *p = first; p != last; ++p) {
+        if (matches(*p))
+            result.push_back(*p);
+    }
+    return result;
+}
+
+std::vector<int16_t> save_index::top_players(const struct field_desc &field, size_t count) const {
+    const std::vector<const struct field_desc *> &fields = sortable_player_fields();
+    auto it = std::find(fields.begin(), fields.end(), &field);
+    if (it == fields.end())
+        return {};
+
+    const int16_t *list = sorted + (it - fields.begin()) * PLAYER_COUNT;
+    return std::vector<int16_t>(list, list + std::min(count, (size_t) PLAYER_COUNT));
+}
+
+void save_index::load_calendar(calendar &cal) const {
+    cal.assign(fixtures, fixture_count, slot_offsets, club_offsets, club_fixtures);
+}
+
+index_source open_save_index(save_index &index, const std::string &game_path, int game_nr, bool update,
+                             const struct gamea &game_data, const struct gameb &club_data,
+                             const struct gamec &player_data) {
+    struct sidecar_key key{};
+    bool on_disk = stat_save_files(game_path, game_nr, key);
+    bool hashed = false;
+    std::filesystem::path path = sidecar_path(game_path, game_nr);
+    std::string error;
+
+    if (on_disk && index.map(path, error)) {
+        const struct sidecar_key &old = index.key();
+
+        if (0 == memcmp(old.size, key.size, sizeof(key.size))) {
+            if (0 == memcmp(old.mtime, key.mtime, sizeof(key.mtime)))
+                return INDEX_MAPPED;
+
+            /* Touched but unchanged: still good, though worth refreshing the times */
+            hash_save_files(key, game_data, club_data, player_data);
+            hashed = true;
+            if (0 == memcmp(old.hash, key.hash, sizeof(key.hash)) && !update)
+                return INDEX_MAPPED;
+        }
+    }
+
+    if (!hashed)
+        hash_save_files(key, game_data, club_data, player_data);
+    index.build(key, game_data, club_data, player_data);
+    if (update && on_disk) {
+        index.write(path);
+        return INDEX_WRITTEN;
+    }
+    return INDEX_BUILT;
+}
@@ -0,0 +1,140 @@
+#ifndef SIDECAR_H
+#define SIDECAR_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+#include "calendar.hh"
+#include "journal.hh"
+#include "schema.hh"
+
+#define SIDECAR_MAGIC "PM3I"
+#define SIDECAR_VERSION 1
+#define SIDECAR_ALIGN 64
+
+enum sidecar_section {
+    SIDECAR_OWNERSHIP,      // int16_t club of every player, first squad, -1 for none
+    SIDECAR_TRIGRAMS,       // struct trigram_entry, sorted, one more as the end of the postings
+    SIDECAR_POSTINGS,       // int16_t players of each trigram
+    SIDECAR_SORTED,         // int16_t players by descending value, one list per sortable field
+    SIDECAR_FIXTURES,       // struct fixture
+    SIDECAR_SLOT_OFFSETS,   // uint32_t, TIMETABLE_SLOTS + 1
+    SIDECAR_CLUB_OFFSETS,   // uint32_t, CLUB_IDX_MAX + 1
+    SIDECAR_CLUB_FIXTURES,  // uint32_t
+    SIDECAR_HASHES,         // uint64_t, see save_hashes
+    NUM_SIDECAR_SECTIONS
+};
+
+/*
+ * What the index was built from. Size and modification time of the save
+ * files are checked first; when only the times differ, the content hashes
+ * decide.
+ */
+struct sidecar_key {
+    uint64_t size[NUM_SAVE_FILES];
+    int64_t mtime[NUM_SAVE_FILES];   // nanoseconds
+    uint64_t hash[NUM_SAVE_FILES];   // XXH64 of the whole file
+};
+
+struct trigram_entry {
+    uint32_t trigram;   // three upper case characters, first in the high byte
+    uint32_t first;     // into the postings
+};
+
+/* Size and time of the files of savegame N, or false if one is missing */
+bool stat_save_files(const std::string &game_path, int game_nr, struct sidecar_key &key);
+void hash_save_files(struct sidecar_key &key, const struct gamea &game_data = gamea,
+                     const struct gameb &club_data = gameb, const struct gamec &player_data = gamec);
+
+/* PATH/SAVES/GAMEn.IDX */
+std::filesystem::path sidecar_path(const std::string &game_path, int game_nr);
+
+/* Numeric single valued player fields, in schema order, that have a sorted list */
+const std::vector<const struct field_desc *> &sortable_player_fields();
+
+/*
+ * Prebuilt indexes of one savegame: the club of every player, a trigram
+ * index of player names, the players sorted by each attribute, the fixture
+ * calendar and the record hashes.
+ *
+ * The indexes live in one image laid out exactly as the sidecar file: a
+ * header with the key and an XXH64 of the key and everything after it, a
+ * table of sections, and the sections themselves at SIDECAR_ALIGN
+ * boundaries. A built index is written out as it is, and a sidecar is mapped and used in
+ * place once its header and checksum check out, without building anything.
+ */
+class save_index {
+public:
+    save_index() = default;
+    ~save_index();
+
+    save_index(const save_index &) = delete;
+    save_index &operator=(const save_index &) = delete;
+
+    void build(const struct sidecar_key &key, const struct gamea &game_data = gamea,
+               const struct gameb &club_data = gameb, const struct gamec &player_data = gamec);
+
+    /* False with the reason in error if the file is missing, of another version or corrupt */
+    bool map(const std::filesystem::path &path, std::string &error);
+    void write(const std::filesystem::path &path) const;
+
+    bool mapped() const { return mapping != nullptr; }
+    const struct sidecar_key &key() const;
+
+    int16_t owner(int player_idx) const { return ownership[player_idx]; }
+
+    /* Players whose name contains text, ignoring case, in index order */
+    std::vector<int16_t> find_players(const std::string &text, const struct gamec &player_data = gamec) const;
+
+    /* The first count players by descending value of a sortable field, ties in index order */
+    std::vector<int16_t> top_players(const struct field_desc &field, size_t count) const;
+
+    void load_calendar(calendar &cal) const;
+
+    const uint64_t *record_hashes() const { return hashes; }
+    size_t record_count() const { return hash_count; }
+
+private:
+    std::vector<uint64_t> storage;   // built image, 8 byte aligned
+    const uint8_t *mapping = nullptr;
+    size_t mapping_size = 0;
+
+    const uint8_t *image = nullptr;
+    size_t image_size = 0;
+
+    const int16_t *ownership = nullptr;
+    const struct trigram_entry *trigrams = nullptr;
+    size_t trigram_count = 0;
+    const int16_t *postings = nullptr;
+    const int16_t *sorted = nullptr;
+    const struct fixture *fixtures = nullptr;
+    size_t fixture_count = 0;
+    const uint32_t *slot_offsets = nullptr;
+    const uint32_t *club_offsets = nullptr;
+    const uint32_t *club_fixtures = nullptr;
+    const uint64_t *hashes = nullptr;
+    size_t hash_count = 0;
+
+    void unmap();
+    bool attach(const uint8_t *data, size_t size, std::string &error);
+};
+
+typedef enum {
+    INDEX_MAPPED,    // the sidecar was up to date
+    INDEX_BUILT,     // built in memory, no sidecar written
+    INDEX_WRITTEN    // built and written to the sidecar
+} index_source;
+
+/*
+ * Map the sidecar of savegame N if it matches the save files, and build the
+ * index from the loaded save otherwise. With update set, a missing or stale
+ * sidecar is replaced.
+ */
+index_source open_save_index(save_index &index, const std::string &game_path, int game_nr, bool update,
+                             const struct gamea &game_data = gamea, const struct gameb &club_data = gameb,
+                             const struct gamec &player_data = gamec);
+
+#endif
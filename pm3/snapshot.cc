@@ -0,0 +1,334 @@
+#include "snapshot.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.hh"
+#include "save_hash.hh"
+#include "schema.hh"
+
+#define INDEX_FILE "records.idx"
+#define PACK_FILE "records.pack"
+#define LOG_FILE "snapshots.log"
+
+namespace {
+
+struct index_header {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint64_t count;
+};
+
+struct log_header {
+    char magic[4];
+    uint32_t id;
+    int64_t time;
+    uint16_t year;
+    uint16_t turn;
+    uint16_t name_length;
+    uint16_t reserved;
+    uint32_t records;
+};
+
+/* Read only mapping of a whole file; data stays null for an empty file */
+class mapped_file {
+public:
+    explicit mapped_file(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Could not open file for reading: " + path);
+
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            size = st.st_size;
+            void *p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Could not map " + path);
+            }
+            data = static_cast<const uint8_t *>(p);
+        }
+        close(fd);
+    }
+
+    ~mapped_file() {
+        if (data)
+            munmap(const_cast<uint8_t *>(data), size);
+    }
+
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+};
+
+const uint8_t *record_base(save_file file, const struct gamea &game_data, const struct gameb &club_data,
+                           const struct gamec &player_data) {
+    switch (file) {
+        case SAVE_GAMEB:
+            return reinterpret_cast<const uint8_t *>(&club_data);
+        case SAVE_GAMEC:
+            return reinterpret_cast<const uint8_t *>(&player_data);
+        default:
+            return reinterpret_cast<const uint8_t *>(&game_data);
+    }
+}
+
+}
+
+const std::vector<struct snapshot_record> &snapshot_layout() {
+    static const std::vector<struct snapshot_record> layout = [] {
+        std::vector<struct snapshot_record> records;
+
+        for (const struct field_desc &f : schema<struct gamea>::fields) {
+            if (0 == strcmp(f.name, "manager")) {
+                for (int m = 0; m < f.count; ++m)
+                    records.push_back({SAVE_GAMEA, (uint32_t) (f.offset + m * f.width), f.width, f.name});
+            } else {
+                records.push_back({SAVE_GAMEA, f.offset, (uint32_t) f.width * f.count, f.name});
+            }
+        }
+        for (int c = 0; c < CLUB_IDX_MAX; ++c)
+            records.push_back({SAVE_GAMEB, (uint32_t) (c * sizeof(struct gameb::club)), sizeof(struct gameb::club),
+                               schema<struct gameb::club>::name});
+        for (int p = 0; p < 3932; ++p)
+            records.push_back({SAVE_GAMEC, (uint32_t) (p * sizeof(struct gamec::player)), sizeof(struct gamec::player),
+                               schema<struct gamec::player>::name});
+        return records;
+    }();
+    return layout;
+}
+
+snapshot_store::snapshot_store(const std::string &directory) : directory(directory) {
+    std::filesystem::create_directories(directory);
+    for (const char *name : {PACK_FILE, LOG_FILE}) {
+        std::ofstream touch(std::filesystem::path(directory) / name, std::ios::binary | std::ios::app);
+        if (!touch)
+            throw std::runtime_error("Could not create snapshot store in " + directory);
+    }
+    map_index();
+}
+
+snapshot_store::~snapshot_store() {
+    unmap_index();
+}
+
+void snapshot_store::map_index() {
+    std::string path = (std::filesystem::path(directory) / INDEX_FILE).string();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st{};
+    struct index_header header{};
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(header) ||
+        read(fd, &header, sizeof(header)) != (ssize_t) sizeof(header) ||
+        memcmp(header.magic, SNAPSHOT_INDEX_MAGIC, 4) != 0 || header.version != SNAPSHOT_VERSION ||
+        sizeof(header) + header.count * sizeof(struct snapshot_index_entry) != (size_t) st.st_size) {
+        close(fd);
+        throw std::runtime_error("Corrupt snapshot index: " + path);
+    }
+
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        throw std::runtime_error("Could not map " + path);
+
+    index_mapped = st.st_size;
+    index_count = header.count;
+    index = reinterpret_cast<const struct snapshot_index_entry *>(static_cast<const uint8_t *>(p) + sizeof(header));
+}
+
+void snapshot_store::unmap_index() {
+    if (index)
+        munmap(const_cast<uint8_t *>(reinterpret_cast<const uint8_t *>(index) - sizeof(struct index_header)),
+               index_mapped);
+    index = nullptr;
+    index_count = 0;
+    index_mapped = 0;
+}
+
+const struct snapshot_index_entry *snapshot_store::find(uint64_t hash) const {
+    const struct snapshot_index_entry *end = index + index_count;
+    const struct snapshot_index_entry *e = std::lower_bound(index, end, hash,
+            [](const struct snapshot_index_entry &entry, uint64_t h) { return entry.hash < h; });
+    return e != end && e->hash == hash ? e : nullptr;
+}
+
+uint64_t snapshot_store::pack_size() const {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(std::filesystem::path(directory) / PACK_FILE, ec);
+    return ec ? 0 : size;
+}
+
+struct snapshot_info snapshot_store::add(const std::string &name, const struct gamea &game_data,
+                                         const struct gameb &club_data, const struct gamec &player_data) {
+    const std::vector<struct snapshot_record> &layout = snapshot_layout();
+    struct save_hashes hashes;
+    std::vector<struct snapshot_index_entry> added;
+    std::unordered_set<uint64_t> seen;
+    std::filesystem::path dir(directory);
+
+    std::vector<struct snapshot_info> existing = list();
+    struct snapshot_info info{};
+    info.id = existing.empty() ? 1 : existing.back().id + 1;
+    info.time = time(nullptr);
+    info.year = game_data.year;
+    info.turn = game_data.turn;
+    info.name = name.substr(0, UINT16_MAX);
+
+    hashes.compute(game_data, club_data, player_data);
+    uint64_t pack_end = pack_size();
+    std::ofstream pack(dir / PACK_FILE, std::ios::binary | std::ios::app);
+    mapped_file old_pack((dir / PACK_FILE).string());
+
+    for (size_t i = 0; i < layout.size(); ++i) {
+        const struct snapshot_record &r = layout[i];
+        const uint8_t *bytes = record_base(r.file, game_data, club_data, player_data) + r.offset;
+        uint64_t hash = hashes.record[i];
+
+        const struct snapshot_index_entry *e = find(hash);
+        if (e) {
+            if (e->length != r.length || e->offset + e->length > old_pack.size ||
+                memcmp(old_pack.data + e->offset, bytes, r.length) != 0)
+                throw std::runtime_error("Hash collision in snapshot store, record " + std::to_string(i));
+            continue;
+        }
+        if (!seen.insert(hash).second)
+            continue;
+
+        pack.write(reinterpret_cast<const char *>(bytes), r.length);
+        added.push_back({hash, pack_end, r.length, 0});
+        pack_end += r.length;
+        info.new_bytes += r.length;
+    }
+    pack.close();
+    if (!pack)
+        throw std::runtime_error("Could not write " + (dir / PACK_FILE).string());
+    info.new_records = added.size();
+
+    /* Merge the new entries into a fresh index and swap it in */
+    if (!added.empty()) {
+        std::sort(added.begin(), added.end(), [](const struct snapshot_index_entry &a,
+                                                 const struct snapshot_index_entry &b) { return a.hash < b.hash; });
+        std::vector<struct snapshot_index_entry> merged(index_count + added.size());
+        std::merge(index, index + index_count, added.begin(), added.end(), merged.begin(),
+                   [](const struct snapshot_index_entry &a, const struct snapshot_index_entry &b) {
+                       return a.hash < b.hash;
+                   });
+
+        struct index_header header{};
+        memcpy(header.magic, SNAPSHOT_INDEX_MAGIC, 4);
+        header.version = SNAPSHOT_VERSION;
+        header.count = merged.size();
+
+        std::filesystem::path temporary = dir / (INDEX_FILE ".tmp");
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(merged.data()), merged.size() * sizeof(struct snapshot_index_entry));
+        out.close();
+        if (!out)
+            throw std::runtime_error("Could not write " + temporary.string());
+
+        unmap_index();
+        std::filesystem::rename(temporary, dir / INDEX_FILE);
+        map_index();
+    }
+
+    struct log_header header{};
+    memcpy(header.magic, SNAPSHOT_LOG_MAGIC, 4);
+    header.id = info.id;
+    header.time = info.time;
+    header.year = info.year;
+    header.turn = info.turn;
+    header.name_length = (uint16_t) info.name.size();
+    header.records = (uint32_t) hashes.record.size();
+
+    std::ofstream log(dir / LOG_FILE, std::ios::binary | std::ios::app);
+    log.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    log.write(info.name.data(), info.name.size());
+    log.write(reinterpret_cast<const char *>(hashes.record.data()), hashes.record.size() * sizeof(uint64_t));
+    log.close();
+    if (!log)
+        throw std::runtime_error("Could not write " + (dir / LOG_FILE).string());
+
+    return info;
+}
+
+std::vector<struct snapshot_info> snapshot_store::list() const {
+    std::vector<struct snapshot_info> result;
+    mapped_file log((std::filesystem::path(directory) / LOG_FILE).string());
+
+    for (size_t at = 0; at < log.size;) {
+        struct log_header header;
+        if (at + sizeof(header) > log.size)
+            throw std::runtime_error("Truncated snapshot log in " + directory);
+        memcpy(&header, log.data + at, sizeof(header));
+        if (memcmp(header.magic, SNAPSHOT_LOG_MAGIC, 4) != 0)
+            throw std::runtime_error("Corrupt snapshot log in " + directory);
+
+        size_t end = at + sizeof(header) + header.name_length + header.records * sizeof(uint64_t);
+        if (end > log.size)
+            throw std::runtime_error("Truncated snapshot log in " + directory);
+
+        struct snapshot_info info{};
+        info.id = header.id;
+        info.time = header.time;
+        info.year = header.year;
+        info.turn = header.turn;
+        info.name.assign(reinterpret_cast<const char *>(log.data + at + sizeof(header)), header.name_length);
+        result.push_back(info);
+        at = end;
+    }
+    return result;
+}
+
+void snapshot_store::restore(uint32_t id, struct gamea &game_data, struct gameb &club_data,
+                             struct gamec &player_data) const {
+    const std::vector<struct snapshot_record> &layout = snapshot_layout();
+    std::filesystem::path dir(directory);
+    mapped_file log((dir / LOG_FILE).string());
+
+    for (size_t at = 0; at + sizeof(struct log_header) <= log.size;) {
+        struct log_header header;
+        memcpy(&header, log.data + at, sizeof(header));
+        size_t hashes = at + sizeof(header) + header.name_length;
+        at = hashes + header.records * sizeof(uint64_t);
+        if (memcmp(header.magic, SNAPSHOT_LOG_MAGIC, 4) != 0 || at > log.size)
+            throw std::runtime_error("Corrupt snapshot log in " + directory);
+        if (header.id != id)
+            continue;
+        if (header.records != layout.size())
+            throw std::runtime_error("Snapshot " + std::to_string(id) + " has another record layout");
+
+        mapped_file pack((dir / PACK_FILE).string());
+        uint8_t *base[NUM_SAVE_FILES] = {
+                reinterpret_cast<uint8_t *>(&game_data),
+                reinterpret_cast<uint8_t *>(&club_data),
+                reinterpret_cast<uint8_t *>(&player_data)
+        };
+
+        for (size_t i = 0; i < layout.size(); ++i) {
+            uint64_t hash;
+            memcpy(&hash, log.data + hashes + i * sizeof(uint64_t), sizeof(hash));
+
+            const struct snapshot_index_entry *e = find(hash);
+            if (!e || e->length != layout[i].length || e->offset + e->length > pack.size ||
+                hash64(pack.data + e->offset, e->length) != hash)
+                throw std::runtime_error("Snapshot " + std::to_string(id) + " is missing record " + std::to_string(i));
+            memcpy(base[layout[i].file] + layout[i].offset, pack.data + e->offset, e->length);
+        }
+        return;
+    }
+
+    throw std::runtime_error("No snapshot " + std::to_string(id) + " in " + directory);
+}
@@ -0,0 +1,83 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+#include "journal.hh"
+
+#define SNAPSHOT_INDEX_MAGIC "PM3X"
+#define SNAPSHOT_LOG_MAGIC "PM3S"
+#define SNAPSHOT_VERSION 1
+
+/* A natural record of a savegame: a top level member of gamea, a manager, a club or a player */
+struct snapshot_record {
+    save_file file;
+    uint32_t offset;
+    uint32_t length;
+    const char *name;   // schema name of the gamea member, or club or player
+};
+
+/* Every record of a savegame in the order snapshots list their hashes */
+const std::vector<struct snapshot_record> &snapshot_layout();
+
+struct snapshot_index_entry {
+    uint64_t hash;
+    uint64_t offset;   // in the pack
+    uint32_t length;
+    uint32_t reserved;
+};
+
+struct snapshot_info {
+    uint32_t id;
+    int64_t time;
+    uint16_t year;
+    uint16_t turn;
+    std::string name;
+    size_t new_records;   // records the pack did not hold yet when added
+    size_t new_bytes;
+};
+
+/*
+ * Content addressed store of savegames in a directory.
+ *
+ * records.pack holds every distinct record once, one after another.
+ * records.idx is sorted by XXH64 of the record and is mapped as it is, so
+ * a lookup is a binary search over the file. snapshots.log lists every
+ * snapshot with the hash of each of its records. A restore maps the pack
+ * and copies the records back into place.
+ *
+ * Adding a snapshot appends its new records to the pack and then replaces
+ * the index with a merged copy, so a reader never sees an index pointing
+ * past the pack.
+ */
+class snapshot_store {
+public:
+    explicit snapshot_store(const std::string &directory);
+    ~snapshot_store();
+
+    snapshot_store(const snapshot_store &) = delete;
+    snapshot_store &operator=(const snapshot_store &) = delete;
+
+    struct snapshot_info add(const std::string &name, const struct gamea &game_data, const struct gameb &club_data,
+                             const struct gamec &player_data);
+    std::vector<struct snapshot_info> list() const;
+    void restore(uint32_t id, struct gamea &game_data, struct gameb &club_data, struct gamec &player_data) const;
+
+    size_t records() const { return index_count; }
+    uint64_t pack_size() const;
+
+private:
+    std::string directory;
+    const struct snapshot_index_entry *index = nullptr;
+    size_t index_count = 0;
+    size_t index_mapped = 0;
+
+    void map_index();
+    void unmap_index();
+    const struct snapshot_index_entry *find(uint64_t hash) const;
+};
+
+#endif
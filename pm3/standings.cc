@@ -0,0 +1,99 @@
+#include "standings.hh"
+
+#include <algorithm>
+
+static const char *column_name[] = { "hw", "hd", "hl", "hf", "ha", "aw", "ad", "al", "af", "aa" };
+
+bool is_league_match(uint8_t type) {
+    /* 0-4 league matches per division, 5-9 the same matches when delayed */
+    return type < 10;
+}
+
+void standings::compute(const struct gamea &game_data, const calendar &cal) {
+    for (int c = 0; c < NUM_COLUMNS; ++c)
+        std::fill(column[c], column[c] + CLUB_IDX_MAX, 0);
+    std::fill(club_division, club_division + CLUB_IDX_MAX, -1);
+
+    for (int div = 0; div < 5; ++div) {
+        for (int i = division_offset[div]; i < division_offset[div + 1]; ++i) {
+            int16_t idx = game_data.club_index.all[i];
+            if (idx >= 0 && idx < CLUB_IDX_MAX)
+                club_division[idx] = div;
+        }
+    }
+
+    for (const struct fixture &f : cal.all()) {
+        if (!f.played() || !is_league_match(f.type))
+            continue;
+        if (club_division[f.home_idx] == -1 || club_division[f.home_idx] != club_division[f.away_idx])
+            continue;
+
+        int h = f.home_idx, a = f.away_idx;
+        int hg = f.home_goals, ag = f.away_goals;
+
+        column[HW][h] += hg > ag;
+        column[HD][h] += hg == ag;
+        column[HL][h] += hg < ag;
+        column[HF][h] += hg;
+        column[HA][h] += ag;
+
+        column[AW][a] += ag > hg;
+        column[AD][a] += ag == hg;
+        column[AL][a] += ag < hg;
+        column[AF][a] += ag;
+        column[AA][a] += hg;
+    }
+
+    for (int div = 0; div < 5; ++div) {
+        std::vector<struct standing> &table = tables[div];
+        table.clear();
+
+        for (int i = division_offset[div]; i < division_offset[div + 1]; ++i) {
+            int16_t idx = game_data.club_index.all[i];
+            if (idx < 0 || idx >= CLUB_IDX_MAX)
+                continue;
+
+            struct standing s{};
+            s.club_idx = idx;
+            s.division = div;
+            s.hw = column[HW][idx]; s.hd = column[HD][idx]; s.hl = column[HL][idx];
+            s.hf = column[HF][idx]; s.ha = column[HA][idx];
+            s.aw = column[AW][idx]; s.ad = column[AD][idx]; s.al = column[AL][idx];
+            s.af = column[AF][idx]; s.aa = column[AA][idx];
+            table.push_back(s);
+        }
+
+        std::stable_sort(table.begin(), table.end(), [](const struct standing &a, const struct standing &b) {
+            if (a.points() != b.points())
+                return a.points() > b.points();
+            if (a.goal_difference() != b.goal_difference())
+                return a.goal_difference() > b.goal_difference();
+            return a.goals_for() > b.goals_for();
+        });
+
+        for (size_t i = 0; i < table.size(); ++i)
+            table[i].position = i + 1;
+    }
+}
+
+std::vector<struct table_mismatch> standings::cross_check(const struct gamea &game_data) const {
+    std::vector<struct table_mismatch> mismatches;
+
+    for (int i = 0; i < 114; ++i) {
+        const auto &row = game_data.table.all[i];
+        if (row.club_idx < 0 || row.club_idx >= CLUB_IDX_MAX)
+            continue;
+
+        const int16_t stored[NUM_COLUMNS] = {
+                row.hw, row.hd, row.hl, row.hf, row.ha,
+                row.aw, row.ad, row.al, row.af, row.aa
+        };
+
+        for (int c = 0; c < NUM_COLUMNS; ++c) {
+            if (stored[c] != column[c][row.club_idx])
+                mismatches.push_back({row.club_idx, column_name[c], stored[c], column[c][row.club_idx]});
+        }
+    }
+
+    return mismatches;
+}
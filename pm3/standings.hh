@@ -0,0 +1,66 @@
+#ifndef STANDINGS_H
+#define STANDINGS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "pm3.hh"
+#include "calendar.hh"
+
+#define POINTS_FOR_WIN 3
+#define POINTS_FOR_DRAW 1
+
+struct standing {
+    int16_t club_idx;
+    uint8_t division;
+    uint8_t position; // 1-based, after ranking
+
+    int16_t hw, hd, hl, hf, ha;
+    int16_t aw, ad, al, af, aa;
+
+    int played() const { return hw + hd + hl + aw + ad + al; }
+    int won() const { return hw + aw; }
+    int drawn() const { return hd + ad; }
+    int lost() const { return hl + al; }
+    int goals_for() const { return hf + af; }
+    int goals_against() const { return ha + aa; }
+    int goal_difference() const { return goals_for() - goals_against(); }
+    int points() const { return POINTS_FOR_WIN * won() + POINTS_FOR_DRAW * drawn(); }
+};
+
+struct table_mismatch {
+    int16_t club_idx;
+    const char *column;
+    int16_t stored;
+    int16_t computed;
+};
+
+/*
+ * League tables recomputed from the played league fixtures of the calendar.
+ * Results are accumulated column-wise per club in a single pass over the
+ * fixtures, then ranked by points, goal difference and goals scored.
+ */
+class standings {
+public:
+    standings() = default;
+    standings(const struct gamea &game_data, const calendar &cal) { compute(game_data, cal); }
+
+    void compute(const struct gamea &game_data, const calendar &cal);
+
+    /* Ranked table of one division (0 = Premier League ... 4 = Conference League). */
+    const std::vector<struct standing> &division(int div) const { return tables[div]; }
+
+    /* Differences between the recomputed results and gamea.table. */
+    std::vector<struct table_mismatch> cross_check(const struct gamea &game_data) const;
+
+private:
+    enum { HW, HD, HL, HF, HA, AW, AD, AL, AF, AA, NUM_COLUMNS };
+
+    int16_t column[NUM_COLUMNS][CLUB_IDX_MAX] = {};
+    int8_t club_division[CLUB_IDX_MAX] = {};
+    std::vector<struct standing> tables[5];
+};
+
+bool is_league_match(uint8_t type);
+
+#endif
@@ -0,0 +1,221 @@
+#include "transform.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#define PLAYER_IDX_MAX 3932
+
+std::vector<int16_t> select_players(const struct player_filter &filter,
+                                    const struct gamea &game_data, const struct gameb &club_data,
+                                    struct gamec &player_data) {
+    int8_t club_division[CLUB_IDX_MAX];
+    int16_t player_club[PLAYER_IDX_MAX];
+    std::vector<int16_t> players;
+
+    std::fill(club_division, club_division + CLUB_IDX_MAX, -1);
+    for (int div = 0; div < 5; ++div) {
+        for (int i = division_offset[div]; i < division_offset[div + 1]; ++i) {
+            int16_t idx = game_data.club_index.all[i];
+            if (idx >= 0 && idx < CLUB_IDX_MAX)
+                club_division[idx] = (int8_t) div;
+        }
+    }
+
+    std::fill(player_club, player_club + PLAYER_IDX_MAX, -1);
+    for (int c = CLUB_IDX_MAX - 1; c >= 0; --c) {
+        for (int16_t idx : club_data.club[c].player_index) {
+            if (idx >= 0 && idx < PLAYER_IDX_MAX)
+                player_club[idx] = (int16_t) c;
+        }
+    }
+
+    for (int16_t i = 0; i < PLAYER_IDX_MAX; ++i) {
+        struct gamec::player &p = player_data.player[i];
+        int club = player_club[i];
+
+        if (filter.club_idx != -1 && club != filter.club_idx)
+            continue;
+        if (filter.division != -1 && (club == -1 || club_division[club] != filter.division))
+            continue;
+        if (p.age < filter.min_age || p.age > filter.max_age)
+            continue;
+        if (p.contract < filter.min_contract || p.contract > filter.max_contract)
+            continue;
+        if (filter.position && determine_player_type(p) != filter.position)
+            continue;
+
+        players.push_back(i);
+    }
+
+    return players;
+}
+
+static void transform_column(int64_t *column, size_t n, const struct player_transform &t, int64_t lo, int64_t hi) {
+    switch (t.op) {
+        case TRANSFORM_SET: {
+            int64_t v = std::min(std::max((int64_t) llround(t.a), lo), hi);
+            std::fill(column, column + n, v);
+            break;
+        }
+        case TRANSFORM_ADD: {
+            int64_t a = (int64_t) llround(t.a);
+            for (size_t i = 0; i < n; ++i)
+                column[i] = std::min(std::max(column[i] + a, lo), hi);
+            break;
+        }
+        case TRANSFORM_SCALE: {
+            double dlo = (double) lo, dhi = (double) hi;
+            for (size_t i = 0; i < n; ++i)
+                column[i] = (int64_t) std::floor(std::min(std::max((double) column[i] * t.a, dlo), dhi) + 0.5);
+            break;
+        }
+        case TRANSFORM_CLAMP: {
+            int64_t a = std::max((int64_t) llround(t.a), lo), b = std::min((int64_t) llround(t.b), hi);
+            for (size_t i = 0; i < n; ++i)
+                column[i] = std::min(std::max(column[i], a), b);
+            break;
+        }
+    }
+}
+
+void transform_players(const std::vector<int16_t> &players, const std::vector<struct player_transform> &transforms,
+                       edit_journal *journal, struct gamec &player_data) {
+    std::vector<int64_t> column(players.size());
+
+    for (const struct player_transform &t : transforms) {
+        const struct field_desc &f = *t.field;
+
+        for (size_t i = 0; i < players.size(); ++i)
+            column[i] = get_field(&player_data.player[players[i]], f);
+
+        transform_column(column.data(), column.size(), t, field_min(f), field_max(f));
+
+        for (size_t i = 0; i < players.size(); ++i) {
+            struct gamec::player &p = player_data.player[players[i]];
+            if (journal)
+                journal->touch(reinterpret_cast<uint8_t *>(&p) + f.offset, f.width);
+            set_field(&p, f, column[i]);
+        }
+    }
+}
+
+static bool parse_range(const std::string &value, int lo, int hi, int &min, int &max) {
+    char *end;
+    min = (int) strtol(value.c_str(), &end, 10);
+    max = min;
+    if (*end == '-')
+        max = (int) strtol(end + 1, &end, 10);
+    return !value.empty() && !*end && min >= lo && max <= hi && min <= max;
+}
+
+bool parse_player_filter(const std::string &spec, struct player_filter &filter, std::string &error) {
+    size_t start = 0;
+
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos)
+            end = spec.size();
+
+        std::string term = spec.substr(start, end - start);
+        size_t eq = term.find('=');
+        std::string key = term.substr(0, eq), value = eq == std::string::npos ? "" : term.substr(eq + 1);
+        int min, max;
+        bool ok;
+
+        if (key == "club") {
+            ok = parse_range(value, 0, CLUB_IDX_MAX - 1, min, max) && min == max;
+            filter.club_idx = min;
+        } else if (key == "division") {
+            ok = parse_range(value, 0, 4, min, max) && min == max;
+            filter.division = min;
+        } else if (key == "position") {
+            ok = value == "G" || value == "D" || value == "M" || value == "A";
+            filter.position = ok ? value[0] : 0;
+        } else if (key == "age") {
+            ok = parse_range(value, 0, 63, filter.min_age, filter.max_age);
+        } else if (key == "contract") {
+            ok = parse_range(value, 0, 7, filter.min_contract, filter.max_contract);
+        } else {
+            error = "unknown filter " + key;
+            return false;
+        }
+
+        if (!ok) {
+            error = "bad filter " + term;
+            return false;
+        }
+        start = end + 1;
+    }
+
+    return true;
+}
+
+bool parse_player_transforms(const std::string &spec, std::vector<struct player_transform> &transforms,
+                             std::string &error) {
+    size_t start = 0;
+
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos)
+            end = spec.size();
+
+        std::string term = spec.substr(start, end - start);
+        size_t op = term.find_first_of("=+*:");
+        if (op == std::string::npos) {
+            error = "bad transform " + term;
+            return false;
+        }
+
+        struct player_transform t{};
+        t.field = find_field<struct gamec::player>(term.substr(0, op));
+        if (!t.field || !is_numeric(*t.field) || t.field->count != 1) {
+            error = "unknown player field " + term.substr(0, op);
+            return false;
+        }
+
+        const char *value = term.c_str() + op + 1;
+        char *rest;
+        t.a = strtod(value, &rest);
+        switch (term[op]) {
+            case '=': t.op = TRANSFORM_SET; break;
+            case '+': t.op = TRANSFORM_ADD; break;
+            case '*': t.op = TRANSFORM_SCALE; break;
+            default:
+                t.op = TRANSFORM_CLAMP;
+                if (*rest == '-')
+                    t.b = strtod(rest + 1, &rest);
+                else
+                    rest = (char *) value;
+                break;
+        }
+
+        if (rest == value || *rest || (t.op == TRANSFORM_CLAMP && t.a > t.b)) {
+            error = "bad transform " + term;
+            return false;
+        }
+
+        /* Values are set and clamped to within the field; adding or scaling by more than its span is no use */
+        double lo = (double) field_min(*t.field), hi = (double) field_max(*t.field), span = hi - lo;
+        bool in_range;
+        switch (t.op) {
+            case TRANSFORM_SET:   in_range = t.a >= lo && t.a <= hi; break;
+            case TRANSFORM_CLAMP: in_range = t.a >= lo && t.b <= hi; break;
+            default:              in_range = t.a >= -span && t.a <= span; break;
+        }
+        if (!std::isfinite(t.a) || !std::isfinite(t.b)) {
+            error = "transform " + term + " is not a finite number";
+            return false;
+        }
+        if (!in_range) {
+            error = "transform " + term + " is out of range, " + t.field->name + " is " +
+                    std::to_string(field_min(*t.field)) + " to " + std::to_string(field_max(*t.field));
+            return false;
+        }
+
+        transforms.push_back(t);
+        start = end + 1;
+    }
+
+    return true;
+}
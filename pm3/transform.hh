@@ -0,0 +1,60 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+#include "schema.hh"
+#include "journal.hh"
+
+typedef enum {
+    TRANSFORM_SET,   // field = a
+    TRANSFORM_ADD,   // field += a
+    TRANSFORM_SCALE, // field *= a, rounded
+    TRANSFORM_CLAMP  // a <= field <= b
+} transform_op;
+
+/* Results are saturated to the range of the field. */
+struct player_transform {
+    const struct field_desc *field;
+    transform_op op;
+    double a;
+    double b;
+};
+
+/* -1 (or the full range) matches everything. */
+struct player_filter {
+    int club_idx = -1;
+    int division = -1;
+    char position = 0;  // G, D, M or A as in determine_player_type
+    int min_age = 0, max_age = 63;
+    int min_contract = 0, max_contract = 7;
+};
+
+/*
+ * Players matching the filter, in index order. Club and division refer to the
+ * first squad a player is in; players without a club only match when neither
+ * is set.
+ */
+std::vector<int16_t> select_players(const struct player_filter &filter,
+                                    const struct gamea &game_data = gamea, const struct gameb &club_data = gameb,
+                                    struct gamec &player_data = gamec);
+
+/*
+ * Apply the transforms in order to the selected players. Each field is
+ * gathered into a contiguous column, transformed in a branch-free loop the
+ * compiler can vectorize, and scattered back into the packed records.
+ */
+void transform_players(const std::vector<int16_t> &players, const std::vector<struct player_transform> &transforms,
+                       edit_journal *journal = nullptr, struct gamec &player_data = gamec);
+
+/*
+ * Parse "club=5,division=0,position=D,age=18-25,contract=0-1" and
+ * "hn+5,tk*1.1,aggr=5,ft:10-90" (add, scale, set, clamp; hn+-5 subtracts).
+ */
+bool parse_player_filter(const std::string &spec, struct player_filter &filter, std::string &error);
+bool parse_player_transforms(const std::string &spec, std::vector<struct player_transform> &transforms,
+                             std::string &error);
+
+#endif
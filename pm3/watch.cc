@@ -0,0 +1,317 @@
+#include "watch.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "journal.hh"
+#include "sidecar.hh"
+
+#define ALL_FILES ((1u << NUM_SAVE_FILES) - 1)
+#define PLAYER_COUNT 3932
+#define LEAGUE_CLUBS 114
+
+namespace {
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* First squad of every player, as select_players takes it */
+void squads(const struct gameb &club_data, int16_t owner[PLAYER_COUNT]) {
+    std::fill(owner, owner + PLAYER_COUNT, -1);
+    for (int c = CLUB_IDX_MAX - 1; c >= 0; --c) {
+        for (int16_t idx : club_data.club[c].player_index) {
+            if (idx >= 0 && idx < PLAYER_COUNT)
+                owner[idx] = (int16_t) c;
+        }
+    }
+}
+
+/* As find_free_players */
+bool free_agent(const struct gameb &club_data, const struct gamec::player &p, int16_t club_idx) {
+    return club_idx >= 0 && club_idx < LEAGUE_CLUBS && club_data.club[club_idx].league != 0 && p.contract == 0;
+}
+
+/* Concussion to Cracked Skull */
+bool injured(const struct gamec::player &p) {
+    return p.period > 0 && p.period_type >= 2 && p.period_type <= 17;
+}
+
+std::string text(const char *s, size_t width) {
+    return std::string(s, strnlen(s, width));
+}
+
+}
+
+save_watcher::save_watcher() {
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0)
+        throw std::runtime_error(std::string("Could not start inotify: ") + strerror(errno));
+}
+
+save_watcher::~save_watcher() {
+    if (inotify_fd >= 0)
+        close(inotify_fd);
+}
+
+size_t save_watcher::add_root(const std::string &root) {
+    if (get_pm3_game_type(root.c_str()) != PM3_UNKNOWN) {
+        watch_install(root);
+        return 1;
+    }
+
+    size_t count = 0;
+    std::filesystem::recursive_directory_iterator it(root, std::filesystem::directory_options::skip_permission_denied);
+    for (; it != std::filesystem::recursive_directory_iterator(); ++it) {
+        if (it.depth() >= 1)
+            it.disable_recursion_pending();
+        if (!it->is_directory() || get_pm3_game_type(it->path().c_str()) == PM3_UNKNOWN)
+            continue;
+
+        watch_install(it->path().string());
+        it.disable_recursion_pending();
+        ++count;
+    }
+    return count;
+}
+
+void save_watcher::watch_install(const std::string &game_path) {
+    std::filesystem::path folder = construct_saves_folder_path(game_path);
+    int wd = inotify_add_watch(inotify_fd, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0)
+        throw std::runtime_error("Could not watch " + folder.string() + ": " + strerror(errno));
+    installs[wd] = game_path;
+
+    /* The saves as they are now are what the first writes are compared with */
+    std::vector<struct watch_event> ignored;
+    for (int nr = 1; nr <= 8; ++nr) {
+        struct slot &s = slots[game_path + ":" + std::to_string(nr)];
+        s.game_path = game_path;
+        s.game_nr = nr;
+        if (std::filesystem::exists(construct_save_file_path(game_path, nr, 'A')))
+            reload(s, ignored);
+    }
+}
+
+int save_watcher::timeout() const {
+    int64_t now = now_ms();
+    int64_t next = INT64_MAX;
+
+    for (const auto &entry : slots) {
+        const struct slot &s = entry.second;
+        if (s.written)
+            next = std::min(next, s.last_write + (s.written == ALL_FILES ? WATCH_SETTLE_MS : WATCH_PARTIAL_MS));
+    }
+    return next == INT64_MAX ? -1 : (int) std::max<int64_t>(0, next - now);
+}
+
+std::vector<struct watch_event> save_watcher::read() {
+    alignas(struct inotify_event) char buffer[4096];
+    std::vector<struct watch_event> events;
+    int64_t now = now_ms();
+
+    for (;;) {
+        ssize_t length = ::read(inotify_fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (char *p = buffer; p < buffer + length;) {
+            const struct inotify_event *e = reinterpret_cast<const struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + e->len;
+
+            /* Events were lost, so look at every slot again */
+            if (e->mask & IN_Q_OVERFLOW) {
+                for (auto &entry : slots) {
+                    entry.second.written = ALL_FILES;
+                    entry.second.last_write = now;
+                }
+                continue;
+            }
+
+            auto install = installs.find(e->wd);
+            if (install == installs.end() || e->len == 0)
+                continue;
+
+            /* GAMEnA, GAMEnB or GAMEnC; nothing else in the folder matters, the sidecars included */
+            const char *name = e->name;
+            size_t prefix = strlen(GAME_FILE_PREFIX);
+            if (strlen(name) != prefix + 2 || strncmp(name, GAME_FILE_PREFIX, prefix) != 0 ||
+                name[prefix] < '1' || name[prefix] > '8' || name[prefix + 1] < 'A' || name[prefix + 1] > 'C')
+                continue;
+
+            struct slot &s = slots[install->second + ":" + name[prefix]];
+            s.written |= 1u << (name[prefix + 1] - 'A');
+            s.last_write = now;
+        }
+    }
+
+    for (auto &entry : slots) {
+        struct slot &s = entry.second;
+        if (!s.written || now - s.last_write < (s.written == ALL_FILES ? WATCH_SETTLE_MS : WATCH_PARTIAL_MS))
+            continue;
+
+        s.written = 0;
+        reload(s, events);
+    }
+    return events;
+}
+
+bool save_watcher::reload(struct slot &s, std::vector<struct watch_event> &events) {
+    std::string spec = s.game_path + ":" + std::to_string(s.game_nr);
+    std::unique_ptr<struct gamea> game_data = std::make_unique<struct gamea>();
+    std::unique_ptr<struct gameb> club_data = std::make_unique<struct gameb>();
+    std::unique_ptr<struct gamec> player_data = std::make_unique<struct gamec>();
+    std::string error;
+
+    if (!load_save_spec(spec, *game_data, *club_data, *player_data, error))
+        return false;
+
+    struct save_hashes hashes;
+    hashes.compute(*game_data, *club_data, *player_data);
+
+    struct watch_event save{};
+    save.type = WATCH_SAVE;
+    save.spec = spec;
+    save.year = game_data->year;
+    save.turn = game_data->turn;
+    save.player_idx = -1;
+    save.from_club_idx = -1;
+    save.club_idx = -1;
+
+    std::vector<size_t> changed = s.loaded ? hashes.changed(s.hashes) : std::vector<size_t>();
+    save.changed = s.loaded ? changed.size() : hashes.record.size();
+    events.push_back(save);
+
+    if (s.loaded && !changed.empty()) {
+        int16_t before[PLAYER_COUNT], after[PLAYER_COUNT];
+        size_t first_club = hashes.gamea_records;
+        size_t first_player = first_club + CLUB_IDX_MAX;
+        std::vector<int16_t> players;
+
+        /* Squads only move when a club record changed */
+        bool squads_changed = std::any_of(changed.begin(), changed.end(), [&](size_t r) {
+            return r >= first_club && r < first_player;
+        });
+        squads(*s.club_data, before);
+        if (squads_changed)
+            squads(*club_data, after);
+        else
+            std::copy(before, before + PLAYER_COUNT, after);
+
+        for (size_t r : changed) {
+            if (r >= first_player)
+                players.push_back((int16_t) (r - first_player));
+        }
+        for (int16_t p = 0; squads_changed && p < PLAYER_COUNT; ++p) {
+            if (before[p] != after[p])
+                players.push_back(p);
+        }
+        std::sort(players.begin(), players.end());
+        players.erase(std::unique(players.begin(), players.end()), players.end());
+
+        for (int16_t p : players) {
+            const struct gamec::player &old_player = s.player_data->player[p];
+            const struct gamec::player &new_player = player_data->player[p];
+
+            struct watch_event e = save;
+            e.changed = 0;
+            e.player_idx = p;
+            e.player = text(new_player.name, sizeof(new_player.name));
+            e.from_club_idx = before[p];
+            e.club_idx = after[p];
+            if (before[p] >= 0)
+                e.from_club = text(s.club_data->club[before[p]].name, sizeof(s.club_data->club[before[p]].name));
+            if (after[p] >= 0)
+                e.club = text(club_data->club[after[p]].name, sizeof(club_data->club[after[p]].name));
+
+            if (before[p] != after[p]) {
+                e.type = WATCH_TRANSFER;
+                events.push_back(e);
+            }
+            if (free_agent(*club_data, new_player, after[p]) && !free_agent(*s.club_data, old_player, before[p])) {
+                e.type = WATCH_FREE_AGENT;
+                events.push_back(e);
+            }
+            if (injured(new_player) && (!injured(old_player) || old_player.period_type != new_player.period_type)) {
+                e.type = WATCH_INJURY;
+                e.injury = period_types[new_player.period_type];
+                e.weeks = (new_player.period + TIMETABLE_DAYS - 1) / TIMETABLE_DAYS;
+                events.push_back(e);
+            }
+        }
+    }
+
+    /* A sidecar that cannot be rewritten is rebuilt by its next reader; the events still stand */
+    if (std::filesystem::exists(sidecar_path(s.game_path, s.game_nr))) {
+        try {
+            save_index index;
+            open_save_index(index, s.game_path, s.game_nr, true, *game_data, *club_data, *player_data);
+        } catch (const std::exception &e) {
+            fprintf(stderr, "Could not update the index of %s:%d: %s\n", s.game_path.c_str(), s.game_nr, e.what());
+        }
+    }
+
+    s.game_data = std::move(game_data);
+    s.club_data = std::move(club_data);
+    s.player_data = std::move(player_data);
+    s.hashes = std::move(hashes);
+    s.loaded = true;
+    return true;
+}
+
+event_socket::event_socket(const std::string &path) : path(path) {
+    struct sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path))
+        throw std::runtime_error("Socket path too long: " + path);
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+        throw std::runtime_error(std::string("Could not create socket: ") + strerror(errno));
+
+    unlink(path.c_str());
+    if (bind(listen_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd, 16) != 0) {
+        std::string reason = strerror(errno);
+        close(listen_fd);
+        throw std::runtime_error("Could not listen on " + path + ": " + reason);
+    }
+}
+
+event_socket::~event_socket() {
+    for (int fd : client_fds)
+        close(fd);
+    close(listen_fd);
+    unlink(path.c_str());
+}
+
+void event_socket::accept_clients() {
+    int fd;
+    while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+        client_fds.push_back(fd);
+}
+
+void event_socket::send(const std::string &line) {
+    for (size_t i = 0; i < client_fds.size();) {
+        ssize_t sent = ::send(client_fds[i], line.data(), line.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent == (ssize_t) line.size()) {
+            ++i;
+            continue;
+        }
+        close(client_fds[i]);
+        client_fds.erase(client_fds.begin() + i);
+    }
+}
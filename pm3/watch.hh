@@ -0,0 +1,115 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pm3.hh"
+#include "save_hash.hh"
+
+/* Quiet time after the last of GAMEnA, B and C is written, or after any of them if not all are */
+#define WATCH_SETTLE_MS 200
+#define WATCH_PARTIAL_MS 2000
+
+typedef enum {
+    WATCH_SAVE,         // a savegame was written
+    WATCH_TRANSFER,     // a player changed squads
+    WATCH_FREE_AGENT,   // a player in a league squad is out of contract
+    WATCH_INJURY        // a player picked up an injury
+} watch_event_type;
+
+struct watch_event {
+    watch_event_type type;
+    std::string spec;           // PATH:N
+    uint16_t year;
+    uint16_t turn;
+    size_t changed;             // records, for WATCH_SAVE
+    int16_t player_idx;         // -1 for WATCH_SAVE
+    std::string player;
+    int16_t from_club_idx;      // -1 for none
+    int16_t club_idx;           // -1 for none
+    std::string from_club;
+    std::string club;
+    const char *injury;         // period_types[] of WATCH_INJURY
+    int weeks;
+};
+
+/*
+ * Watches the saves folders of PM3 installs through inotify and turns the
+ * writes of the game into events.
+ *
+ * The game writes GAMEnA, GAMEnB and GAMEnC one after another. A slot is
+ * reloaded once all three have been written and the folder has been quiet
+ * for WATCH_SETTLE_MS, or WATCH_PARTIAL_MS after a partial write. The record
+ * hashes of the new save are compared with those of the last one, and only
+ * changed players are looked at for events. A sidecar index of the slot, if
+ * there is one, is brought up to date.
+ */
+class save_watcher {
+public:
+    save_watcher();
+    ~save_watcher();
+
+    save_watcher(const save_watcher &) = delete;
+    save_watcher &operator=(const save_watcher &) = delete;
+
+    /* Watch root if it is an install, or else the installs up to two levels below it; returns their number */
+    size_t add_root(const std::string &root);
+
+    int fd() const { return inotify_fd; }
+
+    /* Milliseconds until the next written slot settles, -1 if there is none */
+    int timeout() const;
+
+    /* Take in what inotify has queued and return the events of the slots that settled */
+    std::vector<struct watch_event> read();
+
+private:
+    struct slot {
+        std::string game_path;
+        int game_nr;
+        unsigned written = 0;       // bit per save_file since the last reload
+        int64_t last_write = 0;     // milliseconds, steady clock
+        bool loaded = false;
+        std::unique_ptr<struct gamea> game_data;
+        std::unique_ptr<struct gameb> club_data;
+        std::unique_ptr<struct gamec> player_data;
+        struct save_hashes hashes;
+    };
+
+    int inotify_fd = -1;
+    std::map<int, std::string> installs;   // by watch descriptor
+    std::map<std::string, struct slot> slots;   // by PATH:N
+
+    void watch_install(const std::string &game_path);
+    bool reload(struct slot &s, std::vector<struct watch_event> &events);
+};
+
+/*
+ * Listening Unix socket that hands every line sent to all connected
+ * clients. Clients only read; one that stops reading or hangs up is
+ * dropped.
+ */
+class event_socket {
+public:
+    explicit event_socket(const std::string &path);
+    ~event_socket();
+
+    event_socket(const event_socket &) = delete;
+    event_socket &operator=(const event_socket &) = delete;
+
+    int fd() const { return listen_fd; }
+    void accept_clients();
+    void send(const std::string &line);
+    size_t clients() const { return client_fds.size(); }
+
+private:
+    std::string path;
+    int listen_fd = -1;
+    std::vector<int> client_fds;
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Cross-checks pick_lineup against an exhaustive search over small random
+ * pools: every way of giving each player a role of the formation, or none.
+ */
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "lineup.hh"
+
+#define POOL_MAX 16
+#define FITNESS_SCALE 2048
+
+static const char roles[] = "GDMA";
+
+static long long weight(const struct gamec::player &p, char role) {
+    return role_rating(p, role) * FITNESS_SCALE + std::min<int>(p.ft, 127);
+}
+
+struct search {
+    const struct gamec &player_data;
+    const std::vector<int16_t> &pool;
+    std::vector<long long> memo;    // by player and the slots of each role left open
+
+    search(const struct gamec &player_data, const std::vector<int16_t> &pool)
+            : player_data(player_data), pool(pool), memo((POOL_MAX + 1) * 12 * 12 * 12 * 12, LLONG_MIN) {}
+
+    long long best_weight(size_t i, int need[4]);
+};
+
+/* Largest total weight of the players from i on in the open slots, -1 if they cannot fill them */
+long long search::best_weight(size_t i, int need[4]) {
+    if (need[0] + need[1] + need[2] + need[3] == 0)
+        return 0;
+    if (i == pool.size())
+        return -1;
+    long long &memoized = memo[(((i * 12 + need[0]) * 12 + need[1]) * 12 + need[2]) * 12 + need[3]];
+    if (memoized != LLONG_MIN)
+        return memoized;
+
+    long long best = best_weight(i + 1, need);
+    for (int r = 0; r < 4; ++r) {
+        if (!need[r])
+            continue;
+        --need[r];
+        long long rest = best_weight(i + 1, need);
+        ++need[r];
+        if (rest >= 0)
+            best = std::max(best, rest + weight(player_data.player[pool[i]], roles[r]));
+    }
+    return memoized = best;
+}
+
+int main() {
+    std::unique_ptr<struct gamec> player_data = std::make_unique<struct gamec>();
+    std::mt19937 rng(35);
+    const char *formations[] = {"4-4-2", "3-5-2", "5-3-2", "4-3-3", "3-4-3"};
+    int failures = 0;
+
+    for (int round = 0; round < 500; ++round) {
+        struct formation f;
+        parse_formation(formations[round % 5], f);
+
+        int count = (int) (rng() % POOL_MAX) + 1;
+        std::vector<int16_t> squad(count);
+        std::vector<int16_t> available;
+        for (int i = 0; i < count; ++i) {
+            squad[i] = (int16_t) (round % 200 * POOL_MAX + i);
+            struct gamec::player &p = player_data->player[squad[i]];
+            memset(&p, 0, sizeof(p));
+            /* Few distinct ratings, so that ties and fitness decide often */
+            p.hn = (uint8_t) (rng() % 5 * 20);
+            p.tk = (uint8_t) (rng() % 5 * 20);
+            p.ps = (uint8_t) (rng() % 5 * 20);
+            p.sh = (uint8_t) (rng() % 5 * 20);
+            p.ft = (uint8_t) (rng() % 150);
+            if (rng() % 8 == 0)
+                p.period = 3;
+            if (player_available(p))
+                available.push_back(squad[i]);
+        }
+
+        struct lineup result;
+        pick_lineup(squad.data(), count, f, result, *player_data);
+
+        /* A short squad fills as many slots as it has players; try every choice of slots to leave open */
+        int need[4] = {};
+        for (int s = 0; s < LINEUP_STARTERS; ++s)
+            ++need[strchr(roles, f.role[s]) - roles];
+        int open = LINEUP_STARTERS - std::min<int>((int) available.size(), LINEUP_STARTERS);
+        search exhaustive(*player_data, available);
+        long long expected = -1;
+        int left[4];
+        for (left[0] = 0; left[0] <= need[0]; ++left[0])
+            for (left[1] = 0; left[1] <= need[1]; ++left[1])
+                for (left[2] = 0; left[2] <= need[2]; ++left[2]) {
+                    left[3] = open - left[0] - left[1] - left[2];
+                    if (left[3] < 0 || left[3] > need[3])
+                        continue;
+                    int fill[4] = {need[0] - left[0], need[1] - left[1], need[2] - left[2], need[3] - left[3]};
+                    expected = std::max(expected, exhaustive.best_weight(0, fill));
+                }
+
+        long long got = 0;
+        int filled = 0, strength = 0;
+        std::vector<int16_t> starters;
+        for (int s = 0; s < LINEUP_STARTERS; ++s) {
+            int16_t idx = result.starter[s];
+            if (idx < 0)
+                continue;
+            ++filled;
+            starters.push_back(idx);
+            got += weight(player_data->player[idx], f.role[s]);
+            strength += role_rating(player_data->player[idx], f.role[s]);
+            if (std::find(available.begin(), available.end(), idx) == available.end())
+                ++failures, printf("round %d: starter %d is not available\n", round, idx);
+        }
+        std::sort(starters.begin(), starters.end());
+        if (std::adjacent_find(starters.begin(), starters.end()) != starters.end())
+            ++failures, printf("round %d: a player starts twice\n", round);
+        if (filled != std::min<int>((int) available.size(), LINEUP_STARTERS))
+            ++failures, printf("round %d: %d starters of %zu available\n", round, filled, available.size());
+        if (got != expected)
+            ++failures, printf("round %d: weight %lld, best is %lld\n", round, got, expected);
+        if (strength != result.strength)
+            ++failures, printf("round %d: strength %d, starters sum to %d\n", round, result.strength, strength);
+    }
+
+    if (failures)
+        printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * The summary of the last match stays in every save until the next match,
+ * so saves archived turn by turn must count it once.
+ */
+#include <cstdio>
+
+#include "match.hh"
+
+int main() {
+    struct match_record record{};
+    record.match_type = 1;
+    record.audience = 20000;
+    record.club[0].club_idx = 3;
+    record.club[0].goals = 2;
+    record.club[1].club_idx = 10;
+    record.club[1].goals = 1;
+    for (int i = 0; i < 22; ++i) {
+        struct match_record::line &line = record.lineup[record.lineup_count++];
+        line.player_idx = (int16_t) (100 + i);
+        line.side = i / 11;
+        line.slot = i % 11;
+        line.passes_attempted = 10;
+    }
+    record.goal[record.goal_count++] = {100, 0, 600};
+    record.goal[record.goal_count++] = {101, 0, 1200};
+    record.goal[record.goal_count++] = {111, 1, 3000};
+
+    int failures = 0;
+    match_stats stats;
+    record.year = 1995;
+    record.turn = 60;
+    if (!stats.add(record))
+        ++failures, printf("first summary not counted\n");
+    record.turn = 61;
+    if (stats.add(record))
+        ++failures, printf("the same summary in the save of the next turn counted again\n");
+    if (stats.matches() != 1 || stats.player.appearances[100] != 1 || stats.player.goals[100] != 1 ||
+        stats.club.played[3] != 1 || stats.club.passes_attempted[10] != 110)
+        ++failures, printf("%zu matches, %d appearances, %d goals\n", stats.matches(),
+                           stats.player.appearances[100], stats.player.goals[100]);
+
+    /* The next match between the same clubs, with the same score, is another match */
+    record.turn = 90;
+    record.audience = 21000;
+    if (!stats.add(record) || stats.matches() != 2)
+        ++failures, printf("the return match was not counted\n");
+
+    if (failures)
+        printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}
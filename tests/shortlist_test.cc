@@ -0,0 +1,157 @@
+/*
+ * Cross-checks plan_signings against trying every affordable set of free
+ * agents that fits the squad, on small random markets and on a market where
+ * the best set skips the best value for money.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "shortlist.hh"
+
+#define SQUAD_SIZE 24
+#define MARKET_MAX 10
+
+struct fixture {
+    std::unique_ptr<struct gamea> game_data = std::make_unique<struct gamea>();
+    std::unique_ptr<struct gameb> club_data = std::make_unique<struct gameb>();
+    std::unique_ptr<struct gamec> player_data = std::make_unique<struct gamec>();
+    std::vector<int16_t> squad;     // of club 0
+    std::vector<int16_t> market;    // out of contract at club 1
+
+    struct gamec::player &add(std::vector<int16_t> &to, int club_idx) {
+        int16_t idx = (int16_t) (squad.size() + market.size());
+        club_data->club[club_idx].player_index[to.size()] = idx;
+        to.push_back(idx);
+        struct gamec::player &p = player_data->player[idx];
+        memset(&p, 0, sizeof(p));
+        return p;
+    }
+
+    struct gamec::player &sign(uint8_t hn, uint8_t tk, uint8_t ps, uint8_t sh) {
+        struct gamec::player &p = add(squad, 0);
+        p.hn = hn, p.tk = tk, p.ps = ps, p.sh = sh;
+        p.contract = 2;
+        return p;
+    }
+
+    struct gamec::player &offer(uint8_t hn, uint8_t tk, uint8_t ps, uint8_t sh, uint16_t wage) {
+        struct gamec::player &p = add(market, 1);
+        p.hn = hn, p.tk = tk, p.ps = ps, p.sh = sh;
+        p.wage = wage;
+        return p;
+    }
+
+    fixture() {
+        for (int i = 0; i < SQUAD_SIZE; ++i)
+            club_data->club[0].player_index[i] = club_data->club[1].player_index[i] = -1;
+        club_data->club[1].league = 1;
+        /* The empty transfer market lists player 0, who is in the squad */
+        for (auto &listing : game_data->transfer_market)
+            listing.player_idx = -1;
+    }
+
+    /* Strongest lineup of the squad with any affordable set of at most slots signings */
+    int exhaustive(const struct formation &f, int64_t budget) const {
+        int slots = SQUAD_SIZE - (int) squad.size(), best = 0;
+        for (unsigned set = 0; set < (1u << market.size()); ++set) {
+            std::vector<int16_t> pool(squad);
+            int64_t cost = 0;
+            for (size_t i = 0; i < market.size(); ++i) {
+                if (set & (1u << i)) {
+                    pool.push_back(market[i]);
+                    cost += player_data->player[market[i]].wage;
+                }
+            }
+            if (cost > budget || (int) (pool.size() - squad.size()) > slots)
+                continue;
+            struct lineup l{};
+            pick_lineup(pool.data(), (int) pool.size(), f, l, *player_data);
+            best = std::max(best, l.strength);
+        }
+        return best;
+    }
+
+    struct shortlist plan(const struct formation &f, int64_t budget) const {
+        struct shortlist_options options{};
+        options.budget = budget;
+        options.wage_weeks = 1;
+        options.node_limit = UINT64_MAX;
+        return plan_signings(0, f, options, *game_data, *club_data, *player_data);
+    }
+};
+
+static int check(const char *name, const struct fixture &fx, const struct formation &f, int64_t budget) {
+    struct shortlist s = fx.plan(f, budget);
+    int expected = fx.exhaustive(f, budget), failures = 0;
+
+    int64_t cost = 0;
+    for (const struct transfer_candidate &c : s.signings)
+        cost += c.cost;
+    if (s.strength_after != expected)
+        ++failures, printf("%s: strength %d, best is %d\n", name, s.strength_after, expected);
+    if (cost != s.cost || cost > budget)
+        ++failures, printf("%s: signings cost %lld of %lld, reported %lld\n", name,
+                           (long long) cost, (long long) budget, (long long) s.cost);
+    if ((int) s.signings.size() > SQUAD_SIZE - (int) fx.squad.size())
+        ++failures, printf("%s: %zu signings\n", name, s.signings.size());
+    if (!s.optimal)
+        ++failures, printf("%s: search stopped early\n", name);
+    return failures;
+}
+
+int main() {
+    struct formation f;
+    parse_formation("4-4-2", f);
+    int failures = 0;
+
+    /*
+     * Two free slots and 110 to spend on D (gain 25, cost 50), X (10, 21),
+     * C (30, 70) and E (25, 59), which is their order of value for money.
+     * D and E are best with 50; the two best value signings only make 35.
+     */
+    {
+        struct fixture fx;
+        fx.sign(50, 0, 0, 0);
+        for (int i = 0; i < 4; ++i)
+            fx.sign(0, 50, 0, 0);
+        for (int i = 0; i < 4; ++i)
+            fx.sign(0, 0, 50, 0);
+        for (int i = 0; i < 2; ++i)
+            fx.sign(0, 0, 0, 50);
+        while (fx.squad.size() < SQUAD_SIZE - 2)
+            fx.sign(1, 1, 1, 1);
+
+        fx.offer(0, 75, 0, 0, 50);   // D
+        fx.offer(0, 0, 60, 0, 21);   // X
+        fx.offer(0, 0, 0, 80, 70);   // C
+        fx.offer(75, 0, 0, 0, 59);   // E
+
+        struct shortlist s = fx.plan(f, 110);
+        if (s.strength_after - s.strength_before != 50 || s.signings.size() != 2)
+            ++failures, printf("value for money: gained %d with %zu signings, D and E gain 50\n",
+                               s.strength_after - s.strength_before, s.signings.size());
+        failures += check("value for money", fx, f, 110);
+    }
+
+    std::mt19937 rng(36);
+    for (int round = 0; round < 200; ++round) {
+        struct fixture fx;
+        int slots = (int) (rng() % 4) + 1;
+        while (fx.squad.size() < (size_t) (SQUAD_SIZE - slots))
+            fx.sign(rng() % 60, rng() % 60, rng() % 60, rng() % 60);
+        int market = (int) (rng() % MARKET_MAX) + 1;
+        for (int i = 0; i < market; ++i)
+            fx.offer(rng() % 100, rng() % 100, rng() % 100, rng() % 100, (uint16_t) (rng() % 100));
+
+        char name[32];
+        snprintf(name, sizeof(name), "round %d", round);
+        failures += check(name, fx, f, (int64_t) (rng() % 250));
+    }
+
+    if (failures)
+        printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}